@@ -26,4 +26,12 @@ void init();
  */
 void signal_end_of_interrupt(::interrupts::Id interrupt);
 
+/**
+ * Let an interrupt through to the processor. Interrupts of the slave
+ * controller also need the cascade line of the master unmasked.
+ *
+ * @param interrupt The interrupt to unmask.
+ */
+void unmask(::interrupts::Id interrupt);
+
 }  // namespace drivers::interrupts::pic8259
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 
 /**
@@ -62,14 +63,29 @@ enum class Port : uint16_t {
     SECONDARY_ATA_ALTERNATE_STATUS_OR_DEVICE_CONTROL = 0x376,
     // Provides drive select and head select information.
     SECONDARY_ATA_DRIVE_ADDRESS,
+
+    // Selects the PCI configuration register that the data port accesses.
+    PCI_CONFIG_ADDRESS = 0xCF8,
+    // Reads/Writes the selected PCI configuration register.
+    PCI_CONFIG_DATA = 0xCFC,
 };
 
 }  // namespace drivers::io
 
 extern "C" uint8_t insb(drivers::io::Port port);
 extern "C" uint16_t insw(drivers::io::Port port);
+extern "C" uint32_t insd(drivers::io::Port port);
 extern "C" void outb(drivers::io::Port port, uint8_t value);
 extern "C" void outw(drivers::io::Port port, uint16_t value);
+extern "C" void outd(drivers::io::Port port, uint32_t value);
+extern "C" void rep_insw(drivers::io::Port port, uint16_t* buffer,
+                         size_t count);
+extern "C" void rep_insd(drivers::io::Port port, uint32_t* buffer,
+                         size_t count);
+extern "C" void rep_outsw(drivers::io::Port port, const uint16_t* buffer,
+                          size_t count);
+extern "C" void rep_outsd(drivers::io::Port port, const uint32_t* buffer,
+                          size_t count);
 
 namespace drivers::io {
 
@@ -91,6 +107,15 @@ namespace drivers::io {
     return insw(port);
 }
 
+/**
+ * Read a double word (4 bytes) from the given port.
+ * @param port The port to read from.
+ * @return The value read from the port.
+ */
+[[nodiscard]] inline uint32_t read_dword(Port port) {
+    return insd(port);
+}
+
 /**
  * Write a single byte to the given port.
  * @param port The port to write to.
@@ -109,6 +134,59 @@ inline void write_word(Port port, uint16_t value) {
     outw(port, value);
 }
 
+/**
+ * Write a double word (4 bytes) to the given port.
+ * @param port The port to write to.
+ * @param value The value to write to the port.
+ */
+inline void write_dword(Port port, uint32_t value) {
+    outd(port, value);
+}
+
+/**
+ * Read words (2 bytes each) from the given port into a buffer, with a single
+ * rep insw.
+ * @param port The port to read from.
+ * @param buffer The buffer to read into.
+ * @param count The amount of words to read.
+ */
+inline void read_words(Port port, uint16_t* buffer, size_t count) {
+    rep_insw(port, buffer, count);
+}
+
+/**
+ * Read double words (4 bytes each) from the given port into a buffer, with a
+ * single rep insd.
+ * @param port The port to read from.
+ * @param buffer The buffer to read into.
+ * @param count The amount of double words to read.
+ */
+inline void read_dwords(Port port, uint32_t* buffer, size_t count) {
+    rep_insd(port, buffer, count);
+}
+
+/**
+ * Write words (2 bytes each) from a buffer to the given port, with a single
+ * rep outsw.
+ * @param port The port to write to.
+ * @param buffer The buffer to write from.
+ * @param count The amount of words to write.
+ */
+inline void write_words(Port port, const uint16_t* buffer, size_t count) {
+    rep_outsw(port, buffer, count);
+}
+
+/**
+ * Write double words (4 bytes each) from a buffer to the given port, with a
+ * single rep outsd.
+ * @param port The port to write to.
+ * @param buffer The buffer to write from.
+ * @param count The amount of double words to write.
+ */
+inline void write_dwords(Port port, const uint32_t* buffer, size_t count) {
+    rep_outsd(port, buffer, count);
+}
+
 /**
  * Wait for a very short time.
  */
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "memory/allocation/allocator.hpp"
+#include "utilities/error.hpp"
+
+namespace drivers::pci {
+
+/**
+ * Enumerate the devices on the PCI buses, and hand them to the drivers that
+ * claim them. Configuration space is accessed through mechanism #1 - the
+ * address of a register is written to one port, and its value read from or
+ * written to another. See https://wiki.osdev.org/PCI for more info.
+ */
+
+constexpr size_t BAR_COUNT = 6;
+
+// Matches any vendor, device or class when registering a driver.
+constexpr uint16_t ANY_ID = 0xffff;
+constexpr uint8_t ANY_CLASS = 0xff;
+
+// Device classes drivers are usually registered for.
+enum class Class : uint8_t {
+    MASS_STORAGE = 0x01,
+    NETWORK = 0x02,
+    DISPLAY = 0x03,
+    BRIDGE = 0x06,
+};
+
+// Subclasses of the mass storage class.
+enum class StorageSubclass : uint8_t {
+    IDE = 0x01,
+    SATA = 0x06,
+    NVM = 0x08,
+};
+
+struct function_address {
+    uint8_t bus;
+    uint8_t device;
+    uint8_t function;
+};
+
+// A base address register - a range of memory or IO ports the device
+// decodes.
+struct bar {
+    uint32_t base;
+    // Zero if the register is unused.
+    uint32_t bytes;
+    bool is_io;
+    bool is_prefetchable;
+};
+
+struct device {
+    function_address address;
+    uint16_t vendor_id;
+    uint16_t device_id;
+    uint8_t class_code;
+    uint8_t subclass;
+    uint8_t programming_interface;
+    uint8_t revision;
+    bar bars[BAR_COUNT];
+    // The PIC line the firmware routed the interrupt to, and the pin (INTA#
+    // to INTD#, or 0 for none) the device raises it on.
+    uint8_t interrupt_line;
+    uint8_t interrupt_pin;
+};
+
+struct device_table {
+    device* _devices;
+    size_t _count;
+    // The table is taken from this allocator.
+    allocator* _allocator;
+};
+
+struct driver {
+    // Devices are matched by their IDs, by their class, or both. Fields set
+    // to ANY_ID and ANY_CLASS match every device.
+    uint16_t vendor_id;
+    uint16_t device_id;
+    uint8_t class_code;
+    uint8_t subclass;
+    // Called for each matching device. An error is logged, and the remaining
+    // devices are still probed.
+    error (*probe)(const device* device, void* context);
+    void* context;
+};
+
+/**
+ * Read a register of a device's configuration space.
+ *
+ * @param address The device.
+ * @param offset The offset of the register. Must be a multiple of 4.
+ * @return The value of the register.
+ */
+[[nodiscard]] uint32_t read_config(const function_address& address,
+                                   uint8_t offset);
+
+/**
+ * Write a register of a device's configuration space.
+ *
+ * @param address The device.
+ * @param offset The offset of the register. Must be a multiple of 4.
+ * @param value The value to write.
+ */
+void write_config(const function_address& address, uint8_t offset,
+                  uint32_t value);
+
+/**
+ * Scan all buses for devices. Also sizes the BARs, which briefly disables
+ * the decoding of each device.
+ *
+ * @param allocator The allocator the table is taken from.
+ * @return The table of devices, or an error if it couldn't be allocated.
+ */
+[[nodiscard]] with_error<device_table> scan(allocator* allocator);
+
+/**
+ * Free the table of devices.
+ *
+ * @param table The table.
+ * @return An error if the table couldn't be freed.
+ */
+error destroy(device_table* table);
+
+/**
+ * Get the amount of devices in a table.
+ *
+ * @param table The table.
+ * @return The amount of devices.
+ */
+[[nodiscard]] size_t get_count(const device_table* table);
+
+/**
+ * Get a device of a table.
+ *
+ * @param table The table.
+ * @param index The index of the device. Must be less than the count.
+ * @return The device.
+ */
+[[nodiscard]] const device* get_device(const device_table* table,
+                                       size_t index);
+
+/**
+ * Find the first device that a driver would be probed with.
+ *
+ * @param table The table.
+ * @param driver The driver. Its probe is not called.
+ * @return The device, or nullptr if none matches.
+ */
+[[nodiscard]] const device* find(const device_table* table,
+                                 const driver& driver);
+
+/**
+ * Register a driver, probing it with each matching device.
+ *
+ * @param table The table of devices.
+ * @param driver The driver.
+ * @return The amount of devices the driver was probed with.
+ */
+size_t register_driver(const device_table* table, const driver& driver);
+
+/**
+ * Let a device access memory on its own, for DMA.
+ *
+ * @param address The device.
+ */
+void enable_bus_mastering(const function_address& address);
+
+}  // namespace drivers::pci
@@ -3,6 +3,10 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "drivers/pci/pci.hpp"
+#include "memory/allocation/allocator.hpp"
+#include "utilities/error.hpp"
+
 namespace drivers::storage::ata {
 
 /**
@@ -19,7 +23,19 @@ enum class Bus { PRIMARY, SECONDARY };
 enum class Port : uint8_t { MASTER = 0xE0, SLAVE = 0xF0 };
 
 // ATA supports different modes for accessing disk data.
-enum class Mode { PIO };
+enum class Mode {
+    // The processor polls the drive until each sector is ready.
+    PIO,
+    // The drive raises IRQ14 when each sector is ready, and the processor
+    // halts in between. Only the primary bus, and only reads - anything else
+    // falls back to polling.
+    PIO_INTERRUPTS,
+    // The IDE controller moves sectors to or from memory on its own, and the
+    // drive raises IRQ14 once all of them moved. Falls back to polling for
+    // completion where the interrupt can't be waited for, and to PIO when
+    // there is no bus master controller.
+    DMA,
+};
 
 struct disk {
     Bus bus;
@@ -30,10 +46,156 @@ struct disk {
 constexpr size_t SECTOR_SIZE_IN_BYTES = 512;
 using sector = uint8_t[SECTOR_SIZE_IN_BYTES];
 
-void read_sectors(disk* disk, sector* buffer, size_t offset, size_t amount);
+/**
+ * Check whether an ATA drive answers at a disk's bus and port, by having it
+ * identify itself. ATAPI drives, such as CD drives, don't count.
+ *
+ * @param disk The disk.
+ * @return True iff the drive is present.
+ */
+[[nodiscard]] bool is_present(disk* disk);
+
+/**
+ * Read sectors in the disk's mode.
+ *
+ * @param disk The disk.
+ * @param buffer The buffer.
+ * @param offset The first sector.
+ * @param amount The amount of sectors. 256 at most.
+ * @return An error if the drive or the controller reported one. The buffer
+ * may then hold part of the sectors.
+ */
+[[nodiscard]] error read_sectors(disk* disk, sector* buffer, size_t offset,
+                                 size_t amount);
+
+/**
+ * Write sectors in the disk's mode.
+ *
+ * @param disk The disk.
+ * @param buffer The buffer.
+ * @param offset The first sector.
+ * @param amount The amount of sectors. 256 at most.
+ * @return An error if the drive or the controller reported one. Part of the
+ * sectors may then have been written.
+ */
+[[nodiscard]] error write_sectors(disk* disk, const sector* buffer,
+                                  size_t offset, size_t amount);
+
+/**
+ * Let the drive acknowledge writes once they are in its cache, rather than
+ * on the medium. Writes are then only durable after a flush.
+ *
+ * @param disk The disk.
+ * @param enabled Whether to enable or disable the cache.
+ * @return An error if the drive rejected the feature.
+ */
+[[nodiscard]] error set_write_cache(disk* disk, bool enabled);
+
+/**
+ * Write the sectors in the drive's cache to the medium, so that all writes
+ * made so far are durable. Callers can batch writes, and only flush at the
+ * points that need durability.
+ *
+ * @param disk The disk.
+ * @return An error if the drive failed to write the cache.
+ */
+[[nodiscard]] error flush(disk* disk);
+
+/**
+ * Handle IRQ14 for all modes.
+ */
+void handle_interrupt();
+
+/**
+ * Get the amount of clock cycles spent halted, waiting for the drive.
+ * Telling them apart from the time a transfer takes gives the processor time
+ * it used.
+ *
+ * @return The cycles halted since boot.
+ */
+[[nodiscard]] uint64_t get_idle_cycles();
 
 namespace pio {
-void read_sectors(disk* disk, sector* buffer, size_t offset, size_t amount);
-}
+[[nodiscard]] error read_sectors(disk* disk, sector* buffer, size_t offset,
+                                 size_t amount);
+[[nodiscard]] error write_sectors(disk* disk, const sector* buffer,
+                                  size_t offset, size_t amount);
+
+/**
+ * Read sectors like read_sectors(), but with an in instruction per word
+ * instead of a single rep insw per sector. Only kept to measure the
+ * difference.
+ */
+[[nodiscard]] error read_sectors_by_word(disk* disk, sector* buffer,
+                                         size_t offset, size_t amount);
+
+/**
+ * Let the drives of the primary bus raise IRQ14. Must be called after the
+ * interrupts are initialized.
+ */
+void init_interrupts();
+
+/**
+ * Read sectors, moving each one from the IRQ14 handler once it is ready.
+ * Polls instead when interrupts are disabled, since the handler couldn't run.
+ */
+[[nodiscard]] error read_sectors_with_interrupts(disk* disk, sector* buffer,
+                                                 size_t offset, size_t amount);
+
+/**
+ * Acknowledge IRQ14, and move a sector of the pending read.
+ */
+void handle_interrupt();
+}  // namespace pio
+
+namespace dma {
+/**
+ * Find the bus master IDE controller, and set up the descriptor table
+ * transfers are described to it with.
+ *
+ * @param devices The PCI devices.
+ * @param allocator The allocator the descriptor table is taken from. Its
+ * memory must stay mapped.
+ * @return An error if the table couldn't be allocated. Finding no controller
+ * isn't an error - DMA transfers then fall back to PIO.
+ */
+error init(const pci::device_table* devices, allocator* allocator);
+
+/**
+ * Check whether a bus master controller was found.
+ *
+ * @return True iff transfers use DMA.
+ */
+[[nodiscard]] bool is_available();
+
+/**
+ * Read sectors straight into memory.
+ *
+ * @param disk The disk.
+ * @param buffer The buffer. Must be mapped in the loaded address space.
+ * @param offset The first sector.
+ * @param amount The amount of sectors. 256 at most.
+ * @return An error if the drive or the controller reported one.
+ */
+[[nodiscard]] error read_sectors(disk* disk, sector* buffer, size_t offset,
+                                 size_t amount);
+
+/**
+ * Write sectors straight from memory.
+ *
+ * @param disk The disk.
+ * @param buffer The buffer. Must be mapped in the loaded address space.
+ * @param offset The first sector.
+ * @param amount The amount of sectors. 256 at most.
+ * @return An error if the drive or the controller reported one.
+ */
+[[nodiscard]] error write_sectors(disk* disk, const sector* buffer,
+                                  size_t offset, size_t amount);
+
+/**
+ * Check whether the pending transfer finished, on IRQ14.
+ */
+void handle_interrupt();
+}  // namespace dma
 
 }  // namespace drivers::storage::ata
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "drivers/io/ports.hpp"
+#include "drivers/storage/ata.hpp"
+#include "utilities/error.hpp"
+
+namespace drivers::storage::ata {
+
+/**
+ * The task file registers of the ATA buses, shared by the transfer modes.
+ * Only the drivers of the modes should use these.
+ */
+
+enum class Command : uint8_t {
+    READ = 0x20,
+    WRITE = 0x30,
+    READ_DMA = 0xc8,
+    WRITE_DMA = 0xca,
+    FLUSH_CACHE = 0xe7,
+    IDENTIFY = 0xec,
+    SET_FEATURES = 0xef,
+};
+
+// Bits of the status register.
+constexpr uint8_t STATUS_ERROR = 0x01;
+constexpr uint8_t STATUS_DATA_AVAILABLE = 0x08;
+constexpr uint8_t STATUS_DRIVE_FAULT = 0x20;
+constexpr uint8_t STATUS_BUSY = 0x80;
+
+struct registers {
+    io::Port data;
+    io::Port features_or_error;
+    io::Port selector_count;
+    io::Port selector_number_or_lba_low;
+    io::Port cylinder_low_or_lba_mid;
+    io::Port cylinder_high_or_lba_high;
+    io::Port drive_or_head;
+    io::Port status_or_command;
+    io::Port alternate_status_or_device_control;
+    io::Port drive_address;
+};
+
+[[nodiscard]] const registers& get_registers_by_bus(Bus bus);
+
+/**
+ * Select the sectors of a disk and start a command on them.
+ *
+ * @param registers The registers of the disk's bus.
+ * @param port The port of the disk.
+ * @param command The command.
+ * @param offset The first sector.
+ * @param amount The amount of sectors. 256 at most.
+ */
+void send_command(const registers& registers, Port port, Command command,
+                  size_t offset, size_t amount);
+
+/**
+ * Select a disk and start a command that transfers no data.
+ *
+ * @param registers The registers of the disk's bus.
+ * @param port The port of the disk.
+ * @param command The command.
+ * @param features The value of the features register, for commands that
+ * take one.
+ */
+void send_command(const registers& registers, Port port, Command command,
+                  uint8_t features);
+
+/**
+ * Read the status register, which also acknowledges the drive's interrupt.
+ *
+ * @param registers The registers of the bus.
+ * @return The status.
+ */
+[[nodiscard]] uint8_t read_status(const registers& registers);
+
+/**
+ * Wait until the drive has a sector ready to move, or failed the command.
+ *
+ * @param registers The registers of the bus.
+ * @return An error if the drive failed the command, which then moves no more
+ * sectors.
+ */
+[[nodiscard]] error wait_for_buffer_to_be_ready(const registers& registers);
+
+void wait_until_not_busy(const registers& registers);
+
+/**
+ * Check a status for the error bits.
+ *
+ * @param status The status register.
+ * @return An error if the drive reported an error or a drive fault.
+ */
+[[nodiscard]] error check_status(uint8_t status);
+
+/**
+ * Halt until an interrupt is handled, counting the time as idle. Must be
+ * called with interrupts disabled.
+ */
+void halt_until_interrupt();
+
+}  // namespace drivers::storage::ata
@@ -12,6 +12,7 @@ void init();
 // The number used with the int instruction
 enum class Id : uint8_t {
     DIVIDE_BY_ZERO,
+    PAGE_FAULT = 14,
     PIC_TIMER = drivers::interrupts::pic8259::MASTER_OFFSET,
     PIC_KEYBOARD,
     PIC_CASCADE,
@@ -1,4 +1,34 @@
 #pragma once
 
+#include <stdint.h>
+
 #define DISABLE_INTERRUPTS() __asm__("cli;")
 #define ENABLE_INTERRUPTS() __asm__("sti;")
+
+namespace interrupts {
+
+/**
+ * Check whether the processor accepts maskable interrupts. They are disabled
+ * while handling interrupts, for example.
+ * @return True iff the interrupt flag is set.
+ */
+[[nodiscard]] inline bool are_enabled() {
+    constexpr uint32_t INTERRUPT_FLAG = 1 << 9;
+
+    uint32_t flags = 0;
+    __asm__ volatile("pushfl; popl %0;" : "=r"(flags));
+
+    return (flags & INTERRUPT_FLAG) != 0;
+}
+
+/**
+ * Halt until the next interrupt is handled. Must be called with interrupts
+ * disabled, and returns with them disabled. Since sti only takes effect after
+ * the following instruction, an interrupt that arrives before halting still
+ * wakes the processor, so a condition checked beforehand isn't missed.
+ */
+inline void wait_for_interrupt() {
+    __asm__ volatile("sti; hlt; cli;");
+}
+
+}  // namespace interrupts
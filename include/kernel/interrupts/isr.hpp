@@ -6,7 +6,14 @@
 // the wrappers.
 #define INTERRUPT_DECLARATION(NAME) extern "C" void isr_##NAME##_wrapper()
 
+// Declares an interrupt method for an exception that pushes an error code. The
+// C function gets the error code as its only argument, and the wrapper pops it
+// before returning.
+#define INTERRUPT_WITH_ERROR_CODE_DECLARATION(NAME) \
+    extern "C" void isr_##NAME##_error_code_wrapper()
+
 INTERRUPT_DECLARATION(divide_by_zero);
+INTERRUPT_WITH_ERROR_CODE_DECLARATION(page_fault);
 
 // Programmable interrupt controller interrupts
 INTERRUPT_DECLARATION(pic_timer);
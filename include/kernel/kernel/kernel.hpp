@@ -1,13 +1,27 @@
 #pragma once
 
+#include "drivers/pci/pci.hpp"
 #include "drivers/storage/ata.hpp"
 #include "memory/paging/paging.hpp"
 
 struct kernel {
+    // Page aligned, identity mapped frames, such as for demand paged regions.
+    allocator* frames;
     allocator* heap;
+    // Memory for structures that live as long as the kernel, such as the
+    // kernel's page tables. Nothing allocated from it is freed individually.
+    allocator* arena;
+    // Large buffers that only need to be contiguous in virtual memory, such
+    // as disk caches. Unlike the heap, they keep fitting when physical memory
+    // is fragmented.
+    allocator* virtual_heap;
     drivers::storage::ata::disk boot_disk;
+    // Holds pages that were evicted to make room for others.
+    drivers::storage::ata::disk swap_disk;
     memory::paging::paging kernel_paging;
+    drivers::pci::device_table pci_devices;
 };
 
-with_error<kernel> make(allocator* heap);
+with_error<kernel> make(allocator* frames, allocator* heap, allocator* arena,
+                        allocator* virtual_heap);
 error destroy(kernel* kernel);
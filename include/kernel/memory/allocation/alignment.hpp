@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "utilities/error.hpp"
+
+namespace memory::allocation {
+
+/**
+ * Check whether a value is a power of two.
+ *
+ * @param value The value to check.
+ * @return True iff the value is a power of two.
+ */
+[[nodiscard]] bool is_power_of_two(size_t value);
+
+/**
+ * Round a value up to a multiple of an alignment.
+ *
+ * @param value The value to round.
+ * @param alignment The alignment. Must be a power of two.
+ * @return The smallest multiple of the alignment that is not smaller than the
+ * value.
+ */
+[[nodiscard]] size_t align_up(size_t value, size_t alignment);
+
+/**
+ * Check whether an address is aligned.
+ *
+ * @param address The address to check.
+ * @param alignment The alignment. Must be a power of two.
+ * @return True iff the address is a multiple of the alignment.
+ */
+[[nodiscard]] bool is_aligned(const void *address, size_t alignment);
+
+// Describes which blocks of a block based heap start at an aligned address.
+// These are the blocks at offsets `first + stride * i`.
+struct block_alignment {
+    size_t first;
+    size_t stride;
+};
+
+/**
+ * Find the blocks of a block based heap that start at an aligned address.
+ *
+ * @param start The address of the first block.
+ * @param block_size The size of each block in bytes. Must be a power of two.
+ * @param alignment The required alignment. Must be a power of two.
+ * @return The aligned blocks, or an error if no block is aligned.
+ */
+[[nodiscard]] with_error<block_alignment> get_block_alignment(
+    const uint8_t *start, size_t block_size, size_t alignment);
+
+}  // namespace memory::allocation
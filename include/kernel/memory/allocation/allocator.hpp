@@ -11,11 +11,39 @@ namespace memory::allocation {
 
 using MallocType = with_error<void *> (*)(void *self, size_t size);
 using FreeType = error (*)(void *self, const void *allocation);
+using AlignedMallocType = with_error<void *> (*)(void *self, size_t size,
+                                                 size_t alignment);
+using SizedFreeType = error (*)(void *self, const void *allocation,
+                                size_t size);
+using GrowInPlaceType = error (*)(void *self, const void *allocation,
+                                  size_t size, size_t new_size);
+
+// A snapshot of how much of an allocator's memory is in use.
+struct usage {
+    size_t used_bytes;
+    size_t free_bytes;
+    // The largest allocation that can currently succeed.
+    size_t largest_free_bytes;
+    // The amount of separate free regions.
+    size_t free_extents;
+};
+
+using GetSizeType = with_error<size_t> (*)(void *self, const void *allocation);
+using GetUsageType = usage (*)(void *self);
 
 struct allocator {
     void *self;
     MallocType _malloc;
     FreeType _free;
+
+    // Optional operations. Allocators that don't implement them leave them as
+    // nullptr, in which case a generic fallback is used or the operation
+    // fails.
+    AlignedMallocType _aligned_malloc;
+    SizedFreeType _sized_free;
+    GrowInPlaceType _grow_in_place;
+    GetSizeType _get_size;
+    GetUsageType _get_usage;
 };
 
 void *malloc(allocator *self, size_t size);
@@ -23,6 +51,101 @@ with_error<void *> try_malloc(allocator *self, size_t size);
 void free(allocator *self, const void *allocation);
 error try_free(allocator *self, const void *allocation);
 
+/**
+ * Allocate memory at an address that is a multiple of the given alignment.
+ * Allocators that don't support alignment fail unless a regular allocation
+ * happens to be aligned.
+ *
+ * @param self The allocator.
+ * @param size The size of the allocation in bytes.
+ * @param alignment The required alignment. Must be a power of two.
+ * @return The allocation.
+ */
+void *aligned_malloc(allocator *self, size_t size, size_t alignment);
+with_error<void *> try_aligned_malloc(allocator *self, size_t size,
+                                      size_t alignment);
+
+/**
+ * Free an allocation whose size is known to the caller. This spares the
+ * allocator from looking the size up.
+ *
+ * @param self The allocator.
+ * @param allocation The allocation to free.
+ * @param size The size that was requested when allocating.
+ */
+void free(allocator *self, const void *allocation, size_t size);
+error try_free(allocator *self, const void *allocation, size_t size);
+
+/**
+ * Try to extend an allocation without moving it. Allocators may also shrink
+ * it, freeing what is past its new end, so it can then be freed with the new
+ * size.
+ *
+ * @param self The allocator.
+ * @param allocation The allocation to extend.
+ * @param size The size that was requested when allocating.
+ * @param new_size The requested size.
+ * @return An error if the allocation can't be extended where it is. The
+ * allocation is left untouched in that case.
+ */
+error try_grow_in_place(allocator *self, const void *allocation, size_t size,
+                        size_t new_size);
+
+/**
+ * Resize an allocation. The allocation is extended in place if possible, and
+ * moved to a new allocation otherwise.
+ *
+ * @param self The allocator.
+ * @param allocation The allocation to resize.
+ * @param size The size that was requested when allocating.
+ * @param new_size The requested size.
+ * @return The resized allocation. On error the original allocation is left
+ * untouched.
+ */
+void *realloc(allocator *self, void *allocation, size_t size, size_t new_size);
+with_error<void *> try_realloc(allocator *self, void *allocation, size_t size,
+                               size_t new_size);
+
+/**
+ * Get the usable size of an allocation, which may be larger than the size
+ * that was requested.
+ *
+ * @param self The allocator.
+ * @param allocation The allocation.
+ * @return The size of the allocation in bytes.
+ */
+with_error<size_t> try_get_size(allocator *self, const void *allocation);
+
+/**
+ * Get the current usage of an allocator. This may walk the allocator's
+ * metadata, so it is meant for diagnostics rather than hot paths.
+ *
+ * @param self The allocator.
+ * @return The usage.
+ */
+with_error<usage> try_get_usage(allocator *self);
+
+/**
+ * Get the fragmentation index of a usage snapshot - the percentage of free
+ * memory that can't be handed out as a single allocation. 0 means all free
+ * memory is contiguous.
+ *
+ * @param usage The usage.
+ * @return The fragmentation index, between 0 and 100.
+ */
+[[nodiscard]] size_t get_fragmentation(const usage &usage);
+
+/**
+ * Get the address the current allocation request was made from. The
+ * allocation functions above record their return address before calling into
+ * the allocator, so that allocators that wrap others can attribute requests
+ * to call sites. Requests an allocator makes to its own backing allocator
+ * overwrite it, so it must be read before forwarding a request.
+ *
+ * @return The return address of the most recent allocation function call.
+ */
+[[nodiscard]] const void *get_call_site();
+
 }  // namespace memory::allocation
 
 using memory::allocation::allocator;
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <type_traits>
+
+#include "memory/allocation/allocator.hpp"
+#include "utilities/error.hpp"
+
+namespace memory::allocation::arena {
+
+/**
+ * A bump allocator layered over another allocator.
+ *
+ * Memory is handed out from large chunks taken from the backing allocator by
+ * advancing a pointer. Freeing a single allocation does nothing, unless it is
+ * the most recent allocation, which is rolled back. Everything is released at
+ * once by resetting the arena, rewinding it to a marker, or destroying it.
+ *
+ * This makes it a good fit for structures that live and die together, such as
+ * the tables of an address space, and for scratch memory of a single
+ * operation.
+ */
+
+// Alignment of allocations that don't ask for a specific one.
+constexpr size_t DEFAULT_ALIGNMENT = 8;
+
+// Chunks are linked from the newest to the oldest. Allocations follow the
+// header.
+struct chunk {
+    chunk *previous;
+    uint8_t *top;
+    uint8_t *end;
+};
+
+struct arena {
+    with_error<void *> (*malloc)(arena *self, size_t size);
+    error (*free)(arena *self, const void *allocation);
+
+    ::memory::allocation::allocator *_backing;
+    size_t _chunk_size;
+    chunk *_current;
+};
+
+// A position in the arena that it can be rewound to.
+struct marker {
+    chunk *current;
+    uint8_t *top;
+};
+
+/**
+ * Create a new arena. No memory is taken from the backing allocator until the
+ * first allocation.
+ *
+ * @param backing The allocator chunks are taken from.
+ * @param chunk_size The size of each chunk in bytes. Larger allocations get a
+ * chunk of their own.
+ * @return A new arena.
+ */
+arena make_arena(::memory::allocation::allocator *backing, size_t chunk_size);
+
+::memory::allocation::allocator make_allocator(arena *arena);
+
+/**
+ * Get the current position of the arena.
+ *
+ * @param arena The arena.
+ * @return A marker that can be passed to rewind.
+ */
+[[nodiscard]] marker get_marker(const arena *arena);
+
+/**
+ * Release everything that was allocated since a marker was taken.
+ *
+ * @param arena The arena.
+ * @param marker A marker taken from this arena that wasn't rewound past.
+ * @return An error if returning a chunk to the backing allocator failed.
+ */
+error rewind(arena *arena, const marker &marker);
+
+/**
+ * Release all allocations. The oldest chunk is kept for reuse.
+ *
+ * @param arena The arena.
+ * @return An error if returning a chunk to the backing allocator failed.
+ */
+error reset(arena *arena);
+
+/**
+ * Release all allocations and return all chunks to the backing allocator.
+ *
+ * @param arena The arena.
+ * @return An error if returning a chunk to the backing allocator failed.
+ */
+error destroy(arena *arena);
+
+}  // namespace memory::allocation::arena
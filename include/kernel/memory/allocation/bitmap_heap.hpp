@@ -0,0 +1,97 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <type_traits>
+
+#include "memory/allocation/allocator.hpp"
+#include "utilities/error.hpp"
+
+namespace memory::allocation::bitmap_heap {
+
+/**
+ * A block heap that keeps its metadata in bitmaps instead of a byte per block.
+ * Searching for free blocks is done a word at a time, so fully used words are
+ * skipped with a single comparison.
+ */
+
+using bitmap_word = uint32_t;
+
+constexpr size_t BITS_PER_WORD = sizeof(bitmap_word) * 8;
+
+struct bitmap_heap {
+    with_error<void *> (*malloc)(bitmap_heap *self, size_t size);
+    error (*free)(bitmap_heap *self, const void *allocation);
+
+    uint8_t *_start;
+    // A set bit marks a block that is part of an allocation.
+    bitmap_word *_used;
+    // A set bit marks the first block of an allocation.
+    bitmap_word *_first;
+    // A set bit marks the last block of an allocation.
+    bitmap_word *_last;
+    size_t _block_size;
+    size_t _blocks;
+    size_t _used_blocks;
+};
+
+/**
+ * Get the size of the metadata required by a heap.
+ *
+ * @param blocks The amount of blocks in the heap.
+ * @return The amount of words the metadata occupies.
+ */
+[[nodiscard]] size_t metadata_words(size_t blocks);
+
+/**
+ * Create a new bitmap heap. The metadata is initialized by this function.
+ *
+ * @param start The address of the first block.
+ * @param metadata Memory for the heap bitmaps. Must be at least
+ * metadata_words(blocks) words long.
+ * @param block_size The size of each block in bytes.
+ * @param blocks The amount of blocks in the heap.
+ * @return A new heap.
+ */
+bitmap_heap make_bitmap_heap(uint8_t *start, bitmap_word *metadata,
+                             size_t block_size, size_t blocks);
+
+::memory::allocation::allocator make_allocator(bitmap_heap *heap);
+
+/**
+ * Mark blocks as used, so they are never handed out. Each block becomes an
+ * allocation of its own, so reserved blocks can later be freed one by one.
+ * Reserving blocks that are already reserved has no effect. Blocks past the
+ * end of the heap are ignored.
+ *
+ * @param heap The heap.
+ * @param offset The first block to reserve.
+ * @param blocks The amount of blocks to reserve.
+ */
+void reserve(bitmap_heap *heap, size_t offset, size_t blocks);
+
+/**
+ * Mark blocks as free. Meant for setting up a heap over memory with holes,
+ * and must not be used on blocks of allocations that span multiple blocks.
+ * Blocks past the end of the heap are ignored.
+ *
+ * @param heap The heap.
+ * @param offset The first block to unreserve.
+ * @param blocks The amount of blocks to unreserve.
+ */
+void unreserve(bitmap_heap *heap, size_t offset, size_t blocks);
+
+/**
+ * Check whether blocks are free.
+ *
+ * @param heap The heap.
+ * @param offset The first block to check.
+ * @param blocks The amount of blocks to check.
+ * @return True iff none of the blocks are used. Blocks past the end of the heap
+ * count as used.
+ */
+[[nodiscard]] bool is_free(const bitmap_heap *heap, size_t offset,
+                           size_t blocks);
+
+}  // namespace memory::allocation::bitmap_heap
@@ -20,6 +20,7 @@ struct block_heap {
     block_metadata *_block_table;
     size_t _block_size;
     size_t _blocks;
+    size_t _used_blocks;
 };
 
 block_heap make_block_heap(uint8_t *start, block_metadata *block_table,
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <type_traits>
+
+#include "memory/allocation/allocator.hpp"
+#include "utilities/error.hpp"
+
+namespace memory::allocation::buddy_heap {
+
+/**
+ * A binary buddy allocator. Memory is handed out in blocks of
+ * `block_size << order` bytes. Larger blocks are split in halves ("buddies")
+ * on allocation, and buddies are merged back together when both are free.
+ *
+ * Every block is aligned to its own size relative to the start of the heap,
+ * so as long as the start of the heap is aligned to the largest block size,
+ * an allocation of N bytes is aligned to N rounded up to a power of two.
+ */
+
+// Order 0 blocks are `block_size` bytes long. Order ORDERS - 1 blocks are
+// `block_size << (ORDERS - 1)` bytes long.
+constexpr size_t ORDERS = 16;
+
+// Describes the order 0 block at the same offset. Only the first block of
+// each free or allocated block holds information.
+typedef uint8_t block_metadata;
+
+// Free blocks are linked through their own memory.
+struct free_block {
+    free_block *previous;
+    free_block *next;
+};
+
+struct buddy_heap {
+    with_error<void *> (*malloc)(buddy_heap *self, size_t size);
+    error (*free)(buddy_heap *self, const void *allocation);
+
+    uint8_t *_start;
+    block_metadata *_block_table;
+    size_t _block_size;
+    size_t _blocks;
+    free_block *_free_lists[ORDERS];
+    size_t _free_counts[ORDERS];
+};
+
+/**
+ * Create a new buddy heap. The block table and the heap memory are both
+ * initialized by this function.
+ *
+ * @param start The address of the first block.
+ * @param block_table Memory for the block metadata. Must be `blocks` long.
+ * @param block_size The size of order 0 blocks in bytes. Must be a power of
+ * two that can hold a free_block.
+ * @param blocks The amount of order 0 blocks in the heap. Doesn't have to be a
+ * power of two.
+ * @return A new heap.
+ */
+buddy_heap make_buddy_heap(uint8_t *start, block_metadata *block_table,
+                           size_t block_size, size_t blocks);
+
+::memory::allocation::allocator make_allocator(buddy_heap *heap);
+
+/**
+ * Get the amount of free blocks of a given order. Many free low order blocks
+ * and few free high order blocks indicate fragmentation.
+ *
+ * @param heap The heap.
+ * @param order The order of the blocks.
+ * @return The amount of free blocks of the given order.
+ */
+[[nodiscard]] size_t free_blocks(const buddy_heap *heap, size_t order);
+
+}  // namespace memory::allocation::buddy_heap
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <type_traits>
+
+#include "memory/allocation/allocator.hpp"
+#include "utilities/error.hpp"
+#include "utilities/rbtree.hpp"
+
+namespace memory::allocation::extent_heap {
+
+/**
+ * A block heap that describes memory as extents - runs of blocks that are
+ * either entirely free or belong to a single allocation.
+ *
+ * Free extents are indexed by size for best-fit allocation, and all extents
+ * are indexed by address so that freeing an allocation can find it and merge
+ * it with its free neighbours. Both malloc and free are O(log n) in the
+ * number of extents.
+ */
+
+struct extent {
+    utilities::rbtree::node by_address;
+    utilities::rbtree::node by_size;
+    size_t offset;
+    size_t blocks;
+    bool free;
+    // Links descriptors that don't currently describe any extent.
+    extent *next_unused;
+};
+
+struct extent_heap {
+    with_error<void *> (*malloc)(extent_heap *self, size_t size);
+    error (*free)(extent_heap *self, const void *allocation);
+
+    uint8_t *_start;
+    size_t _block_size;
+    size_t _blocks;
+    // All extents, ordered by offset.
+    utilities::rbtree::tree _by_address;
+    // Free extents, ordered by size and then by offset.
+    utilities::rbtree::tree _by_size;
+    extent *_unused;
+};
+
+/**
+ * Create a new extent heap.
+ *
+ * @param start The address of the first block.
+ * @param extents Memory for extent descriptors. Since every extent holds at
+ * least one block, it must have room for `blocks` descriptors.
+ * @param block_size The size of each block in bytes.
+ * @param blocks The amount of blocks in the heap.
+ * @return A new heap.
+ */
+extent_heap make_extent_heap(uint8_t *start, extent *extents,
+                             size_t block_size, size_t blocks);
+
+::memory::allocation::allocator make_allocator(extent_heap *heap);
+
+}  // namespace memory::allocation::extent_heap
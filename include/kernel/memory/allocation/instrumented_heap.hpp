@@ -0,0 +1,86 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <type_traits>
+
+#include "memory/allocation/allocator.hpp"
+#include "utilities/error.hpp"
+
+namespace memory::allocation::instrumented_heap {
+
+/**
+ * An allocator that forwards every request to another allocator and keeps
+ * statistics about them.
+ *
+ * Counters are updated in O(1) per request, apart from the cost of the wrapped
+ * allocator. Live bytes count the requested sizes. Only frees without a size
+ * ask the wrapped allocator for the usable size, so they cost a size query and
+ * may count more than was requested. Usage and fragmentation of the wrapped
+ * allocator are only computed when dumping.
+ */
+
+// Latencies are bucketed by powers of two. Bucket i counts requests that took
+// between 2^i and 2^(i+1) - 1 cycles. The last bucket also counts everything
+// slower.
+constexpr size_t LATENCY_BUCKETS = 32;
+
+// The amount of distinct call sites that are tracked. Requests from call
+// sites beyond that are only counted in total.
+constexpr size_t CALL_SITES = 64;
+
+struct statistics {
+    size_t mallocs;
+    size_t failed_mallocs;
+    size_t frees;
+    size_t failed_frees;
+    size_t live_allocations;
+    size_t live_bytes;
+    // The highest value live_bytes reached.
+    size_t peak_bytes;
+    size_t malloc_cycles[LATENCY_BUCKETS];
+    size_t free_cycles[LATENCY_BUCKETS];
+};
+
+struct call_site {
+    // The return address of the allocation function. nullptr marks an unused
+    // entry.
+    const void *address;
+    size_t mallocs;
+    size_t bytes;
+};
+
+struct instrumented_heap {
+    with_error<void *> (*malloc)(instrumented_heap *self, size_t size);
+    error (*free)(instrumented_heap *self, const void *allocation);
+
+    ::memory::allocation::allocator *_inner;
+    statistics _statistics;
+    bool _track_call_sites;
+    call_site _call_sites[CALL_SITES];
+    size_t _untracked_mallocs;
+};
+
+/**
+ * Create a new instrumented heap.
+ *
+ * @param inner The allocator requests are forwarded to.
+ * @param track_call_sites Whether to count allocations per call site. This
+ * costs a hash table lookup per allocation.
+ * @return A new heap.
+ */
+instrumented_heap make_instrumented_heap(
+    ::memory::allocation::allocator *inner, bool track_call_sites);
+
+::memory::allocation::allocator make_allocator(instrumented_heap *heap);
+
+/**
+ * Log the statistics of the heap, the usage of the wrapped allocator and the
+ * busiest call sites.
+ *
+ * @param heap The heap.
+ */
+void dump(instrumented_heap *heap);
+
+}  // namespace memory::allocation::instrumented_heap
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <type_traits>
+
+#include "memory/allocation/allocator.hpp"
+#include "memory/allocation/bitmap_heap.hpp"
+#include "utilities/error.hpp"
+
+namespace memory::allocation::paged_heap {
+
+/**
+ * A page granular heap over a range of virtual memory that is backed by
+ * physical frames only as it fills up.
+ *
+ * The range is managed by a bitmap heap with a block per page. Only a prefix
+ * of the range is mapped - the blocks past it are reserved in the bitmap heap.
+ * When an allocation doesn't fit in the mapped prefix, frames are taken from
+ * the frame allocator and mapped after it through the loaded paging instance,
+ * and the allocation is retried. Optionally, free pages at the end of the
+ * prefix are unmapped and given back to the frame allocator.
+ *
+ * Nothing is mapped when the heap is created, so it can be created before
+ * paging is enabled as long as it is not used until then.
+ */
+
+struct paged_heap {
+    with_error<void *> (*malloc)(paged_heap *self, size_t size);
+    error (*free)(paged_heap *self, const void *allocation);
+
+    bitmap_heap::bitmap_heap _heap;
+    ::memory::allocation::allocator *_frames;
+    // The amount of blocks at the start of the range that are mapped.
+    size_t _mapped_blocks;
+    // The least amount of blocks mapped at once, which is also the amount of
+    // free blocks that are kept mapped when shrinking.
+    size_t _growth_blocks;
+    bool _shrink_on_free;
+};
+
+/**
+ * Get the size of the metadata required by a heap.
+ *
+ * @param bytes The size of the virtual memory range.
+ * @return The amount of words the metadata occupies.
+ */
+[[nodiscard]] size_t metadata_words(size_t bytes);
+
+/**
+ * Create a new paged heap.
+ *
+ * @param start The start of the virtual memory range. Must be page aligned.
+ * @param bytes The size of the range. Rounded down to a multiple of page size.
+ * @param metadata Memory for the heap bitmaps. Must be at least
+ * metadata_words(bytes) words long.
+ * @param frames The allocator physical frames are taken from. Must return
+ * page aligned allocations that are identity mapped.
+ * @param growth_bytes The least amount of memory to map when growing.
+ * @param shrink_on_free Whether to give free memory back to the frame
+ * allocator after every free.
+ * @return A new heap.
+ */
+paged_heap make_paged_heap(uint8_t *start, size_t bytes,
+                           bitmap_heap::bitmap_word *metadata,
+                           ::memory::allocation::allocator *frames,
+                           size_t growth_bytes, bool shrink_on_free);
+
+::memory::allocation::allocator make_allocator(paged_heap *heap);
+
+/**
+ * Unmap free pages at the end of the mapped part of the heap and give their
+ * frames back to the frame allocator. growth_bytes worth of free pages stay
+ * mapped, so that the next allocation doesn't have to map them again.
+ *
+ * @param heap The heap.
+ * @return An error if a page couldn't be unmapped or its frame freed.
+ */
+error shrink(paged_heap *heap);
+
+}  // namespace memory::allocation::paged_heap
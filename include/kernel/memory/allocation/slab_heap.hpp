@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <type_traits>
+
+#include "memory/allocation/allocator.hpp"
+#include "utilities/error.hpp"
+
+namespace memory::allocation::slab_heap {
+
+/**
+ * A small-object allocator layered over another allocator.
+ *
+ * Allocations of up to LARGEST_SIZE_CLASS bytes are rounded up to a power of
+ * two and carved out of slabs - single allocations of slab_size bytes taken
+ * from the backing allocator. Each slab starts with a header and holds
+ * objects of a single size class, linked into a free list. Larger allocations
+ * are passed to the backing allocator as is.
+ *
+ * The backing allocator must return allocations aligned to slab_size, which
+ * the block heaps do when slab_size is their block size. That way the slab of
+ * an object is found by rounding its address down, and allocations that are
+ * aligned to slab_size are known to belong to the backing allocator.
+ *
+ * Since objects are naturally aligned, the header takes up the space of one
+ * object. Slabs must therefore fit at least four objects of the largest size
+ * class, or the header would waste most of them.
+ */
+
+constexpr size_t SMALLEST_SIZE_CLASS = 8;
+constexpr size_t LARGEST_SIZE_CLASS = 1024;
+constexpr size_t SIZE_CLASSES = 8;
+// The amount of objects of the largest size class that slabs have room for,
+// including the one the header takes up.
+constexpr size_t MIN_LARGEST_OBJECTS_PER_SLAB = 4;
+
+struct slab {
+    slab *previous;
+    slab *next;
+    // Free objects, linked through their first word.
+    void *free_objects;
+    size_t used_objects;
+    size_t size_class;
+};
+
+struct cache {
+    size_t object_size;
+    size_t objects_per_slab;
+    // Objects start at an offset that is a multiple of their size, so every
+    // object is naturally aligned.
+    size_t first_object_offset;
+    // Slabs that have at least one free object.
+    slab *partial;
+    // Slabs that have no free objects.
+    slab *full;
+};
+
+struct slab_heap {
+    with_error<void *> (*malloc)(slab_heap *self, size_t size);
+    error (*free)(slab_heap *self, const void *allocation);
+
+    ::memory::allocation::allocator *_backing;
+    size_t _slab_size;
+    cache _caches[SIZE_CLASSES];
+};
+
+/**
+ * Create a new slab heap.
+ *
+ * @param backing The allocator slabs and large allocations are taken from.
+ * @param slab_size The size of each slab in bytes. Must be a power of two
+ * that is at least MIN_LARGEST_OBJECTS_PER_SLAB times LARGEST_SIZE_CLASS.
+ * @return A new heap.
+ */
+slab_heap make_slab_heap(::memory::allocation::allocator *backing,
+                         size_t slab_size);
+
+::memory::allocation::allocator make_allocator(slab_heap *heap);
+
+}  // namespace memory::allocation::slab_heap
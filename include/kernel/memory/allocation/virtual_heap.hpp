@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <type_traits>
+
+#include "memory/allocation/allocator.hpp"
+#include "memory/allocation/bitmap_heap.hpp"
+#include "utilities/error.hpp"
+
+namespace memory::allocation::virtual_heap {
+
+/**
+ * An allocator for large buffers that only need to be contiguous in virtual
+ * memory.
+ *
+ * Every allocation reserves a run of pages in a range of virtual memory, and
+ * backs it with an anonymous region of the loaded paging instance. Each page
+ * is mapped to a zeroed frame of its own when it is first accessed, wherever
+ * the frame allocator finds one, and may be reclaimed to swap under memory
+ * pressure. Freeing removes the region, which gives its frames and swap slots
+ * back right away. Large allocations therefore keep succeeding while
+ * physical memory is fragmented, and only take up frames for the pages that
+ * are used, at the cost of a page fault per page.
+ *
+ * The range must be in the heaps of memory::Layout. Their regions and page
+ * tables are shared by an instance and its clones, so an allocation can be
+ * accessed and freed whichever of them is loaded.
+ *
+ * The run of pages is tracked by a bitmap heap that only holds metadata. A
+ * guard page that is in no region follows every allocation, so overruns
+ * fault instead of corrupting the next allocation.
+ */
+
+struct virtual_heap {
+    with_error<void *> (*malloc)(virtual_heap *self, size_t size);
+    error (*free)(virtual_heap *self, const void *allocation);
+
+    // Pages of the virtual memory range. Its memory is never accessed.
+    bitmap_heap::bitmap_heap _pages;
+    ::memory::allocation::allocator *_frames;
+};
+
+/**
+ * Get the size of the metadata required by a heap.
+ *
+ * @param bytes The size of the virtual memory range.
+ * @return The amount of words the metadata occupies.
+ */
+[[nodiscard]] size_t metadata_words(size_t bytes);
+
+/**
+ * Create a new virtual heap. Allocating from it requires paging to be loaded.
+ *
+ * @param start The start of the virtual memory range. Must be page aligned.
+ * The range must be in the heaps.
+ * @param bytes The size of the range. Rounded down to a multiple of page size.
+ * @param metadata Memory for the heap bitmaps. Must be at least
+ * metadata_words(bytes) words long.
+ * @param frames The allocator physical frames are taken from. Must return
+ * page aligned allocations that are identity mapped.
+ * @return A new heap.
+ */
+virtual_heap make_virtual_heap(uint8_t *start, size_t bytes,
+                               bitmap_heap::bitmap_word *metadata,
+                               ::memory::allocation::allocator *frames);
+
+::memory::allocation::allocator make_allocator(virtual_heap *heap);
+
+}  // namespace memory::allocation::virtual_heap
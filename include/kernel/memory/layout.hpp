@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stddef.h>
+
 #include <cstddef>
 
 namespace memory {
@@ -7,11 +9,27 @@ namespace memory {
 /**
  * Describes the general layout of memory as viewed by the kernel.
  */
-enum class Layout {
-    KERNEL_HEAP_ENTRY_TABLE = 0x7e00,
+enum class Layout : size_t {
+    // The BIOS memory map collected by the bootloader.
+    MEMORY_MAP = 0x500,
+    // Metadata of the physical frame allocator.
+    FRAME_TABLE = 0x10000,
+    FRAME_TABLE_END = 0x80000,
     VIDEO = 0xb8000,
     KERNEL = 0x100000,
-    KERNEL_HEAP = 0x1000000
+    // The kernel stack grows down from here.
+    KERNEL_STACK = 0x200000,
+    // Virtual memory the kernel heap grows into. Only the used part of it is
+    // backed by frames.
+    KERNEL_HEAP = 0xc0000000,
+    KERNEL_HEAP_END = 0xd0000000,
+    // Virtual memory for large allocations that are mapped page by page.
+    VIRTUAL_HEAP = 0xd0000000,
+    VIRTUAL_HEAP_END = 0xe0000000,
+    // Virtual memory private to each address space. Clones share its pages
+    // copy on write, while the ranges above are the same in all of them.
+    PRIVATE = 0xe0000000,
+    PRIVATE_END = 0xf0000000,
 };
 
 }  // namespace memory
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "memory/paging/shared.hpp"
+
+namespace memory::paging {
+
+// The bits of a paging entry that select the cache policy of a page. Together
+// they index the page attribute table.
+struct cache_bits {
+    bool page_attribute;
+    bool cache_disabled;
+    bool write_through;
+};
+
+/**
+ * Program the page attribute table, so that every cache policy has an entry.
+ * Must be done before paging is enabled. Without a page attribute table, write
+ * combining falls back to uncached.
+ */
+void init_cache_policies();
+
+/**
+ * Get the paging entry bits that select a cache policy.
+ *
+ * @param policy The cache policy.
+ * @return The bits to set in the entry.
+ */
+[[nodiscard]] cache_bits get_cache_bits(CachePolicy policy);
+
+}  // namespace memory::paging
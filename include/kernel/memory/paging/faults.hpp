@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "memory/paging/paging.hpp"
+#include "memory/paging/regions.hpp"
+#include "utilities/error.hpp"
+
+namespace memory::paging {
+
+/**
+ * Add a region to a paging instance. Its pages are mapped on demand, so a
+ * large region only takes up frames for the pages that are accessed. Pages of
+ * the range that are mapped, such as those of the identity map, are unmapped
+ * first. Regions in the heaps are shared with clones of the instance and the
+ * instance they were cloned from.
+ *
+ * @param paging The paging instance.
+ * @param description The region. Its start and size must be multiples of
+ * page size. Frames of anonymous and file regions must be page aligned and
+ * identity mapped.
+ * @return An error if the region overlaps another, or is only partly in the
+ * heaps.
+ */
+[[nodiscard]] error add_region(paging* paging,
+                               const regions::region& description);
+
+/**
+ * Add a region at the lowest free range of a window of virtual memory, like
+ * add_region().
+ *
+ * @param paging The paging instance.
+ * @param lower The start of the window. Must be page aligned.
+ * @param upper The end of the window. The window must be either in the heaps
+ * or outside of them.
+ * @param description The region. Its start is ignored.
+ * @return The start of the region, or an error if it doesn't fit in the
+ * window.
+ */
+[[nodiscard]] with_error<const void*> allocate_region(
+    paging* paging, const void* lower, const void* upper,
+    const regions::region& description);
+
+/**
+ * Remove a region from a paging instance. Its pages that were accessed are
+ * unmapped, and the frames of anonymous and file regions are freed. The range
+ * stays unmapped.
+ *
+ * @param paging The paging instance.
+ * @param start The start of the region.
+ * @return An error if there is no region that starts at the address.
+ */
+[[nodiscard]] error remove_region(paging* paging, const void* start);
+
+/**
+ * Resolve a page fault of the loaded paging instance. Accessing a page of a
+ * region that isn't mapped yet maps it. Any other fault is fatal - it is
+ * logged and the processor is halted.
+ *
+ * @param error_code The error code the processor pushed for the fault.
+ */
+void handle_page_fault(uint32_t error_code);
+
+}  // namespace memory::paging
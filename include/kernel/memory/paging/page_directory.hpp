@@ -17,6 +17,10 @@ struct Flags {
     PriviledgeLevel priviledge_level;
     AccessType access_type;
     Present present;
+    // Only applies to large pages. Page tables are always write-back.
+    CachePolicy cache_policy;
+    // Only applies to large pages.
+    Global global;
 };
 
 /**
@@ -28,6 +32,51 @@ struct Flags {
  */
 [[nodiscard]] Entry make_entry(const PTE* table, const Flags& flags);
 
+/**
+ * Create a new PDE that maps a large page directly, without a page table.
+ * Page size extensions must be enabled for the entry to take effect.
+ *
+ * @param page_address The address of the page. Must be a multiple of
+ * LARGE_PAGE_SIZE_IN_BYTES.
+ * @param flags The PDE flags.
+ * @return A new entry.
+ */
+[[nodiscard]] Entry make_large_entry(const void* page_address,
+                                     const Flags& flags);
+
+/**
+ * Check whether the entry maps a large page rather than a page table.
+ *
+ * @param entry The PDE.
+ * @return True iff the entry maps a large page.
+ */
+[[nodiscard]] bool is_large(Entry entry);
+
+/**
+ * Get the address of the large page mapped by this entry.
+ *
+ * @param entry The PDE. Must map a large page.
+ * @return The address of the large page.
+ */
+[[nodiscard]] const void* get_large_page_address(Entry entry);
+
+/**
+ * Get the bits that select the cache policy of the large page mapped by this
+ * entry.
+ *
+ * @param entry The PDE. Must map a large page.
+ * @return The cache bits.
+ */
+[[nodiscard]] cache_bits get_large_cache_bits(Entry entry);
+
+/**
+ * Check whether the large page mapped by this entry is global.
+ *
+ * @param entry The PDE. Must map a large page.
+ * @return The global bit of the entry.
+ */
+[[nodiscard]] Global get_large_global(Entry entry);
+
 /**
  * Get the address of the page table pointed to by this entry.
  *
@@ -3,6 +3,7 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "memory/paging/cache.hpp"
 #include "memory/paging/shared.hpp"
 
 namespace memory::paging::table {
@@ -14,6 +15,8 @@ struct Flags {
     PriviledgeLevel priviledge_level;
     AccessType access_type;
     Present present;
+    CachePolicy cache_policy;
+    Global global;
 };
 
 /**
@@ -42,6 +45,30 @@ struct Flags {
  */
 void set_page_address(Entry* entry, const void* address);
 
+/**
+ * Get the bits that select the cache policy of the page.
+ *
+ * @param entry The PTE.
+ * @return The cache bits.
+ */
+[[nodiscard]] cache_bits get_cache_bits(Entry entry);
+
+/**
+ * Set the bits that select the cache policy of the page.
+ *
+ * @param entry The PTE.
+ * @param bits The cache bits.
+ */
+void set_cache_bits(Entry* entry, const cache_bits& bits);
+
+/**
+ * Make the page global or local.
+ *
+ * @param entry The PTE.
+ * @param global Whether the page is global.
+ */
+void set_global(Entry* entry, Global global);
+
 /**
  * Check whether the page was written to.
  *
@@ -50,6 +77,13 @@ void set_page_address(Entry* entry, const void* address);
  */
 [[nodiscard]] bool is_dirty(Entry entry);
 
+/**
+ * Mark the page as written to.
+ *
+ * @param entry The PTE.
+ */
+void mark_dirty(Entry* entry);
+
 /**
  * Check whether the page was accessed.
  *
@@ -109,6 +143,73 @@ void enable_writing(Entry* entry);
  */
 void disable_writing(Entry* entry);
 
+/**
+ * Check whether the page is shared with another address space until it is
+ * written to. Such pages are read only, and writing to them copies them.
+ *
+ * @param entry The PTE.
+ * @return True iff the page is copy on write.
+ */
+[[nodiscard]] bool is_copy_on_write(Entry entry);
+
+/**
+ * Mark the page as copy on write, which makes it read only. Whether it was
+ * writeable is kept until the mark is cleared. Does nothing if the page is
+ * already copy on write.
+ *
+ * @param entry The PTE.
+ */
+void mark_copy_on_write(Entry* entry);
+
+/**
+ * Mark the page as private to its address space. It becomes writeable again
+ * if it was before it was marked.
+ *
+ * @param entry The PTE.
+ */
+void clear_copy_on_write(Entry* entry);
+
+/**
+ * Check whether a copy on write page may be written to once it is copied.
+ *
+ * @param entry The PTE.
+ * @return True iff writing to the page copies it, rather than being a
+ * violation of its rights.
+ */
+[[nodiscard]] bool is_writeable_when_copied(Entry entry);
+
+/**
+ * Set whether a copy on write page may be written to once it is copied.
+ *
+ * @param entry The PTE.
+ * @param writeable Whether the page may be written to.
+ */
+void set_writeable_when_copied(Entry* entry, bool writeable);
+
+/**
+ * Create a non-present PTE for a page whose contents are in swap.
+ *
+ * @param slot The swap slot that holds the page.
+ * @return A new entry.
+ */
+[[nodiscard]] Entry make_swapped_entry(size_t slot);
+
+/**
+ * Check whether the page was evicted to swap.
+ *
+ * @param entry The PTE.
+ * @return True iff the page is not present and its contents are in swap.
+ */
+[[nodiscard]] bool is_swapped(Entry entry);
+
+/**
+ * Get the swap slot that holds an evicted page.
+ *
+ * @param entry The PTE. Must be swapped.
+ * @return The slot.
+ */
+[[nodiscard]] size_t get_swap_slot(Entry entry);
+
 /**
  * Check whether the page is present in memory.
  *
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "memory/allocation/allocator.hpp"
+#include "memory/paging/cache.hpp"
 #include "memory/paging/page_directory.hpp"
 #include "memory/paging/page_table.hpp"
 #include "memory/paging/shared.hpp"
@@ -11,25 +12,234 @@ namespace memory::paging {
 struct flags {
     PriviledgeLevel priviledge_level;
     AccessType access_type;
+    CachePolicy cache_policy;
+    Global global;
 };
 
+namespace regions {
+struct region_tree;
+}  // namespace regions
+
+/**
+ * An address space. The last directory entry points back at the directory,
+ * so while the instance is loaded and paging is enabled, its tables are
+ * reached at fixed virtual addresses in the last 4 MiB of the address space,
+ * wherever they are in physical memory. Instances that aren't loaded are
+ * reached through the identity map.
+ */
 struct paging {
     allocator* allocator_;
     directory::Entry* directory;
-    table::Entry** tables;
+    // Shared by all copies of the instance, like the paging structures.
+    regions::region_tree* regions;
+    // The regions of the heaps. Clones share them with the instance they
+    // were cloned from, like the tables that map the heaps.
+    regions::region_tree* kernel_regions;
+    // Clones point at the heap tables and regions of the instance they were
+    // cloned from, which frees them.
+    bool is_clone;
 };
 
+/**
+ * Create a paging instance that identity maps the whole address space, except
+ * for the last 4 MiB that hold the self map, and the ranges of the heaps and
+ * of private memory in memory::Layout, which map their own pages. The tables
+ * of the heaps are allocated up front, so clones can share them.
+ *
+ * @param allocator The allocator paging structures are taken from.
+ * @param directory_flags The flags of directory entries that point to tables.
+ * @param table_flags The flags of the mapped pages.
+ * @param large_pages Whether to map the address space with large pages, so no
+ * page tables are needed. Large pages must be enabled before loading the
+ * instance. Mapping a page inside a large page replaces it with a table.
+ * @return A new instance.
+ */
 with_error<paging> make(allocator* allocator,
                         const directory::Flags& directory_flags,
-                        const table::Flags& table_flags);
+                        const table::Flags& table_flags, bool large_pages);
+
+/**
+ * Create a paging instance that maps nothing. Page tables are allocated when
+ * map() first touches their part of the address space, except for those of
+ * the heaps, which are allocated up front like in make().
+ *
+ * @param allocator The allocator paging structures are taken from.
+ * @return A new instance.
+ */
+with_error<paging> make_empty(allocator* allocator);
 
+/**
+ * Destroy a paging instance. The pages of its regions are released like in
+ * remove_region(), so frames and swap slots it shares with other instances
+ * stay allocated until they are released too. Regions of the heaps are only
+ * removed if the instance isn't a clone.
+ *
+ * @param paging The instance. Its clones must be destroyed first.
+ * @return The first error that occurred. Everything else is still released.
+ */
 error destroy(paging* paging);
 
+/**
+ * Clone a paging instance. Only page tables and region descriptors are
+ * copied, so cloning costs O(page tables) instead of O(resident memory).
+ *
+ * Pages of regions that own their frames are shared copy on write - they are
+ * made read only and local in both instances, and the first write to one of
+ * them gives it a copy of its own, if the page was writeable. The tables of
+ * the heaps aren't copied but shared, so their pages stay the same in both
+ * instances. So are the regions of the heaps, so heap allocations can be
+ * accessed and freed from either instance. Any other page, such as those of
+ * the identity map and of devices, is shared as it is. Frame references must
+ * be initialized.
+ *
+ * @param parent The instance to clone. Its TLB entries are flushed if it is
+ * loaded. Must outlive the clone.
+ * @return The new instance. If cloning failed, it must still be destroyed,
+ * which releases only what the clone took.
+ */
+[[nodiscard]] with_error<paging> clone(paging* parent);
+
+/**
+ * Give a copy on write page a frame of its own, or keep its frame if no other
+ * address space shares it anymore, and make it writeable.
+ *
+ * @param paging The paging instance.
+ * @param virtual_address The address of the page.
+ * @param frames The allocator the copy is taken from.
+ * @return An error if the page isn't copy on write, was read only when it
+ * was shared, or the copy couldn't be allocated.
+ */
+[[nodiscard]] error copy_on_write(paging* paging, const void* virtual_address,
+                                  allocator* frames);
+
+/**
+ * Map a page. The page table is allocated if there is none yet.
+ *
+ * @param paging The paging instance.
+ * @param virtual_address The address of the page.
+ * @param physical_address The address of the frame to map it to.
+ * @param flags The access rights of the page.
+ * @return An error if the page table couldn't be allocated.
+ */
 [[nodiscard]] error map(paging* paging, const void* virtual_address,
                         const void* physical_address, const flags& flags);
 
 /**
- * Enable paging in the processor.
+ * Map a range of pages to a contiguous range of frames. The TLB is updated
+ * once for the whole range - page by page for small ranges, and with a full
+ * flush for large ones.
+ *
+ * @param paging The paging instance.
+ * @param virtual_address The address of the first page.
+ * @param physical_address The address of the first frame.
+ * @param bytes The size of the range. Rounded up to a multiple of page size.
+ * @param flags The access rights of the pages.
+ * @return An error if a page table couldn't be allocated. Pages mapped
+ * before the error stay mapped.
+ */
+[[nodiscard]] error map_range(paging* paging, const void* virtual_address,
+                              const void* physical_address, size_t bytes,
+                              const flags& flags);
+
+/**
+ * Remove the mapping of a page, so accessing it faults. The page table is
+ * released once it maps nothing.
+ *
+ * @param paging The paging instance.
+ * @param virtual_address The address of the page.
+ * @return The physical address the page was mapped to.
+ */
+[[nodiscard]] with_error<const void*> unmap(paging* paging,
+                                            const void* virtual_address);
+
+/**
+ * Remove the mappings of a range of pages. Page tables are released once they
+ * map nothing, and the TLB is updated like in map_range().
+ *
+ * @param paging The paging instance.
+ * @param virtual_address The address of the first page.
+ * @param bytes The size of the range. Rounded up to a multiple of page size.
+ * @return An error if a page in the range isn't mapped. Pages before it are
+ * unmapped.
+ */
+[[nodiscard]] error unmap_range(paging* paging, const void* virtual_address,
+                                size_t bytes);
+
+/**
+ * Change the access rights and cache policy of mapped pages, keeping the
+ * frames they are mapped to. The TLB is updated like in map_range(). Copy on
+ * write pages stay read only, and get the new rights once they are copied.
+ *
+ * @param paging The paging instance.
+ * @param virtual_address The address of the first page.
+ * @param bytes The size of the range. Rounded up to a multiple of page size.
+ * @param flags The new access rights of the pages.
+ * @return An error if a page in the range isn't mapped. Pages before it are
+ * changed.
+ */
+[[nodiscard]] error protect(paging* paging, const void* virtual_address,
+                            size_t bytes, const flags& flags);
+
+/**
+ * Get the entry of a page, whether it is mapped or not. Changes to it take
+ * effect once the page is invalidated.
+ *
+ * @param paging The paging instance.
+ * @param virtual_address An address in the page.
+ * @return The entry, or nullptr if the page has no table, or is part of a
+ * large page.
+ */
+[[nodiscard]] table::Entry* get_entry(paging* paging,
+                                      const void* virtual_address);
+
+/**
+ * Get the tree a range of virtual memory keeps its regions in. Regions of the
+ * heaps are kept apart from the others, since clones share them.
+ *
+ * @param paging The paging instance.
+ * @param start The start of the range.
+ * @param bytes The size of the range. Must not be 0.
+ * @return The tree, or nullptr if the range is only partly in the heaps.
+ */
+[[nodiscard]] regions::region_tree* get_region_tree(const paging* paging,
+                                                    const void* start,
+                                                    size_t bytes);
+
+/**
+ * Drop the TLB entries of a range of pages, so changes to their entries take
+ * effect. Does nothing unless the instance is loaded.
+ *
+ * @param paging The paging instance.
+ * @param virtual_address The address of the first page.
+ * @param pages The amount of pages.
+ */
+void invalidate(const paging* paging, const void* virtual_address,
+                size_t pages);
+
+/**
+ * Check whether a page is mapped.
+ *
+ * @param paging The paging instance.
+ * @param virtual_address An address in the page.
+ * @return True iff the page is mapped, by a large page or a page table.
+ */
+[[nodiscard]] bool is_mapped(const paging* paging,
+                             const void* virtual_address);
+
+/**
+ * Translate a virtual address to the physical address it is mapped to, such
+ * as for handing a buffer to a device.
+ *
+ * @param paging The paging instance.
+ * @param virtual_address The address.
+ * @return The physical address, or an error if the page isn't mapped.
+ */
+[[nodiscard]] with_error<const void*> get_physical_address(
+    const paging* paging, const void* virtual_address);
+
+/**
+ * Enable paging in the processor. Writes to read only pages fault in the
+ * kernel as well, so copy on write pages are copied whoever writes them.
  * WARNING: A page directory must be loaded before enabling paging. Otherwise
  * the system will panic.
  */
@@ -37,10 +247,42 @@ void enable();
 
 void disable();
 
+/**
+ * Check whether the processor supports large pages.
+ * @return True iff large pages are supported.
+ */
+[[nodiscard]] bool supports_large_pages();
+
+/**
+ * Enable large pages in the processor. Must be done before loading an
+ * instance that uses them.
+ */
+void enable_large();
+
+/**
+ * Check whether the processor supports global pages.
+ * @return True iff global pages are supported.
+ */
+[[nodiscard]] bool supports_global_pages();
+
+/**
+ * Enable global pages in the processor. Until then the global bit of entries
+ * is ignored.
+ */
+void enable_global();
+
 /**
  * Make the paging mechanism use the given paging instance.
  * @param instance The paging instance to use.
  */
 void load(const paging instance);
 
+/**
+ * Get the paging instance that was last loaded. Changes made through it
+ * affect the running address space.
+ *
+ * @return The loaded instance, or nullptr if none was loaded.
+ */
+[[nodiscard]] paging* get_loaded();
+
 }  // namespace memory::paging
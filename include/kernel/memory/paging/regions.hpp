@@ -0,0 +1,145 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cstddef>
+
+#include "drivers/storage/ata.hpp"
+#include "memory/allocation/allocator.hpp"
+#include "memory/paging/paging.hpp"
+#include "utilities/error.hpp"
+#include "utilities/rbtree.hpp"
+
+namespace memory::paging::regions {
+
+/**
+ * The regions of an address space - ranges of virtual memory along with what
+ * their pages hold. Regions are kept in a tree ordered by address, so finding
+ * the region of an address is O(log n) in the amount of regions.
+ */
+
+// What backs the pages of a region.
+enum class Type : uint8_t {
+    // Frames filled with zeros when pages are first accessed.
+    ANONYMOUS,
+    // Sectors of a disk, read into frames when pages are first accessed.
+    // Pages are private copies - writes don't reach the disk.
+    FILE,
+    // Device memory at a fixed physical address, mapped when pages are first
+    // accessed.
+    MMIO,
+    // Never mapped, so accessing it always faults.
+    GUARD,
+};
+
+struct region {
+    utilities::rbtree::node node;
+    const std::byte* start;
+    size_t bytes;
+    Type type;
+    flags page_flags;
+    // The allocator frames of anonymous and file regions are taken from.
+    allocator* frames;
+    // The disk of a file region, and the sector its first page is read from.
+    drivers::storage::ata::disk* disk;
+    size_t first_sector;
+    // The physical address an MMIO region starts at.
+    const void* physical_address;
+};
+
+struct region_tree {
+    // Regions ordered by start address. They never overlap.
+    utilities::rbtree::tree _regions;
+    // Region descriptors are taken from this allocator.
+    allocator* _allocator;
+};
+
+/**
+ * Create an empty tree.
+ *
+ * @param allocator The allocator region descriptors are taken from.
+ * @return A new tree.
+ */
+[[nodiscard]] region_tree make_region_tree(allocator* allocator);
+
+/**
+ * Free the descriptors of all regions. Their pages are left as they are.
+ *
+ * @param tree The tree.
+ * @return An error if a descriptor couldn't be freed.
+ */
+error destroy(region_tree* tree);
+
+/**
+ * Add a region to the tree.
+ *
+ * @param tree The tree.
+ * @param description The region to add. Its node is ignored.
+ * @return The descriptor of the new region, or an error if it overlaps
+ * another region or its descriptor couldn't be allocated.
+ */
+[[nodiscard]] with_error<region*> insert(region_tree* tree,
+                                         const region& description);
+
+/**
+ * Remove a region from the tree and free its descriptor.
+ *
+ * @param tree The tree.
+ * @param removed The region to remove. Must be in the tree.
+ * @return An error if the descriptor couldn't be freed.
+ */
+error erase(region_tree* tree, region* removed);
+
+/**
+ * Find the region that contains an address.
+ *
+ * @param tree The tree.
+ * @param address The address.
+ * @return The region, or nullptr if the address is in no region.
+ */
+[[nodiscard]] region* find(const region_tree* tree, const void* address);
+
+/**
+ * Get the region with the lowest address.
+ *
+ * @param tree The tree.
+ * @return The region, or nullptr if the tree is empty.
+ */
+[[nodiscard]] region* first(const region_tree* tree);
+
+/**
+ * Get the region that follows a region.
+ *
+ * @param region A region in a tree.
+ * @return The next region by address, or nullptr if this is the last one.
+ */
+[[nodiscard]] region* next(const region* region);
+
+/**
+ * Check whether the frames a region is mapped to belong to it, rather than
+ * being device memory.
+ *
+ * @param region The region.
+ * @return True iff the frames were taken from the region's allocator.
+ */
+[[nodiscard]] bool owns_frames(const region* region);
+
+/**
+ * Find the lowest range in a window of virtual memory that no region
+ * overlaps.
+ *
+ * @param tree The tree.
+ * @param lower The start of the window.
+ * @param upper The end of the window.
+ * @param bytes The size of the range.
+ * @param alignment The alignment of the range. Must be a power of two.
+ * @return The start of the range, or an error if no range fits.
+ */
+[[nodiscard]] with_error<const std::byte*> find_free(const region_tree* tree,
+                                                     const void* lower,
+                                                     const void* upper,
+                                                     size_t bytes,
+                                                     size_t alignment);
+
+}  // namespace memory::paging::regions
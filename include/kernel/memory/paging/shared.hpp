@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdint.h>
 
 namespace memory::paging {
 
@@ -9,6 +10,9 @@ constexpr size_t PAGE_TABLE_BITS = 10;
 constexpr size_t PAGE_DIRECTORY_BITS = 10;
 
 constexpr size_t PAGE_SIZE_IN_BYTES = 1 << PAGE_SIZE_BITS;
+// The size of a page mapped by a directory entry, without a page table.
+constexpr size_t LARGE_PAGE_SIZE_IN_BYTES = 1 << (PAGE_SIZE_BITS +
+                                                  PAGE_TABLE_BITS);
 
 // Whether usermode can access or only kernel.
 enum class PriviledgeLevel : bool { KERNEL = false, USER = true };
@@ -19,4 +23,19 @@ enum class AccessType : bool { READ_ONLY = false, READ_WRITE = true };
 // Whether the page is currently in memory.
 enum class Present : bool { FALSE = false, TRUE = true };
 
+// Whether the page is mapped the same in every address space. The TLB entries
+// of global pages survive switching address spaces.
+enum class Global : bool { FALSE = false, TRUE = true };
+
+// How the processor caches accesses to the page. Memory is write-back unless
+// it is a device's, such as video memory.
+enum class CachePolicy : uint8_t {
+    WRITE_BACK = 0,
+    WRITE_THROUGH,
+    UNCACHED,
+    // Writes are buffered and combined into bursts, and reads are uncached.
+    // Fits memory that is mostly written, like frame buffers.
+    WRITE_COMBINING,
+};
+
 }  // namespace memory::paging
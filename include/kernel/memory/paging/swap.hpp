@@ -0,0 +1,102 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cstddef>
+
+#include "drivers/storage/ata.hpp"
+#include "memory/allocation/allocator.hpp"
+#include "memory/paging/paging.hpp"
+#include "memory/paging/regions.hpp"
+#include "utilities/error.hpp"
+
+namespace memory::paging::swap {
+
+/**
+ * Page reclaim, so that regions can hold more pages than there are frames.
+ *
+ * Pages of regions that own their frames are scanned with the CLOCK
+ * algorithm - a hand sweeps over them in address order, and clears the
+ * accessed bit of each page it passes. A page that wasn't accessed since the
+ * hand last passed is evicted. Clean pages are dropped, since faulting them
+ * in again yields the same contents, and dirty pages are written to a swap
+ * slot on disk. The entry of a swapped page records its slot, so the page
+ * fault handler can read it back.
+ *
+ * Frames that are shared with other address spaces are never evicted.
+ */
+
+// Counts of the pages reclaim has moved since boot.
+struct statistics {
+    // Pages whose frames were given back, whether they were written to swap
+    // or dropped clean.
+    size_t evicted;
+    size_t swapped_out;
+    size_t swapped_in;
+};
+
+/**
+ * Set up swap on a range of sectors of a disk. Until then, only clean pages
+ * are reclaimed.
+ *
+ * @param disk The disk. Its transfers are polled, since pages are swapped
+ * from the page fault handler, where interrupts are disabled.
+ * @param first_sector The first sector of the swap area.
+ * @param slots The amount of pages the swap area holds.
+ * @param allocator The allocator the slot table is taken from.
+ * @return An error if the slot table couldn't be allocated.
+ */
+error init(const drivers::storage::ata::disk& disk, size_t first_sector,
+           size_t slots, allocator* allocator);
+
+/**
+ * Evict pages of a paging instance, giving their frames back to the
+ * allocators of their regions.
+ *
+ * @param paging The paging instance.
+ * @param pages The amount of pages to evict.
+ * @return The amount of pages that were evicted. Fewer than asked for if the
+ * rest are in use, shared, or dirty without room in swap or failed to be
+ * written to it.
+ */
+[[nodiscard]] size_t reclaim(paging* paging, size_t pages);
+
+/**
+ * Read a swapped page back into a frame, and map it.
+ *
+ * @param paging The paging instance.
+ * @param region The region of the page.
+ * @param page The address of the page. Must be swapped.
+ * @param frame The frame to read the page into.
+ * @return An error if the page isn't swapped, or couldn't be read or mapped.
+ * The page then stays swapped.
+ */
+[[nodiscard]] error swap_in(paging* paging, const regions::region* region,
+                            const std::byte* page, void* frame);
+
+/**
+ * Forget a swapped page, freeing its slot.
+ *
+ * @param paging The paging instance.
+ * @param page The address of the page. Nothing is done unless it is swapped.
+ */
+void discard(paging* paging, const std::byte* page);
+
+/**
+ * Get the counts of the pages reclaim moved, such as to tell how often it
+ * ran.
+ *
+ * @return The counts since boot.
+ */
+[[nodiscard]] statistics get_statistics();
+
+/**
+ * Add a reference to a slot, when an entry that refers to it is copied.
+ *
+ * @param slot The slot.
+ * @return An error if the slot has too many references.
+ */
+[[nodiscard]] error share_slot(size_t slot);
+
+}  // namespace memory::paging::swap
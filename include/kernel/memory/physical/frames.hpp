@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "memory/allocation/bitmap_heap.hpp"
+#include "memory/paging/shared.hpp"
+#include "memory/physical/memory_map.hpp"
+#include "utilities/error.hpp"
+
+namespace memory::physical {
+
+/**
+ * The physical frame allocator. Physical memory is managed as a bitmap heap
+ * whose blocks are page sized frames, starting at address 0. Frames that the
+ * memory map doesn't report as usable are reserved, as is everything below
+ * the top of the kernel stack.
+ *
+ * Since the heap is a regular bitmap heap, runs of contiguous frames and
+ * aligned runs can be allocated as well as single frames.
+ */
+
+constexpr size_t FRAME_SIZE = paging::PAGE_SIZE_IN_BYTES;
+
+// Memory from here on is left out. The top of the 32 bit address space is
+// mostly taken by devices anyway.
+constexpr uint64_t PHYSICAL_MEMORY_LIMIT = 0xc0000000;
+
+/**
+ * Create the frame allocator.
+ *
+ * @param map The memory map describing physical memory.
+ * @param metadata Memory for the heap bitmaps.
+ * @param metadata_words The size of the metadata in words. Memory beyond
+ * what it can describe is left out.
+ * @return The frame heap, or an error if there is no usable memory.
+ */
+with_error<allocation::bitmap_heap::bitmap_heap> make_frames(
+    const memory_map &map, allocation::bitmap_heap::bitmap_word *metadata,
+    size_t metadata_words);
+
+/**
+ * Reserve the frames that hold a range of physical memory.
+ *
+ * @param frames The frame heap.
+ * @param start The start of the range.
+ * @param bytes The size of the range in bytes.
+ */
+void reserve_range(allocation::bitmap_heap::bitmap_heap *frames,
+                   uint64_t start, uint64_t bytes);
+
+}  // namespace memory::physical
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace memory::physical {
+
+enum class RegionType : uint32_t {
+    USABLE = 1,
+    RESERVED = 2,
+    ACPI_RECLAIMABLE = 3,
+    ACPI_NVS = 4,
+    BAD = 5,
+};
+
+// Bit 0 of the extended attributes is cleared in entries that should be
+// ignored.
+constexpr uint32_t EXTENDED_ATTRIBUTE_VALID = 1 << 0;
+
+// An entry of the memory map, as returned by INT 15h, EAX=E820h. Entries may
+// overlap and are not sorted.
+struct __attribute__((packed)) memory_map_entry {
+    uint64_t base;
+    uint64_t length;
+    RegionType type;
+    uint32_t extended_attributes;
+};
+
+struct memory_map {
+    size_t count;
+    const memory_map_entry *entries;
+};
+
+/**
+ * Get the memory map the bootloader collected from the BIOS.
+ *
+ * @return The memory map.
+ */
+[[nodiscard]] memory_map get_memory_map();
+
+/**
+ * Check whether an entry describes memory the kernel may use.
+ *
+ * @param entry The entry.
+ * @return True iff the entry is valid and describes usable memory.
+ */
+[[nodiscard]] bool is_usable(const memory_map_entry &entry);
+
+/**
+ * Get the total amount of usable memory.
+ *
+ * @param map The memory map.
+ * @return The sum of the lengths of all usable entries, in KiB.
+ */
+[[nodiscard]] size_t get_usable_kilobytes(const memory_map &map);
+
+}  // namespace memory::physical
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "memory/allocation/allocator.hpp"
+#include "utilities/error.hpp"
+
+namespace memory::physical {
+
+/**
+ * Reference counts of frames that are mapped in more than one address space,
+ * such as the pages that are shared copy on write after cloning an address
+ * space.
+ *
+ * A frame that was never shared has a single owner and isn't counted, so only
+ * sharing has to go through this module - allocating and mapping frames
+ * doesn't.
+ */
+
+/**
+ * Allocate the reference counts. Must be done before any frame is shared.
+ *
+ * @param allocator The allocator the counts are taken from.
+ * @param frames The amount of frames, starting at address 0.
+ * @return An error if the counts couldn't be allocated.
+ */
+error init_references(allocator* allocator, size_t frames);
+
+/**
+ * Check whether the reference counts were allocated.
+ *
+ * @return True iff frames can be shared.
+ */
+[[nodiscard]] bool has_references();
+
+/**
+ * Add a reference to a frame.
+ *
+ * @param frame The address of the frame.
+ * @return An error if the frame is out of range, or has too many references.
+ */
+[[nodiscard]] error share_frame(const void* frame);
+
+/**
+ * Drop a reference to a frame.
+ *
+ * @param frame The address of the frame.
+ * @return True iff that was the last reference, in which case the caller
+ * should free the frame.
+ */
+[[nodiscard]] bool release_frame(const void* frame);
+
+/**
+ * Get the amount of references to a frame.
+ *
+ * @param frame The address of the frame.
+ * @return The amount of address spaces the frame is mapped in. At least 1.
+ */
+[[nodiscard]] size_t get_references(const void* frame);
+
+}  // namespace memory::physical
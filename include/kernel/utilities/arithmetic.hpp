@@ -0,0 +1,16 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace utilities {
+
+/**
+ * Divide 64 bit numbers. The kernel isn't linked against libgcc, so the
+ * compiler's own 64 bit division can't be used.
+ * @param dividend The number to divide.
+ * @param divisor The number to divide by, which must not be 0.
+ * @return The quotient, rounded down.
+ */
+[[nodiscard]] uint64_t divide(uint64_t dividend, uint64_t divisor);
+
+}  // namespace utilities
@@ -29,6 +29,15 @@ namespace utilities {
  */
 [[nodiscard]] uint32_t clear_flag(uint32_t value, size_t offset);
 
+/**
+ * Set the value of a bit flag in a given value.
+ * @param value The given value.
+ * @param offset The offset of the flag in the value.
+ * @param flag The value of the flag.
+ * @return The value after the change.
+ */
+[[nodiscard]] uint32_t set_flag(uint32_t value, size_t offset, bool flag);
+
 /**
  * Get the value of a bit field in a given value.
  * @param value The given value.
@@ -48,4 +57,18 @@ namespace utilities {
 [[nodiscard]] uint32_t set_field(uint32_t value, size_t msb, size_t lsb,
                                  uint32_t field_value);
 
+/**
+ * Count the zero bits below the least significant set bit of a value.
+ * @param value The given value. Must not be 0.
+ * @return The offset of the least significant set bit.
+ */
+[[nodiscard]] size_t count_trailing_zeros(uint32_t value);
+
+/**
+ * Count the zero bits above the most significant set bit of a value.
+ * @param value The given value. Must not be 0.
+ * @return 31 minus the offset of the most significant set bit.
+ */
+[[nodiscard]] size_t count_leading_zeros(uint32_t value);
+
 }  // namespace utilities
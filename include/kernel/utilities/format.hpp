@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace utilities {
+
+/**
+ * Building blocks for composing log lines out of strings and numbers. All
+ * functions append to a null terminated string in a buffer of a given size,
+ * and truncate the result if the buffer is too small.
+ */
+
+/**
+ * Append a string.
+ * @param buffer The buffer holding the null terminated string to append to.
+ * @param size The size of the buffer in bytes.
+ * @param string The string to append.
+ */
+void append(char *buffer, size_t size, const char *string);
+
+/**
+ * Append a number in decimal.
+ * @param buffer The buffer holding the null terminated string to append to.
+ * @param size The size of the buffer in bytes.
+ * @param value The number to append.
+ */
+void append_decimal(char *buffer, size_t size, uint32_t value);
+
+/**
+ * Append a 64 bit number in decimal, e.g. a cycle count.
+ * @param buffer The buffer holding the null terminated string to append to.
+ * @param size The size of the buffer in bytes.
+ * @param value The number to append.
+ */
+void append_decimal64(char *buffer, size_t size, uint64_t value);
+
+/**
+ * Append a number in hexadecimal, with a 0x prefix and padded to 8 digits.
+ * @param buffer The buffer holding the null terminated string to append to.
+ * @param size The size of the buffer in bytes.
+ * @param value The number to append.
+ */
+void append_hex(char *buffer, size_t size, uint32_t value);
+
+}  // namespace utilities
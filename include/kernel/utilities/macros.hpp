@@ -1,8 +1,19 @@
 #pragma once
 
+#include <stddef.h>
+
 /**
  * Allow stringifying macros such as __LINE__.
  * Due to the way macros work, two layers are required.
  */
 #define STRINGIZE(x) STRINGIZE2(x)
 #define STRINGIZE2(x) #x
+
+/**
+ * Get a pointer to the structure that contains the given member.
+ * Used with intrusive data structures, whose nodes are embedded in the
+ * structures they link.
+ */
+#define CONTAINER_OF(pointer, type, member)                    \
+    reinterpret_cast<type*>(reinterpret_cast<char*>(pointer) - \
+                            offsetof(type, member))
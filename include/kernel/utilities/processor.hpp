@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "utilities/bitranges.hpp"
+
+extern "C" uint32_t read_feature_flags();
+
+namespace utilities {
+
+/**
+ * Processor features, as bit offsets in the feature flags CPUID reports.
+ */
+enum class Feature : size_t {
+    // 4 MiB pages.
+    PAGE_SIZE_EXTENSION = 3,
+    // Pages whose TLB entries survive switching address spaces.
+    PAGE_GLOBAL_ENABLE = 13,
+    // Cache policies selected through the page attribute table.
+    PAGE_ATTRIBUTE_TABLE = 16,
+};
+
+/**
+ * Check whether the processor supports a feature.
+ * @param feature The feature.
+ * @return True iff the feature is supported.
+ */
+[[nodiscard]] inline bool has_feature(Feature feature) {
+    return get_flag(read_feature_flags(), static_cast<size_t>(feature));
+}
+
+}  // namespace utilities
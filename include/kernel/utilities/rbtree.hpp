@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stddef.h>
+
+/**
+ * An intrusive red-black tree. Nodes are embedded in the structures they
+ * order, and the containing structure is recovered with CONTAINER_OF.
+ *
+ * The tree doesn't know how nodes are ordered. To insert a node the caller
+ * walks down from the root, and passes the parent it stopped at together
+ * with the child link the new node should occupy. The tree then rebalances
+ * itself. This keeps comparisons inlined at the call site and lets a single
+ * structure be ordered by different keys in different trees.
+ */
+
+namespace utilities::rbtree {
+
+struct node {
+    node* parent;
+    node* left;
+    node* right;
+    bool red;
+};
+
+struct tree {
+    node* root;
+};
+
+/**
+ * Create an empty tree.
+ *
+ * @return A new tree.
+ */
+[[nodiscard]] tree make_tree();
+
+/**
+ * Insert a node into the tree and rebalance it.
+ *
+ * @param tree The tree to insert into.
+ * @param inserted The node to insert.
+ * @param parent The node under which the new node is placed, or nullptr if
+ * the tree is empty.
+ * @param link The empty child link of the parent (or the root link) that the
+ * node should occupy.
+ */
+void insert(tree* tree, node* inserted, node* parent, node** link);
+
+/**
+ * Remove a node from the tree and rebalance it.
+ *
+ * @param tree The tree to remove from.
+ * @param removed The node to remove. Must be in the tree.
+ */
+void erase(tree* tree, node* removed);
+
+/**
+ * Get the smallest node in the tree.
+ *
+ * @param tree The tree.
+ * @return The smallest node, or nullptr if the tree is empty.
+ */
+[[nodiscard]] node* first(const tree* tree);
+
+/**
+ * Get the largest node in the tree.
+ *
+ * @param tree The tree.
+ * @return The largest node, or nullptr if the tree is empty.
+ */
+[[nodiscard]] node* last(const tree* tree);
+
+/**
+ * Get the in-order successor of a node.
+ *
+ * @param node A node in a tree.
+ * @return The next node, or nullptr if this is the largest node.
+ */
+[[nodiscard]] node* next(const node* node);
+
+/**
+ * Get the in-order predecessor of a node.
+ *
+ * @param node A node in a tree.
+ * @return The previous node, or nullptr if this is the smallest node.
+ */
+[[nodiscard]] node* previous(const node* node);
+
+}  // namespace utilities::rbtree
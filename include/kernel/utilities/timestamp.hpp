@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdint.h>
+
+extern "C" uint64_t read_timestamp_counter();
+
+namespace utilities {
+
+/**
+ * Get the amount of clock cycles since the processor was reset. Meant for
+ * measuring short durations by subtracting two readings.
+ * @return The value of the time stamp counter.
+ */
+[[nodiscard]] inline uint64_t read_cycles() {
+    return read_timestamp_counter();
+}
+
+}  // namespace utilities
@@ -21,6 +21,14 @@ bpb_trampoline:
 KERNEL_CODE_SELECTOR equ gdt_code - gdt_start
 KERNEL_DATA_SELECTOR equ gdt_data - gdt_start
 
+; The BIOS memory map is passed to the kernel at this address, as a 32 bit
+; entry count followed by the entries. This must match memory::Layout.
+MEMORY_MAP equ 500h
+MEMORY_MAP_ENTRIES equ MEMORY_MAP + 4
+MEMORY_MAP_ENTRY_SIZE equ 24
+MEMORY_MAP_MAX_ENTRIES equ 128
+SMAP_SIGNATURE equ 534d4150h ; 'SMAP'
+
 start:
 .setup_segments_and_stack:
     cli ; Clear interrupts
@@ -34,6 +42,39 @@ start:
     ; Start stack where we are loaded
     mov sp, 7c00h
 
+; Collect the memory map with INT 15h, EAX=E820h while BIOS services are still
+; available. Each call returns one entry and sets EBX to the next one, or to 0
+; after the last.
+.detect_memory:
+    mov di, MEMORY_MAP_ENTRIES
+    xor ebx, ebx
+    xor bp, bp ; Entry count
+
+.next_memory_map_entry:
+    mov eax, 0e820h
+    mov edx, SMAP_SIGNATURE
+    mov ecx, MEMORY_MAP_ENTRY_SIZE
+    ; Mark the entry as valid for BIOSes that only return 20 bytes
+    mov dword [es:di + 20], 1
+    int 15h
+    jc .memory_map_done ; Carry is set past the last entry or on failure
+    cmp eax, SMAP_SIGNATURE
+    jne .memory_map_done
+
+    jcxz .skip_memory_map_entry ; Skip empty entries
+    inc bp
+    add di, MEMORY_MAP_ENTRY_SIZE
+
+.skip_memory_map_entry:
+    test ebx, ebx
+    jz .memory_map_done
+    cmp bp, MEMORY_MAP_MAX_ENTRIES
+    jb .next_memory_map_entry
+
+.memory_map_done:
+    mov [MEMORY_MAP], bp
+    mov word [MEMORY_MAP + 2], 0
+
 .enter_protected_mode:
     lgdt[gdt_descriptor] ; Load global descriptor table
 
@@ -77,14 +118,43 @@ gdt_descriptor:
 
 [BITS 32]
 
+; The size of the kernel is passed by the build, rounded up to whole sectors
+%ifndef KERNEL_SECTORS
+%error "KERNEL_SECTORS must be defined"
+%endif
+
+KERNEL_ADDRESS equ 100000h
+; The sector count register is 8 bits wide, and 0 means 256, so the kernel is
+; read in chunks of at most this many sectors
+MAX_SECTORS_PER_READ equ 255
+
 ; Load the kernel
 start32:
-    mov eax, 1 ; Sector 1
-    mov ecx, 100 ; 100 Sectors
-    mov edi, 100000h ; At address
+    mov eax, 1 ; The kernel starts at sector 1
+    mov ebx, KERNEL_SECTORS ; Sectors left to read
+    mov edi, KERNEL_ADDRESS ; At address
+
+.read_chunk:
+    mov ecx, ebx
+    cmp ecx, MAX_SECTORS_PER_READ
+    jbe .chunk_size_set
+    mov ecx, MAX_SECTORS_PER_READ
+
+.chunk_size_set:
+    ; EDI is advanced by the read, while the other registers are clobbered
+    push eax
+    push ebx
+    push ecx
     call ata_lba_read
+    pop ecx
+    pop ebx
+    pop eax
+
+    add eax, ecx
+    sub ebx, ecx
+    jnz .read_chunk
 
-    jmp KERNEL_CODE_SELECTOR:100000h
+    jmp KERNEL_CODE_SELECTOR:KERNEL_ADDRESS
 
 ; Read from disk
 ; ATA - the specification for disk interface (like in SATA)
@@ -94,6 +164,17 @@ start32:
 ; ECX - Sector amount
 ; EDI - Load to
 ata_lba_read:
+    push eax ; Backup the offset since al is used for the status
+
+    ; Busy wait until the drive is done with the previous read
+    mov dx, 1f7h
+.wait_until_not_busy:
+    in al, dx
+    test al, 80h
+    jnz .wait_until_not_busy
+
+    pop eax
+
     ; Override the uppermost nibble of the offset which is used to set LBA mode
     ; and the drive number (0 in this case)
     and eax, 0fffffffh
@@ -11,6 +11,7 @@ static void remap_slave();
 static void remap(drivers::io::Port command_port, drivers::io::Port data_port,
                   uint8_t idt_offest, uint8_t connection_information);
 [[nodiscard]] static Id get_controller(::interrupts::Id interrupt);
+static void clear_mask(io::Port data_port, uint8_t line);
 
 void init() {
     remap_master();
@@ -73,6 +74,32 @@ void signal_end_of_interrupt(::interrupts::Id interrupt) {
     }
 }
 
+void unmask(::interrupts::Id interrupt) {
+    constexpr uint8_t CASCADE_LINE = 2;
+
+    const Id controller = get_controller(interrupt);
+    const uint8_t interrupt_number = static_cast<uint8_t>(interrupt);
+
+    switch (controller) {
+        case Id::MASTER:
+            clear_mask(io::Port::MASTER_PIC_DATA,
+                       interrupt_number - MASTER_OFFSET);
+            return;
+        case Id::SLAVE:
+            clear_mask(io::Port::SLAVE_PIC_DATA,
+                       interrupt_number - SLAVE_OFFSET);
+            clear_mask(io::Port::MASTER_PIC_DATA, CASCADE_LINE);
+            return;
+        case Id::NONE:
+            return;
+    }
+}
+
+void clear_mask(io::Port data_port, uint8_t line) {
+    // The data port holds the mask of each line while not initializing.
+    io::write_byte(data_port, io::read_byte(data_port) & ~(1 << line));
+}
+
 Id get_controller(::interrupts::Id interrupt) {
     constexpr uint8_t INTERRUPTS_PER_CONTROLLER = 8;
 
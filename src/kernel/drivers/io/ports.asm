@@ -24,6 +24,17 @@ insw:
     pop ebp
     ret
 
+global insd
+insd:
+    push ebp
+    mov ebp, esp
+
+    mov edx, [ebp + 8]
+    in eax, dx
+
+    pop ebp
+    ret
+
 global outb
 outb:
     push ebp
@@ -47,3 +58,78 @@ outw:
 
     pop ebp
     ret
+
+global outd
+outd:
+    push ebp
+    mov ebp, esp
+
+    mov eax, [ebp + 12]
+    mov edx, [ebp + 8]
+    out dx, eax
+
+    pop ebp
+    ret
+
+; Transfer a buffer through a port with a string instruction, which moves
+; all of it in a single instruction instead of a call per element.
+; Arguments: port, buffer, count.
+global rep_insw
+rep_insw:
+    push ebp
+    mov ebp, esp
+    push edi
+
+    mov edx, [ebp + 8]
+    mov edi, [ebp + 12]
+    mov ecx, [ebp + 16]
+    rep insw
+
+    pop edi
+    pop ebp
+    ret
+
+global rep_insd
+rep_insd:
+    push ebp
+    mov ebp, esp
+    push edi
+
+    mov edx, [ebp + 8]
+    mov edi, [ebp + 12]
+    mov ecx, [ebp + 16]
+    rep insd
+
+    pop edi
+    pop ebp
+    ret
+
+global rep_outsw
+rep_outsw:
+    push ebp
+    mov ebp, esp
+    push esi
+
+    mov edx, [ebp + 8]
+    mov esi, [ebp + 12]
+    mov ecx, [ebp + 16]
+    rep outsw
+
+    pop esi
+    pop ebp
+    ret
+
+global rep_outsd
+rep_outsd:
+    push ebp
+    mov ebp, esp
+    push esi
+
+    mov edx, [ebp + 8]
+    mov esi, [ebp + 12]
+    mov ecx, [ebp + 16]
+    rep outsd
+
+    pop esi
+    pop ebp
+    ret
@@ -0,0 +1,299 @@
+#include "drivers/pci/pci.hpp"
+
+#include "drivers/io/ports.hpp"
+
+namespace drivers::pci {
+
+constexpr size_t BUS_COUNT = 256;
+constexpr size_t DEVICES_PER_BUS = 32;
+constexpr size_t FUNCTIONS_PER_DEVICE = 8;
+
+constexpr uint16_t NO_DEVICE = 0xffff;
+
+// Offsets of configuration space registers.
+constexpr uint8_t ID_OFFSET = 0x00;
+constexpr uint8_t COMMAND_OFFSET = 0x04;
+constexpr uint8_t CLASS_OFFSET = 0x08;
+constexpr uint8_t HEADER_TYPE_OFFSET = 0x0c;
+constexpr uint8_t FIRST_BAR_OFFSET = 0x10;
+constexpr uint8_t INTERRUPT_OFFSET = 0x3c;
+
+// Bits of the command register.
+constexpr uint32_t IO_SPACE_ENABLE = 1 << 0;
+constexpr uint32_t MEMORY_SPACE_ENABLE = 1 << 1;
+constexpr uint32_t BUS_MASTER_ENABLE = 1 << 2;
+
+static with_error<size_t> for_each_function(device* devices, size_t capacity);
+[[nodiscard]] static bool exists(const function_address& address);
+[[nodiscard]] static bool is_multifunction(
+    const function_address& address);
+static void read_device(const function_address& address, device* device);
+static void read_bars(const function_address& address, device* device);
+[[nodiscard]] static uint32_t size_bar(const function_address& address,
+                                       uint8_t offset);
+[[nodiscard]] static bool matches(const device* device, const driver& driver);
+
+uint32_t read_config(const function_address& address, uint8_t offset) {
+    constexpr uint32_t ENABLE = 1u << 31;
+
+    io::write_dword(io::Port::PCI_CONFIG_ADDRESS,
+                    ENABLE | address.bus << 16 | address.device << 11 |
+                        address.function << 8 | (offset & 0xfc));
+    return io::read_dword(io::Port::PCI_CONFIG_DATA);
+}
+
+void write_config(const function_address& address, uint8_t offset,
+                  uint32_t value) {
+    constexpr uint32_t ENABLE = 1u << 31;
+
+    io::write_dword(io::Port::PCI_CONFIG_ADDRESS,
+                    ENABLE | address.bus << 16 | address.device << 11 |
+                        address.function << 8 | (offset & 0xfc));
+    io::write_dword(io::Port::PCI_CONFIG_DATA, value);
+}
+
+with_error<device_table> scan(allocator* allocator) {
+    // The devices are counted first, so the table is allocated once.
+    auto [count, count_error] = for_each_function(nullptr, 0);
+    if (errors::set(count_error)) {
+        return {{}, count_error};
+    }
+
+    device_table table{
+        ._devices = nullptr, ._count = 0, ._allocator = allocator};
+    if (count == 0) {
+        return {table, errors::nil()};
+    }
+
+    auto [allocation, allocation_error] =
+        try_malloc(allocator, count * sizeof(device));
+    if (errors::set(allocation_error)) {
+        errors::enrich(&allocation_error, "allocate device table");
+        return {{}, allocation_error};
+    }
+
+    table._devices = static_cast<device*>(allocation);
+
+    auto [found, scan_error] = for_each_function(table._devices, count);
+    if (errors::set(scan_error)) {
+        free(allocator, allocation, count * sizeof(device));
+        return {{}, scan_error};
+    }
+
+    table._count = found;
+
+    return {table, errors::nil()};
+}
+
+error destroy(device_table* table) {
+    if (table->_devices == nullptr) {
+        return errors::nil();
+    }
+
+    error free_error = try_free(table->_allocator, table->_devices,
+                                table->_count * sizeof(device));
+    if (errors::set(free_error)) {
+        errors::enrich(&free_error, "free device table");
+        return free_error;
+    }
+
+    table->_devices = nullptr;
+    table->_count = 0;
+
+    return errors::nil();
+}
+
+size_t get_count(const device_table* table) {
+    return table->_count;
+}
+
+const device* get_device(const device_table* table, size_t index) {
+    return &table->_devices[index];
+}
+
+const device* find(const device_table* table, const driver& driver) {
+    for (size_t i = 0; i < table->_count; i++) {
+        if (matches(&table->_devices[i], driver)) {
+            return &table->_devices[i];
+        }
+    }
+
+    return nullptr;
+}
+
+size_t register_driver(const device_table* table, const driver& driver) {
+    size_t probed = 0;
+
+    for (size_t i = 0; i < table->_count; i++) {
+        const device* const device = &table->_devices[i];
+        if (!matches(device, driver)) {
+            continue;
+        }
+
+        error probe_error = driver.probe(device, driver.context);
+        if (errors::set(probe_error)) {
+            errors::enrich(&probe_error, "probe PCI device");
+            errors::log(probe_error);
+        }
+        probed++;
+    }
+
+    return probed;
+}
+
+void enable_bus_mastering(const function_address& address) {
+    write_config(address, COMMAND_OFFSET,
+                 read_config(address, COMMAND_OFFSET) | BUS_MASTER_ENABLE);
+}
+
+with_error<size_t> for_each_function(device* devices, size_t capacity) {
+    size_t found = 0;
+
+    // Every bus is probed, rather than following bridges, so devices behind
+    // bridges the firmware left unnumbered are simply not found.
+    for (size_t bus = 0; bus < BUS_COUNT; bus++) {
+        for (size_t slot = 0; slot < DEVICES_PER_BUS; slot++) {
+            const function_address first{static_cast<uint8_t>(bus),
+                                         static_cast<uint8_t>(slot), 0};
+            if (!exists(first)) {
+                continue;
+            }
+
+            const size_t functions =
+                is_multifunction(first) ? FUNCTIONS_PER_DEVICE : 1;
+            for (size_t function = 0; function < functions; function++) {
+                const function_address address{
+                    static_cast<uint8_t>(bus), static_cast<uint8_t>(slot),
+                    static_cast<uint8_t>(function)};
+                if (!exists(address)) {
+                    continue;
+                }
+
+                if (devices != nullptr) {
+                    if (found == capacity) {
+                        return {found, errors::make(WITH_LOCATION(
+                                           "devices appeared while scanning"))};
+                    }
+                    read_device(address, &devices[found]);
+                }
+                found++;
+            }
+        }
+    }
+
+    return {found, errors::nil()};
+}
+
+bool exists(const function_address& address) {
+    return (read_config(address, ID_OFFSET) & 0xffff) != NO_DEVICE;
+}
+
+bool is_multifunction(const function_address& address) {
+    constexpr uint32_t MULTIFUNCTION = 1 << 23;
+
+    return (read_config(address, HEADER_TYPE_OFFSET) & MULTIFUNCTION) != 0;
+}
+
+void read_device(const function_address& address, device* device) {
+    const uint32_t id = read_config(address, ID_OFFSET);
+    const uint32_t class_register = read_config(address, CLASS_OFFSET);
+    const uint32_t interrupt = read_config(address, INTERRUPT_OFFSET);
+
+    device->address = address;
+    device->vendor_id = id & 0xffff;
+    device->device_id = id >> 16;
+    device->revision = class_register & 0xff;
+    device->programming_interface = (class_register >> 8) & 0xff;
+    device->subclass = (class_register >> 16) & 0xff;
+    device->class_code = class_register >> 24;
+    device->interrupt_line = interrupt & 0xff;
+    device->interrupt_pin = (interrupt >> 8) & 0xff;
+
+    read_bars(address, device);
+}
+
+void read_bars(const function_address& address, device* device) {
+    constexpr uint32_t HEADER_TYPE_MASK = 0x7f;
+    constexpr uint32_t GENERAL_HEADER = 0x00;
+    constexpr uint32_t BRIDGE_HEADER = 0x01;
+    constexpr size_t BRIDGE_BAR_COUNT = 2;
+
+    constexpr uint32_t IO_BAR = 1 << 0;
+    constexpr uint32_t MEMORY_TYPE_MASK = 0x6;
+    constexpr uint32_t MEMORY_TYPE_64_BIT = 0x4;
+    constexpr uint32_t PREFETCHABLE = 1 << 3;
+
+    const uint32_t header_type =
+        (read_config(address, HEADER_TYPE_OFFSET) >> 16) & HEADER_TYPE_MASK;
+    const size_t bar_count = header_type == GENERAL_HEADER  ? BAR_COUNT
+                             : header_type == BRIDGE_HEADER ? BRIDGE_BAR_COUNT
+                                                            : 0;
+
+    for (size_t i = 0; i < BAR_COUNT; i++) {
+        device->bars[i] = {};
+    }
+
+    for (size_t i = 0; i < bar_count; i++) {
+        const uint8_t offset = FIRST_BAR_OFFSET + i * sizeof(uint32_t);
+        const uint32_t value = read_config(address, offset);
+        bar* const bar = &device->bars[i];
+
+        bar->is_io = (value & IO_BAR) != 0;
+        if (bar->is_io) {
+            bar->base = value & ~0x3u;
+        } else {
+            bar->base = value & ~0xfu;
+            bar->is_prefetchable = (value & PREFETCHABLE) != 0;
+        }
+        bar->bytes = size_bar(address, offset);
+
+        // The upper half of a 64 bit address takes the next register. The
+        // kernel only reaches the lower 4 GiB, so it is skipped.
+        if (!bar->is_io && (value & MEMORY_TYPE_MASK) == MEMORY_TYPE_64_BIT) {
+            i++;
+        }
+    }
+}
+
+uint32_t size_bar(const function_address& address, uint8_t offset) {
+    constexpr uint32_t IO_BAR = 1 << 0;
+
+    const uint32_t original = read_config(address, offset);
+    const uint32_t command = read_config(address, COMMAND_OFFSET);
+
+    // The device must not decode the all ones address it is given while
+    // being sized.
+    write_config(address, COMMAND_OFFSET,
+                 command & ~(IO_SPACE_ENABLE | MEMORY_SPACE_ENABLE));
+    write_config(address, offset, 0xffffffff);
+    uint32_t mask = read_config(address, offset);
+    write_config(address, offset, original);
+    write_config(address, COMMAND_OFFSET, command);
+
+    if (mask == 0) {
+        return 0;
+    }
+
+    // The bits the device doesn't decode read back as zero. IO registers
+    // may leave the upper half zero, since IO addresses are 16 bits.
+    if ((original & IO_BAR) != 0) {
+        mask = (mask & ~0x3u) | 0xffff0000;
+    } else {
+        mask &= ~0xfu;
+    }
+
+    return ~mask + 1;
+}
+
+bool matches(const device* device, const driver& driver) {
+    return (driver.vendor_id == ANY_ID ||
+            driver.vendor_id == device->vendor_id) &&
+           (driver.device_id == ANY_ID ||
+            driver.device_id == device->device_id) &&
+           (driver.class_code == ANY_CLASS ||
+            driver.class_code == device->class_code) &&
+           (driver.subclass == ANY_CLASS ||
+            driver.subclass == device->subclass);
+}
+
+}  // namespace drivers::pci
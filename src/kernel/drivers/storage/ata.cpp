@@ -1,14 +1,164 @@
 #include "drivers/storage/ata.hpp"
 
+#include <cstddef>
+
 #include "drivers/io/ports.hpp"
+#include "drivers/storage/ata_registers.hpp"
+#include "memory/paging/paging.hpp"
 
 namespace drivers::storage::ata {
 
-void read_sectors(disk* disk, sector* buffer, size_t offset, size_t amount) {
+[[nodiscard]] static error finish_command(const registers& registers);
+static void wait_for_busy_to_be_reported();
+static void fault_in(const void* buffer, size_t bytes);
+static void fault_in_for_writing(void* buffer, size_t bytes);
+
+bool is_present(disk* disk) {
+    // A bus without drives floats high.
+    constexpr uint8_t NO_BUS = 0xff;
+    constexpr size_t IDENTIFY_SIZE_IN_WORDS = 256;
+
+    const registers& registers = get_registers_by_bus(disk->bus);
+    send_command(registers, disk->port, Command::IDENTIFY, 0, 0);
+    wait_for_busy_to_be_reported();
+
+    const uint8_t status = read_status(registers);
+    if (status == 0 || status == NO_BUS) {
+        return false;
+    }
+
+    wait_until_not_busy(registers);
+
+    // ATAPI drives abort the command, and leave their signature in the LBA
+    // registers.
+    if (io::read_byte(registers.cylinder_low_or_lba_mid) != 0 ||
+        io::read_byte(registers.cylinder_high_or_lba_high) != 0) {
+        return false;
+    }
+
+    if (errors::set(wait_for_buffer_to_be_ready(registers))) {
+        return false;
+    }
+
+    // The identity isn't needed, but the drive only completes the command
+    // once it was read.
+    for (size_t i = 0; i < IDENTIFY_SIZE_IN_WORDS; i++) {
+        static_cast<void>(io::read_word(registers.data));
+    }
+
+    return true;
+}
+
+error read_sectors(disk* disk, sector* buffer, size_t offset, size_t amount) {
+    fault_in_for_writing(buffer, amount * SECTOR_SIZE_IN_BYTES);
+
+    switch (disk->mode) {
+        case Mode::DMA:
+            return dma::read_sectors(disk, buffer, offset, amount);
+        case Mode::PIO_INTERRUPTS:
+            return pio::read_sectors_with_interrupts(disk, buffer, offset,
+                                                     amount);
+        case Mode::PIO:
+        default:
+            return pio::read_sectors(disk, buffer, offset, amount);
+    }
+}
+
+error write_sectors(disk* disk, const sector* buffer, size_t offset,
+                    size_t amount) {
+    fault_in(buffer, amount * SECTOR_SIZE_IN_BYTES);
+
     switch (disk->mode) {
+        case Mode::DMA:
+            return dma::write_sectors(disk, buffer, offset, amount);
+        // Writes have no interrupt-driven PIO path, so they are polled.
+        case Mode::PIO_INTERRUPTS:
         case Mode::PIO:
         default:
-            pio::read_sectors(disk, buffer, offset, amount);
+            return pio::write_sectors(disk, buffer, offset, amount);
+    }
+}
+
+error set_write_cache(disk* disk, bool enabled) {
+    constexpr uint8_t ENABLE_WRITE_CACHE = 0x02;
+    constexpr uint8_t DISABLE_WRITE_CACHE = 0x82;
+
+    const registers& registers = get_registers_by_bus(disk->bus);
+    send_command(registers, disk->port, Command::SET_FEATURES,
+                 enabled ? ENABLE_WRITE_CACHE : DISABLE_WRITE_CACHE);
+
+    error feature_error = finish_command(registers);
+    if (errors::set(feature_error)) {
+        errors::enrich(&feature_error, "set write cache feature");
+    }
+    return feature_error;
+}
+
+error flush(disk* disk) {
+    const registers& registers = get_registers_by_bus(disk->bus);
+
+    // Sectors are addressed with 28 bits, so the EXT variant of the command
+    // isn't needed.
+    send_command(registers, disk->port, Command::FLUSH_CACHE, 0);
+
+    error flush_error = finish_command(registers);
+    if (errors::set(flush_error)) {
+        errors::enrich(&flush_error, "flush write cache");
+    }
+    return flush_error;
+}
+
+void handle_interrupt() {
+    // The bus master status is checked first, since reading the drive's
+    // status clears its interrupt.
+    dma::handle_interrupt();
+    pio::handle_interrupt();
+}
+
+error finish_command(const registers& registers) {
+    wait_for_busy_to_be_reported();
+    wait_until_not_busy(registers);
+
+    return check_status(read_status(registers));
+}
+
+void wait_for_busy_to_be_reported() {
+    constexpr size_t BUSY_DELAY = 4;
+
+    // The drive may take a moment to report that it's busy with the command.
+    for (size_t i = 0; i < BUSY_DELAY; i++) {
+        io::short_delay();
+    }
+}
+
+void fault_in(const void* buffer, size_t bytes) {
+    constexpr size_t PAGE_SIZE = memory::paging::PAGE_SIZE_IN_BYTES;
+
+    // Pages of demand paged buffers are mapped before the command starts,
+    // since resolving their faults mid-command may swap, which needs the bus.
+    // Neither DMA nor the IRQ14 handler could take the fault anyway.
+    const std::byte* const start = static_cast<const std::byte*>(buffer);
+    const size_t first_offset = reinterpret_cast<size_t>(start) % PAGE_SIZE;
+    for (size_t offset = 0; offset < first_offset + bytes;
+         offset += PAGE_SIZE) {
+        const volatile std::byte* const page =
+            start - first_offset + offset;
+        static_cast<void>(*page);
+    }
+}
+
+void fault_in_for_writing(void* buffer, size_t bytes) {
+    constexpr size_t PAGE_SIZE = memory::paging::PAGE_SIZE_IN_BYTES;
+
+    // Like fault_in(), but the pages are written to as well. Shared pages
+    // are copied before the transfer fills them, and the pages are marked
+    // dirty, which DMA doesn't do, so reclaim doesn't drop what was read.
+    std::byte* const start = static_cast<std::byte*>(buffer);
+    const size_t first_offset = reinterpret_cast<size_t>(start) % PAGE_SIZE;
+    for (size_t offset = 0; offset < first_offset + bytes;
+         offset += PAGE_SIZE) {
+        volatile std::byte* const page = start - first_offset + offset;
+        *page = *page;
     }
 }
 
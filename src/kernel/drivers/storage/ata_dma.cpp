@@ -0,0 +1,286 @@
+#include <cstddef>
+
+#include "drivers/io/ports.hpp"
+#include "drivers/storage/ata.hpp"
+#include "drivers/storage/ata_registers.hpp"
+#include "interrupts/interrupts.hpp"
+#include "memory/paging/paging.hpp"
+
+namespace drivers::storage::ata::dma {
+
+// A physical region descriptor - a physically contiguous part of the buffer
+// of a transfer. See https://wiki.osdev.org/ATA/ATAPI_using_DMA.
+struct __attribute__((packed)) region_descriptor {
+    uint32_t physical_address;
+    // 0 stands for 64 KiB.
+    uint16_t bytes;
+    uint16_t flags;
+};
+
+// Offsets of the bus master registers of a channel.
+constexpr uint16_t COMMAND_OFFSET = 0;
+constexpr uint16_t STATUS_OFFSET = 2;
+constexpr uint16_t TABLE_ADDRESS_OFFSET = 4;
+// The registers of the secondary channel follow those of the primary.
+constexpr uint16_t SECONDARY_CHANNEL_OFFSET = 8;
+
+// Bits of the bus master command register.
+constexpr uint8_t COMMAND_START = 0x01;
+constexpr uint8_t COMMAND_TO_MEMORY = 0x08;
+
+// Bits of the bus master status register. Error and interrupt are cleared
+// by writing them.
+constexpr uint8_t STATUS_DMA_ERROR = 0x02;
+constexpr uint8_t STATUS_INTERRUPT = 0x04;
+
+constexpr uint16_t END_OF_TABLE = 0x8000;
+
+// A descriptor may not cross a 64 KiB boundary.
+constexpr size_t BOUNDARY_IN_BYTES = 64 * 1024;
+
+// A transfer of 256 sectors spans at most this many pages.
+constexpr size_t MAX_DESCRIPTORS =
+    256 * SECTOR_SIZE_IN_BYTES / memory::paging::PAGE_SIZE_IN_BYTES + 1;
+// Aligning the table to a power of two above its size keeps it from
+// crossing a 64 KiB boundary, which it may not either.
+constexpr size_t TABLE_ALIGNMENT = 512;
+static_assert(MAX_DESCRIPTORS * sizeof(region_descriptor) <= TABLE_ALIGNMENT);
+
+// The bus master class of IDE controllers has this programming interface
+// bit set.
+constexpr uint8_t BUS_MASTER_INTERFACE = 0x80;
+// The bus master registers are IO ports in this BAR.
+constexpr size_t BUS_MASTER_BAR = 4;
+
+[[nodiscard]] static error transfer(disk* disk, size_t offset, size_t amount,
+                                    Command ata_command, uint8_t direction);
+static error probe(const pci::device* device, void* context);
+[[nodiscard]] static error describe(const void* buffer, size_t bytes);
+[[nodiscard]] static io::Port get_port(Bus bus, uint16_t offset);
+static void wait_for_completion(Bus bus, bool with_interrupt);
+
+// Zero until a controller is found.
+static uint16_t bus_master_base = 0;
+static region_descriptor* table = nullptr;
+static uint32_t table_physical_address = 0;
+// Whether a transfer on the primary bus waits for IRQ14.
+static volatile bool pending = false;
+
+error init(const pci::device_table* devices, allocator* allocator) {
+    const pci::driver driver{
+        .vendor_id = pci::ANY_ID,
+        .device_id = pci::ANY_ID,
+        .class_code = static_cast<uint8_t>(pci::Class::MASS_STORAGE),
+        .subclass = static_cast<uint8_t>(pci::StorageSubclass::IDE),
+        .probe = probe,
+        .context = nullptr,
+    };
+    pci::register_driver(devices, driver);
+    if (bus_master_base == 0) {
+        return errors::nil();
+    }
+
+    auto [allocation, allocation_error] = try_aligned_malloc(
+        allocator, MAX_DESCRIPTORS * sizeof(region_descriptor),
+        TABLE_ALIGNMENT);
+    if (errors::set(allocation_error)) {
+        bus_master_base = 0;
+        errors::enrich(&allocation_error, "allocate descriptor table");
+        return allocation_error;
+    }
+
+    auto [physical_address, translate_error] =
+        memory::paging::get_physical_address(memory::paging::get_loaded(),
+                                             allocation);
+    if (errors::set(translate_error)) {
+        bus_master_base = 0;
+        free(allocator, allocation,
+             MAX_DESCRIPTORS * sizeof(region_descriptor));
+        errors::enrich(&translate_error, "translate descriptor table");
+        return translate_error;
+    }
+
+    table = static_cast<region_descriptor*>(allocation);
+    table_physical_address = reinterpret_cast<uint32_t>(physical_address);
+
+    return errors::nil();
+}
+
+bool is_available() {
+    return bus_master_base != 0;
+}
+
+error read_sectors(disk* disk, sector* buffer, size_t offset, size_t amount) {
+    if (!is_available() || memory::paging::get_loaded() == nullptr ||
+        errors::set(describe(buffer, amount * SECTOR_SIZE_IN_BYTES))) {
+        return pio::read_sectors_with_interrupts(disk, buffer, offset, amount);
+    }
+
+    return transfer(disk, offset, amount, Command::READ_DMA,
+                    COMMAND_TO_MEMORY);
+}
+
+error write_sectors(disk* disk, const sector* buffer, size_t offset,
+                    size_t amount) {
+    if (!is_available() || memory::paging::get_loaded() == nullptr ||
+        errors::set(describe(buffer, amount * SECTOR_SIZE_IN_BYTES))) {
+        return pio::write_sectors(disk, buffer, offset, amount);
+    }
+
+    return transfer(disk, offset, amount, Command::WRITE_DMA, 0);
+}
+
+void handle_interrupt() {
+    if (!pending) {
+        return;
+    }
+
+    const uint8_t status = io::read_byte(get_port(Bus::PRIMARY, STATUS_OFFSET));
+    if ((status & (STATUS_INTERRUPT | STATUS_DMA_ERROR)) != 0) {
+        pending = false;
+    }
+}
+
+// The buffer must already be described in the table.
+error transfer(disk* disk, size_t offset, size_t amount, Command ata_command,
+               uint8_t direction) {
+    const registers& registers = get_registers_by_bus(disk->bus);
+    const io::Port command = get_port(disk->bus, COMMAND_OFFSET);
+    const io::Port status = get_port(disk->bus, STATUS_OFFSET);
+
+    io::write_byte(command, 0);
+    io::write_dword(get_port(disk->bus, TABLE_ADDRESS_OFFSET),
+                    table_physical_address);
+    io::write_byte(status, STATUS_DMA_ERROR | STATUS_INTERRUPT);
+    io::write_byte(command, direction);
+
+    // Only the primary bus's IRQ is handled, and the handler can't run while
+    // interrupts are disabled, such as in other handlers.
+    const bool with_interrupt =
+        disk->bus == Bus::PRIMARY && ::interrupts::are_enabled();
+    if (with_interrupt) {
+        DISABLE_INTERRUPTS();
+        pending = true;
+    }
+
+    send_command(registers, disk->port, ata_command, offset, amount);
+    io::write_byte(command, direction | COMMAND_START);
+
+    wait_for_completion(disk->bus, with_interrupt);
+
+    const uint8_t bus_master_status = io::read_byte(status);
+    io::write_byte(command, 0);
+    io::write_byte(status, STATUS_DMA_ERROR | STATUS_INTERRUPT);
+
+    // Also acknowledges the drive's interrupt, in case it wasn't handled.
+    // The drive may still be busy when the controller is done.
+    wait_until_not_busy(registers);
+    error status_error = check_status(read_status(registers));
+    if (errors::set(status_error)) {
+        errors::enrich(&status_error, "transfer sectors");
+        return status_error;
+    }
+
+    if ((bus_master_status & STATUS_DMA_ERROR) != 0) {
+        return errors::make(WITH_LOCATION("bus master reported an error"));
+    }
+
+    return errors::nil();
+}
+
+error probe(const pci::device* device, void* context) {
+    const pci::bar& bar = device->bars[BUS_MASTER_BAR];
+    if ((device->programming_interface & BUS_MASTER_INTERFACE) == 0 ||
+        !bar.is_io || bar.bytes == 0) {
+        return errors::nil();
+    }
+
+    // The legacy ports of the driver belong to the first controller.
+    if (bus_master_base != 0) {
+        return errors::nil();
+    }
+
+    bus_master_base = bar.base;
+    pci::enable_bus_mastering(device->address);
+
+    return errors::nil();
+}
+
+error describe(const void* buffer, size_t bytes) {
+    const std::byte* const start = static_cast<const std::byte*>(buffer);
+    const memory::paging::paging* const paging = memory::paging::get_loaded();
+
+    size_t count = 0;
+    for (size_t described = 0; described < bytes;) {
+        const std::byte* const address = start + described;
+        auto [physical, translate_error] =
+            memory::paging::get_physical_address(paging, address);
+        if (errors::set(translate_error)) {
+            return translate_error;
+        }
+
+        // Pages are described one at a time, since the buffer is only
+        // contiguous in virtual memory.
+        const size_t page_left =
+            memory::paging::PAGE_SIZE_IN_BYTES -
+            reinterpret_cast<size_t>(address) %
+                memory::paging::PAGE_SIZE_IN_BYTES;
+        const size_t chunk =
+            bytes - described < page_left ? bytes - described : page_left;
+        const uint32_t physical_address = reinterpret_cast<uint32_t>(physical);
+
+        // Pages that happen to be contiguous are merged, unless that would
+        // cross a boundary.
+        region_descriptor* const previous =
+            count > 0 ? &table[count - 1] : nullptr;
+        if (previous != nullptr &&
+            previous->physical_address + previous->bytes == physical_address &&
+            physical_address % BOUNDARY_IN_BYTES != 0) {
+            previous->bytes += chunk;
+        } else {
+            if (count == MAX_DESCRIPTORS) {
+                return errors::make(WITH_LOCATION("too many descriptors"));
+            }
+            table[count++] = {
+                .physical_address = physical_address,
+                .bytes = static_cast<uint16_t>(chunk),
+                .flags = 0,
+            };
+        }
+
+        described += chunk;
+    }
+
+    if (count == 0) {
+        return errors::make(WITH_LOCATION("empty transfer"));
+    }
+
+    table[count - 1].flags = END_OF_TABLE;
+
+    return errors::nil();
+}
+
+io::Port get_port(Bus bus, uint16_t offset) {
+    const uint16_t channel =
+        bus == Bus::PRIMARY ? 0 : SECONDARY_CHANNEL_OFFSET;
+
+    return static_cast<io::Port>(bus_master_base + channel + offset);
+}
+
+void wait_for_completion(Bus bus, bool with_interrupt) {
+    if (with_interrupt) {
+        // Other interrupts, such as the timer, wake the processor as well.
+        while (pending) {
+            halt_until_interrupt();
+        }
+        ENABLE_INTERRUPTS();
+        return;
+    }
+
+    const io::Port status = get_port(bus, STATUS_OFFSET);
+    while ((io::read_byte(status) & (STATUS_INTERRUPT | STATUS_DMA_ERROR)) ==
+           0) {
+    }
+}
+
+}  // namespace drivers::storage::ata::dma
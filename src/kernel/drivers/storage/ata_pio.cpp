@@ -1,108 +1,160 @@
-#include <type_traits>
-
+#include "drivers/interrupts/pic.hpp"
 #include "drivers/io/ports.hpp"
 #include "drivers/storage/ata.hpp"
+#include "drivers/storage/ata_registers.hpp"
+#include "interrupts/idt.hpp"
+#include "interrupts/interrupts.hpp"
 
 namespace drivers::storage::ata::pio {
 
-namespace io = drivers::io;
-
-enum class Command { READ = 0x20 };
-
-struct registers {
-    io::Port data;
-    io::Port features_or_error;
-    io::Port selector_count;
-    io::Port selector_number_or_lba_low;
-    io::Port cylinder_low_or_lba_mid;
-    io::Port cylinder_high_or_lba_high;
-    io::Port drive_or_head;
-    io::Port status_or_command;
-    io::Port alternate_status_or_device_control;
-    io::Port drive_address;
-};
-
-static registers primary_registers = {
-    io::Port::PRIMARY_ATA_DATA,
-    io::Port::PRIMARY_ATA_FEATURES_OR_ERROR,
-    io::Port::PRIMARY_ATA_SELECTOR_COUNT,
-    io::Port::PRIMARY_ATA_SELECTOR_NUMBER_OR_LBA_LOW,
-    io::Port::PRIMARY_ATA_CYLINDER_LOW_OR_LBA_MID,
-    io::Port::PRIMARY_ATA_CYLINDER_HIGH_OR_LBA_HIGH,
-    io::Port::PRIMARY_ATA_DRIVE_OR_HEAD,
-    io::Port::PRIMARY_ATA_STATUS_OR_COMMAND,
-    io::Port::PRIMARY_ATA_ALTERNATE_STATUS_OR_DEVICE_CONTROL,
-    io::Port::PRIMARY_ATA_DRIVE_ADDRESS,
-};
-
-static registers secondary_registers = {
-    io::Port::PRIMARY_ATA_DATA,
-    io::Port::PRIMARY_ATA_FEATURES_OR_ERROR,
-    io::Port::PRIMARY_ATA_SELECTOR_COUNT,
-    io::Port::PRIMARY_ATA_SELECTOR_NUMBER_OR_LBA_LOW,
-    io::Port::PRIMARY_ATA_CYLINDER_LOW_OR_LBA_MID,
-    io::Port::PRIMARY_ATA_CYLINDER_HIGH_OR_LBA_HIGH,
-    io::Port::PRIMARY_ATA_DRIVE_OR_HEAD,
-    io::Port::PRIMARY_ATA_STATUS_OR_COMMAND,
-    io::Port::PRIMARY_ATA_ALTERNATE_STATUS_OR_DEVICE_CONTROL,
-    io::Port::PRIMARY_ATA_DRIVE_ADDRESS,
-};
-
-static void send_amount(const registers& registers, size_t amount);
-static void send_sector_offset(const registers& registers, Port port,
-                               size_t offset);
-static void send_command(const registers& registers, Command command);
-static void wait_for_buffer_to_be_ready(const registers& registers);
-[[nodiscard]] static bool is_buffer_ready(const registers& registers);
+using SectorReader = void (*)(const registers& registers, sector* buffer);
+
+[[nodiscard]] static error read_polled(disk* disk, sector* buffer,
+                                       size_t offset, size_t amount,
+                                       SectorReader read);
 static void read_sector(const registers& registers, sector* buffer);
-[[nodiscard]] static const registers& get_registers_by_bus(Bus bus);
+static void read_sector_by_word(const registers& registers, sector* buffer);
+static void write_sector(const registers& registers, const sector* buffer);
+
+// The read the IRQ14 handler moves sectors for. Only one is pending at a
+// time, since the caller waits for it to finish.
+static sector* volatile pending_buffer = nullptr;
+static volatile size_t pending_sectors = 0;
+// The status the drive failed the pending read with, or 0.
+static volatile uint8_t pending_status = 0;
+
+error read_sectors(disk* disk, sector* buffer, size_t offset, size_t amount) {
+    return read_polled(disk, buffer, offset, amount, read_sector);
+}
 
-void read_sectors(disk* disk, sector* buffer, size_t offset, size_t amount) {
+error write_sectors(disk* disk, const sector* buffer, size_t offset,
+                    size_t amount) {
     const registers& registers = get_registers_by_bus(disk->bus);
-    send_amount(registers, amount);
-    send_sector_offset(registers, disk->port, offset);
-    send_command(registers, Command::READ);
+    send_command(registers, disk->port, Command::WRITE, offset, amount);
+
+    for (size_t sectors_written = 0; sectors_written < amount;
+         sectors_written++) {
+        error ready_error = wait_for_buffer_to_be_ready(registers);
+        if (errors::set(ready_error)) {
+            errors::enrich(&ready_error, "write sector");
+            return ready_error;
+        }
+        write_sector(registers, buffer + sectors_written);
+    }
 
-    for (size_t sectors_read = 0; sectors_read < amount; sectors_read++) {
-        wait_for_buffer_to_be_ready(registers);
-        read_sector(registers, buffer + sectors_read);
+    // The drive is busy until the last sector is written, and doesn't accept
+    // another command until then. Only then does it report whether writing
+    // the last sector failed.
+    wait_until_not_busy(registers);
+
+    error status_error = check_status(read_status(registers));
+    if (errors::set(status_error)) {
+        errors::enrich(&status_error, "write last sector");
     }
+    return status_error;
 }
 
-void send_amount(const registers& registers, size_t amount) {
-    io::write_byte(registers.selector_count, amount);
+error read_sectors_by_word(disk* disk, sector* buffer, size_t offset,
+                           size_t amount) {
+    return read_polled(disk, buffer, offset, amount, read_sector_by_word);
 }
 
-void send_sector_offset(const registers& registers, Port port, size_t offset) {
-    io::write_byte(registers.selector_number_or_lba_low, offset);
-    io::write_byte(registers.cylinder_low_or_lba_mid, offset >> 8);
-    io::write_byte(registers.cylinder_high_or_lba_high, offset >> 16);
-    io::write_byte(registers.drive_or_head,
-                   offset >> 24 | std::underlying_type_t<Port>(port));
+void init_interrupts() {
+    // Clearing the device control register clears nIEN, so the drives
+    // assert their interrupt line.
+    io::write_byte(
+        get_registers_by_bus(Bus::PRIMARY).alternate_status_or_device_control,
+        0);
+    drivers::interrupts::pic8259::unmask(::interrupts::Id::PIC_HDD);
 }
 
-void send_command(const registers& registers, Command command) {
-    io::write_byte(registers.status_or_command,
-                   std::underlying_type_t<Command>(command));
+error read_sectors_with_interrupts(disk* disk, sector* buffer, size_t offset,
+                                   size_t amount) {
+    if (disk->bus != Bus::PRIMARY || !::interrupts::are_enabled()) {
+        return pio::read_sectors(disk, buffer, offset, amount);
+    }
+
+    const registers& registers = get_registers_by_bus(disk->bus);
+
+    // The handler must not see the read before it is set up.
+    DISABLE_INTERRUPTS();
+    pending_buffer = buffer;
+    pending_sectors = amount;
+    pending_status = 0;
+
+    send_command(registers, disk->port, Command::READ, offset, amount);
+
+    // Other interrupts, such as the timer, wake the processor as well.
+    while (pending_sectors > 0) {
+        halt_until_interrupt();
+    }
+
+    pending_buffer = nullptr;
+    ENABLE_INTERRUPTS();
+
+    error status_error = check_status(pending_status);
+    if (errors::set(status_error)) {
+        errors::enrich(&status_error, "read sector");
+    }
+    return status_error;
 }
 
-void wait_for_buffer_to_be_ready(const registers& registers) {
-    while (!is_buffer_ready(registers)) {
+void handle_interrupt() {
+    // Reading the status register acknowledges the interrupt, so it is read
+    // even if no read is pending, such as after a polled command.
+    const registers& registers = get_registers_by_bus(Bus::PRIMARY);
+    const uint8_t status = read_status(registers);
+    if (pending_sectors == 0) {
+        return;
     }
+
+    // The drive raises no more interrupts for a failed command, so the read
+    // is given up rather than waited for forever, and the status is kept
+    // for the reader to report.
+    if ((status & (STATUS_ERROR | STATUS_DRIVE_FAULT)) != 0) {
+        pending_status = status;
+        pending_sectors = 0;
+        return;
+    }
+
+    if ((status & STATUS_DATA_AVAILABLE) == 0) {
+        return;
+    }
+
+    read_sector(registers, pending_buffer);
+    pending_buffer = pending_buffer + 1;
+    pending_sectors = pending_sectors - 1;
 }
 
-bool is_buffer_ready(const registers& registers) {
-    constexpr uint8_t PIO_DATA_AVAILABLE = 0x08;
+error read_polled(disk* disk, sector* buffer, size_t offset, size_t amount,
+                  SectorReader read) {
+    const registers& registers = get_registers_by_bus(disk->bus);
+    send_command(registers, disk->port, Command::READ, offset, amount);
 
-    const uint8_t status = io::read_byte(registers.status_or_command);
+    for (size_t sectors_read = 0; sectors_read < amount; sectors_read++) {
+        error ready_error = wait_for_buffer_to_be_ready(registers);
+        if (errors::set(ready_error)) {
+            errors::enrich(&ready_error, "read sector");
+            return ready_error;
+        }
+        read(registers, buffer + sectors_read);
+    }
 
-    return status & PIO_DATA_AVAILABLE;
+    return errors::nil();
 }
 
 void read_sector(const registers& registers, sector* buffer) {
     constexpr size_t SECTOR_SIZE_IN_WORDS =
         SECTOR_SIZE_IN_BYTES / (sizeof(uint16_t) / sizeof(uint8_t));
 
+    io::read_words(registers.data, reinterpret_cast<uint16_t*>(buffer),
+                   SECTOR_SIZE_IN_WORDS);
+}
+
+void read_sector_by_word(const registers& registers, sector* buffer) {
+    constexpr size_t SECTOR_SIZE_IN_WORDS =
+        SECTOR_SIZE_IN_BYTES / (sizeof(uint16_t) / sizeof(uint8_t));
+
     uint16_t* buffer_as_words = reinterpret_cast<uint16_t*>(buffer);
 
     for (size_t words_read = 0; words_read < SECTOR_SIZE_IN_WORDS;
@@ -111,8 +163,15 @@ void read_sector(const registers& registers, sector* buffer) {
     }
 }
 
-const registers& get_registers_by_bus(Bus bus) {
-    return (bus == Bus::PRIMARY) ? primary_registers : secondary_registers;
+void write_sector(const registers& registers, const sector* buffer) {
+    constexpr size_t SECTOR_SIZE_IN_WORDS =
+        SECTOR_SIZE_IN_BYTES / (sizeof(uint16_t) / sizeof(uint8_t));
+
+    // Only tested on QEMU's emulated drives. Some real drives can't take
+    // words back to back, and need a short delay between each out, which
+    // rep outsw doesn't leave. Reads don't have this problem.
+    io::write_words(registers.data, reinterpret_cast<const uint16_t*>(buffer),
+                    SECTOR_SIZE_IN_WORDS);
 }
 
 }  // namespace drivers::storage::ata::pio
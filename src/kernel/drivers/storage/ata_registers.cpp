@@ -0,0 +1,125 @@
+#include "drivers/storage/ata_registers.hpp"
+
+#include <type_traits>
+
+#include "interrupts/interrupts.hpp"
+#include "utilities/timestamp.hpp"
+
+namespace drivers::storage::ata {
+
+static registers primary_registers = {
+    io::Port::PRIMARY_ATA_DATA,
+    io::Port::PRIMARY_ATA_FEATURES_OR_ERROR,
+    io::Port::PRIMARY_ATA_SELECTOR_COUNT,
+    io::Port::PRIMARY_ATA_SELECTOR_NUMBER_OR_LBA_LOW,
+    io::Port::PRIMARY_ATA_CYLINDER_LOW_OR_LBA_MID,
+    io::Port::PRIMARY_ATA_CYLINDER_HIGH_OR_LBA_HIGH,
+    io::Port::PRIMARY_ATA_DRIVE_OR_HEAD,
+    io::Port::PRIMARY_ATA_STATUS_OR_COMMAND,
+    io::Port::PRIMARY_ATA_ALTERNATE_STATUS_OR_DEVICE_CONTROL,
+    io::Port::PRIMARY_ATA_DRIVE_ADDRESS,
+};
+
+static registers secondary_registers = {
+    io::Port::SECONDARY_ATA_DATA,
+    io::Port::SECONDARY_ATA_FEATURES_OR_ERROR,
+    io::Port::SECONDARY_ATA_SELECTOR_COUNT,
+    io::Port::SECONDARY_ATA_SELECTOR_NUMBER_OR_LBA_LOW,
+    io::Port::SECONDARY_ATA_CYLINDER_LOW_OR_LBA_MID,
+    io::Port::SECONDARY_ATA_CYLINDER_HIGH_OR_LBA_HIGH,
+    io::Port::SECONDARY_ATA_DRIVE_OR_HEAD,
+    io::Port::SECONDARY_ATA_STATUS_OR_COMMAND,
+    io::Port::SECONDARY_ATA_ALTERNATE_STATUS_OR_DEVICE_CONTROL,
+    io::Port::SECONDARY_ATA_DRIVE_ADDRESS,
+};
+
+static void send_amount(const registers& registers, size_t amount);
+static void send_sector_offset(const registers& registers, Port port,
+                               size_t offset);
+[[nodiscard]] static bool is_buffer_ready(const registers& registers);
+
+static uint64_t idle_cycles = 0;
+
+const registers& get_registers_by_bus(Bus bus) {
+    return (bus == Bus::PRIMARY) ? primary_registers : secondary_registers;
+}
+
+void send_command(const registers& registers, Port port, Command command,
+                  size_t offset, size_t amount) {
+    send_amount(registers, amount);
+    send_sector_offset(registers, port, offset);
+    io::write_byte(registers.status_or_command,
+                   std::underlying_type_t<Command>(command));
+}
+
+void send_command(const registers& registers, Port port, Command command,
+                  uint8_t features) {
+    io::write_byte(registers.drive_or_head, std::underlying_type_t<Port>(port));
+    io::write_byte(registers.features_or_error, features);
+    io::write_byte(registers.status_or_command,
+                   std::underlying_type_t<Command>(command));
+}
+
+uint8_t read_status(const registers& registers) {
+    return io::read_byte(registers.status_or_command);
+}
+
+void send_amount(const registers& registers, size_t amount) {
+    io::write_byte(registers.selector_count, amount);
+}
+
+void send_sector_offset(const registers& registers, Port port, size_t offset) {
+    io::write_byte(registers.selector_number_or_lba_low, offset);
+    io::write_byte(registers.cylinder_low_or_lba_mid, offset >> 8);
+    io::write_byte(registers.cylinder_high_or_lba_high, offset >> 16);
+    io::write_byte(registers.drive_or_head,
+                   offset >> 24 | std::underlying_type_t<Port>(port));
+}
+
+error wait_for_buffer_to_be_ready(const registers& registers) {
+    while (!is_buffer_ready(registers)) {
+        // The error bits only mean something once the drive isn't busy.
+        const uint8_t status = read_status(registers);
+        if ((status & STATUS_BUSY) == 0) {
+            error status_error = check_status(status);
+            if (errors::set(status_error)) {
+                return status_error;
+            }
+        }
+    }
+
+    return errors::nil();
+}
+
+bool is_buffer_ready(const registers& registers) {
+    return read_status(registers) & STATUS_DATA_AVAILABLE;
+}
+
+void wait_until_not_busy(const registers& registers) {
+    while ((read_status(registers) & STATUS_BUSY) != 0) {
+    }
+}
+
+error check_status(uint8_t status) {
+    if ((status & STATUS_DRIVE_FAULT) != 0) {
+        return errors::make(WITH_LOCATION("drive reported a fault"));
+    }
+
+    if ((status & STATUS_ERROR) != 0) {
+        return errors::make(WITH_LOCATION("drive reported an error"));
+    }
+
+    return errors::nil();
+}
+
+void halt_until_interrupt() {
+    const uint64_t start = utilities::read_cycles();
+    ::interrupts::wait_for_interrupt();
+    idle_cycles += utilities::read_cycles() - start;
+}
+
+uint64_t get_idle_cycles() {
+    return idle_cycles;
+}
+
+}  // namespace drivers::storage::ata
@@ -2,8 +2,45 @@
 #include "kernel/kernel.hpp"
 #include "logging/logger.hpp"
 #include "memory/allocation/allocator.hpp"
-#include "memory/allocation/block_heap.hpp"
+#include "memory/allocation/arena.hpp"
+#include "memory/allocation/bitmap_heap.hpp"
+#include "memory/allocation/buddy_heap.hpp"
+#include "memory/allocation/instrumented_heap.hpp"
+#include "memory/allocation/paged_heap.hpp"
+#include "memory/allocation/slab_heap.hpp"
+#include "memory/allocation/virtual_heap.hpp"
 #include "memory/layout.hpp"
+#include "memory/physical/frames.hpp"
+#include "memory/physical/memory_map.hpp"
+#include "memory/physical/references.hpp"
+#include "utilities/format.hpp"
+
+namespace bitmap_heap = memory::allocation::bitmap_heap;
+namespace buddy_heap = memory::allocation::buddy_heap;
+namespace paged_heap = memory::allocation::paged_heap;
+namespace virtual_heap = memory::allocation::virtual_heap;
+
+constexpr size_t HEAP_BLOCK_SIZE = 4096;
+constexpr size_t KILOBYTE = 1024;
+constexpr size_t LINE_SIZE = 80;
+
+// The allocators the kernel heap can take its pages from.
+enum class HeapBackend {
+    // Grows into the kernel heap range as it fills up, and shrinks back.
+    PAGED,
+    // A fixed run of frames split into blocks of power of two sizes, which
+    // keeps allocations aligned to their size.
+    BUDDY,
+};
+
+constexpr HeapBackend HEAP_BACKEND = HeapBackend::PAGED;
+
+static with_error<paged_heap::paged_heap> make_kernel_heap(
+    memory::allocation::allocator *frames);
+static with_error<buddy_heap::buddy_heap> make_buddy_kernel_heap(
+    memory::allocation::allocator *frames);
+static with_error<virtual_heap::virtual_heap> make_virtual_heap(
+    memory::allocation::allocator *frames);
 
 extern "C" void main() {
     drivers::display::vga3::clear();
@@ -11,26 +48,196 @@ extern "C" void main() {
 
     logging::info("Initializing Journey...");
 
-    constexpr size_t HEAP_BLOCK_SIZE = 4096;
-    constexpr size_t HEAP_SIZE = 100 * 1024 * 1024;
-    constexpr size_t HEAP_BLOCKS = HEAP_SIZE / HEAP_BLOCK_SIZE;
-    memory::allocation::block_heap::block_heap heap_implementation =
-        memory::allocation::block_heap::make_block_heap(
-            reinterpret_cast<uint8_t *>(memory::Layout::KERNEL_HEAP),
-            reinterpret_cast<memory::allocation::block_heap::block_metadata *>(
-                memory::Layout::KERNEL_HEAP_ENTRY_TABLE),
-            HEAP_BLOCK_SIZE, HEAP_BLOCKS);
+    const memory::physical::memory_map memory_map =
+        memory::physical::get_memory_map();
+
+    char line[LINE_SIZE] = "Usable memory: ";
+    utilities::append_decimal(line, LINE_SIZE,
+                              memory::physical::get_usable_kilobytes(
+                                  memory_map));
+    utilities::append(line, LINE_SIZE, " KiB");
+    logging::info(line);
+
+    auto [frames_implementation, frames_error] = memory::physical::make_frames(
+        memory_map,
+        reinterpret_cast<bitmap_heap::bitmap_word *>(
+            memory::Layout::FRAME_TABLE),
+        (static_cast<size_t>(memory::Layout::FRAME_TABLE_END) -
+         static_cast<size_t>(memory::Layout::FRAME_TABLE)) /
+            sizeof(bitmap_heap::bitmap_word));
+    if (errors::set(frames_error)) {
+        errors::enrich(&frames_error, "make frame allocator");
+        errors::log(frames_error);
+        return;
+    }
+
+    memory::allocation::allocator frames =
+        bitmap_heap::make_allocator(&frames_implementation);
 
+    // Frames that are shared between address spaces, such as after cloning
+    // one, are reference counted.
+    error references_error = memory::physical::init_references(
+        &frames, frames_implementation._blocks);
+    if (errors::set(references_error)) {
+        errors::enrich(&references_error, "initialize frame references");
+        errors::log(references_error);
+        return;
+    }
+
+    // Only the backend that is selected is made.
+    paged_heap::paged_heap paged_implementation{};
+    buddy_heap::buddy_heap buddy_implementation{};
+    memory::allocation::allocator page_heap{};
+    if constexpr (HEAP_BACKEND == HeapBackend::BUDDY) {
+        auto [heap_implementation, heap_error] =
+            make_buddy_kernel_heap(&frames);
+        if (errors::set(heap_error)) {
+            errors::enrich(&heap_error, "make buddy kernel heap");
+            errors::log(heap_error);
+            return;
+        }
+
+        buddy_implementation = heap_implementation;
+        page_heap = buddy_heap::make_allocator(&buddy_implementation);
+    } else {
+        auto [heap_implementation, heap_error] = make_kernel_heap(&frames);
+        if (errors::set(heap_error)) {
+            errors::enrich(&heap_error, "make kernel heap");
+            errors::log(heap_error);
+            return;
+        }
+
+        paged_implementation = heap_implementation;
+        page_heap = paged_heap::make_allocator(&paged_implementation);
+    }
+
+    // Small objects are packed into slabs taken from the page heap, instead
+    // of each taking up a whole page.
+    memory::allocation::slab_heap::slab_heap slab_implementation =
+        memory::allocation::slab_heap::make_slab_heap(&page_heap,
+                                                      HEAP_BLOCK_SIZE);
+    memory::allocation::allocator slab_heap =
+        memory::allocation::slab_heap::make_allocator(&slab_implementation);
+
+    // Keep statistics of the kernel heap, which are dumped when finalizing.
+    constexpr bool TRACK_HEAP_CALL_SITES = true;
+    memory::allocation::instrumented_heap::instrumented_heap
+        instrumented_implementation =
+            memory::allocation::instrumented_heap::make_instrumented_heap(
+                &slab_heap, TRACK_HEAP_CALL_SITES);
     memory::allocation::allocator heap =
-        memory::allocation::block_heap::make_allocator(&heap_implementation);
+        memory::allocation::instrumented_heap::make_allocator(
+            &instrumented_implementation);
+
+    auto [virtual_heap_implementation, virtual_heap_error] =
+        make_virtual_heap(&frames);
+    if (errors::set(virtual_heap_error)) {
+        errors::enrich(&virtual_heap_error, "make virtual heap");
+        errors::log(virtual_heap_error);
+        return;
+    }
+
+    memory::allocation::allocator large_heap =
+        virtual_heap::make_allocator(&virtual_heap_implementation);
+
+    // Boot time structures, such as the page tables, are bump allocated from
+    // large runs of frames and released all at once.
+    constexpr size_t ARENA_CHUNK_SIZE = 1024 * KILOBYTE;
+    memory::allocation::arena::arena arena_implementation =
+        memory::allocation::arena::make_arena(&frames, ARENA_CHUNK_SIZE);
+    memory::allocation::allocator arena =
+        memory::allocation::arena::make_allocator(&arena_implementation);
 
-    auto [kernel, make_error] = make(&heap);
+    auto [kernel, make_error] = make(&frames, &heap, &arena, &large_heap);
     errors::log(make_error);
 
     logging::info("Finalizing...");
 
+    memory::allocation::instrumented_heap::dump(&instrumented_implementation);
+
     error destroy_error = destroy(&kernel);
     errors::log(destroy_error);
 
+    error arena_error =
+        memory::allocation::arena::destroy(&arena_implementation);
+    errors::log(arena_error);
+
     logging::warn("Kernel finished running. Going into infinite loop...");
 }
+
+with_error<paged_heap::paged_heap> make_kernel_heap(
+    memory::allocation::allocator *frames) {
+    // The heap starts out empty and maps frames as it fills up, so its size
+    // is only bounded by the heap range and the amount of memory.
+    constexpr size_t GROWTH_SIZE = 64 * KILOBYTE;
+    constexpr bool SHRINK_ON_FREE = true;
+
+    const size_t bytes = static_cast<size_t>(memory::Layout::KERNEL_HEAP_END) -
+                         static_cast<size_t>(memory::Layout::KERNEL_HEAP);
+
+    auto [metadata, metadata_error] = memory::allocation::try_malloc(
+        frames,
+        paged_heap::metadata_words(bytes) * sizeof(bitmap_heap::bitmap_word));
+    if (errors::set(metadata_error)) {
+        errors::enrich(&metadata_error, "allocate heap metadata");
+        return {{}, metadata_error};
+    }
+
+    return {paged_heap::make_paged_heap(
+                reinterpret_cast<uint8_t *>(memory::Layout::KERNEL_HEAP),
+                bytes, static_cast<bitmap_heap::bitmap_word *>(metadata),
+                frames, GROWTH_SIZE, SHRINK_ON_FREE),
+            errors::nil()};
+}
+
+with_error<buddy_heap::buddy_heap> make_buddy_kernel_heap(
+    memory::allocation::allocator *frames) {
+    // The buddy heap can't grow, so its memory is taken up front. Frames are
+    // identity mapped, so it is usable before paging is enabled as well.
+    constexpr size_t BYTES = 4 * 1024 * KILOBYTE;
+    constexpr size_t BLOCKS = BYTES / HEAP_BLOCK_SIZE;
+
+    // Blocks are aligned to their size relative to the start, so aligning
+    // the start to the whole heap aligns them absolutely.
+    auto [start, start_error] =
+        memory::allocation::try_aligned_malloc(frames, BYTES, BYTES);
+    if (errors::set(start_error)) {
+        errors::enrich(&start_error, "allocate buddy heap");
+        return {{}, start_error};
+    }
+
+    auto [table, table_error] = memory::allocation::try_malloc(
+        frames, BLOCKS * sizeof(buddy_heap::block_metadata));
+    if (errors::set(table_error)) {
+        memory::allocation::free(frames, start, BYTES);
+        errors::enrich(&table_error, "allocate buddy heap metadata");
+        return {{}, table_error};
+    }
+
+    return {buddy_heap::make_buddy_heap(
+                static_cast<uint8_t *>(start),
+                static_cast<buddy_heap::block_metadata *>(table),
+                HEAP_BLOCK_SIZE, BLOCKS),
+            errors::nil()};
+}
+
+with_error<virtual_heap::virtual_heap> make_virtual_heap(
+    memory::allocation::allocator *frames) {
+    const size_t bytes =
+        static_cast<size_t>(memory::Layout::VIRTUAL_HEAP_END) -
+        static_cast<size_t>(memory::Layout::VIRTUAL_HEAP);
+
+    auto [metadata, metadata_error] = memory::allocation::try_malloc(
+        frames,
+        virtual_heap::metadata_words(bytes) * sizeof(bitmap_heap::bitmap_word));
+    if (errors::set(metadata_error)) {
+        errors::enrich(&metadata_error, "allocate virtual heap metadata");
+        return {{}, metadata_error};
+    }
+
+    return {virtual_heap::make_virtual_heap(
+                reinterpret_cast<uint8_t *>(memory::Layout::VIRTUAL_HEAP),
+                bytes, static_cast<bitmap_heap::bitmap_word *>(metadata),
+                frames),
+            errors::nil()};
+}
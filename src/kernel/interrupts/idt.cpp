@@ -84,6 +84,8 @@ void register_all() {
 
     register_interrupt(Id::DIVIDE_BY_ZERO, isr_divide_by_zero_wrapper,
                        PriviledgeLevel::KERNEL, GateSize::BITS32);
+    register_interrupt(Id::PAGE_FAULT, isr_page_fault_error_code_wrapper,
+                       PriviledgeLevel::KERNEL, GateSize::BITS32);
 
     register_interrupt(Id::PIC_KEYBOARD, isr_pic_keyboard_wrapper,
                        PriviledgeLevel::KERNEL, GateSize::BITS32);
@@ -1,6 +1,8 @@
 #include "drivers/interrupts/pic.hpp"
+#include "drivers/storage/ata.hpp"
 #include "interrupts/idt.hpp"
 #include "logging/logger.hpp"
+#include "memory/paging/faults.hpp"
 
 /**
  * This file should contain all ISR methods.
@@ -14,12 +16,17 @@ extern "C" void isr_divide_by_zero() {
     logging::error("divide by zero");
 }
 
+extern "C" void isr_page_fault(uint32_t error_code) {
+    memory::paging::handle_page_fault(error_code);
+}
+
 extern "C" void isr_pic_timer() {
     drivers::interrupts::pic8259::signal_end_of_interrupt(
         interrupts::Id::PIC_TIMER);
 }
 
 extern "C" void isr_pic_hdd() {
+    drivers::storage::ata::handle_interrupt();
     drivers::interrupts::pic8259::signal_end_of_interrupt(
         interrupts::Id::PIC_HDD);
 }
@@ -1,24 +1,108 @@
 #include "kernel/kernel.hpp"
 
+#include <cstring>
 #include <utility>
 
 #include "interrupts/idt.hpp"
 #include "logging/logger.hpp"
 #include "memory/allocation/allocator.hpp"
 #include "memory/allocation/block_heap.hpp"
+#include "memory/allocation/extent_heap.hpp"
 #include "memory/layout.hpp"
+#include "memory/paging/cache.hpp"
+#include "memory/paging/faults.hpp"
+#include "memory/paging/swap.hpp"
+#include "utilities/arithmetic.hpp"
+#include "utilities/format.hpp"
+#include "utilities/timestamp.hpp"
 
-with_error<kernel> make(allocator* heap) {
-    kernel kernel{.heap = heap,
-                  .boot_disk = {.bus = drivers::storage::ata::Bus::PRIMARY,
-                                .port = drivers::storage::ata::Port::MASTER,
-                                .mode = drivers::storage::ata::Mode::PIO}};
+// The clock cycles a disk read took, and those the processor spent on it.
+struct read_cycles {
+    uint64_t elapsed;
+    uint64_t busy;
+};
+
+// How long an allocator took over a workload, and how fragmented it left
+// the allocator.
+struct workload_result {
+    uint64_t malloc_cycles;
+    uint64_t free_cycles;
+    size_t mallocs;
+    size_t frees;
+    size_t failures;
+    size_t fragmentation;
+};
+
+// Reads sectors of a disk, in one of the transfer modes.
+using SectorsReader = error (*)(drivers::storage::ata::disk* disk,
+                                drivers::storage::ata::sector* buffer,
+                                size_t offset, size_t amount);
+
+// The amount of sectors the disk benchmark reads.
+constexpr size_t MEGABYTE_SECTORS =
+    1024 * 1024 / drivers::storage::ata::SECTOR_SIZE_IN_BYTES;
+
+// The size of the swap disk the makefile creates, in pages.
+constexpr size_t SWAP_SLOTS = 4096;
+
+// Set by the makefile. The benchmarks take a while, and overwrite the start
+// of the swap disk.
+#ifndef BENCHMARKS
+#define BENCHMARKS 0
+#endif
+constexpr bool RUN_BENCHMARKS = BENCHMARKS;
+
+static error map_devices(memory::paging::paging* paging);
+static void log_pci_devices(const drivers::pci::device_table* table);
+[[nodiscard]] static error check_copy_on_write(kernel* kernel);
+static void run_benchmarks(kernel* kernel, bool has_swap_disk);
+static void benchmark_cache_policies(kernel* kernel);
+static void benchmark_allocators(kernel* kernel);
+[[nodiscard]] static workload_result run_mixed_workload(allocator* allocator);
+[[nodiscard]] static size_t pick_allocation_size(uint32_t* random);
+[[nodiscard]] static uint32_t next_random(uint32_t* random);
+static void log_workload(const char* name, const workload_result& result);
+static void benchmark_disk_reads(kernel* kernel);
+static void benchmark_disk_writes(kernel* kernel);
+static void exercise_reclaim(kernel* kernel);
+[[nodiscard]] static with_error<uint64_t> measure_writes(
+    drivers::storage::ata::disk* disk,
+    const drivers::storage::ata::sector* buffer, size_t buffer_sectors,
+    bool flush_each);
+[[nodiscard]] static with_error<read_cycles> measure_reads(
+    drivers::storage::ata::disk* disk, drivers::storage::ata::sector* buffer,
+    size_t buffer_sectors, size_t sectors, SectorsReader read);
+static void log_read_cycles(const char* mode,
+                            const with_error<read_cycles>& cycles);
+[[nodiscard]] static uint64_t measure_cycles(volatile uint32_t* buffer,
+                                             size_t bytes);
+
+with_error<kernel> make(allocator* frames, allocator* heap, allocator* arena,
+                        allocator* virtual_heap) {
+    kernel kernel{.frames = frames,
+                  .heap = heap,
+                  .arena = arena,
+                  .virtual_heap = virtual_heap,
+                  .boot_disk =
+                      {.bus = drivers::storage::ata::Bus::PRIMARY,
+                       .port = drivers::storage::ata::Port::MASTER,
+                       .mode = drivers::storage::ata::Mode::DMA},
+                  .swap_disk = {.bus = drivers::storage::ata::Bus::PRIMARY,
+                                .port = drivers::storage::ata::Port::SLAVE,
+                                .mode = drivers::storage::ata::Mode::DMA}};
 
     interrupts::init();
+    drivers::storage::ata::pio::init_interrupts();
     logging::debug("Initialized interrupts...");
 
+    // Large pages spare the page tables of the identity map, and the TLB
+    // entries of 1024 small pages each.
+    const bool large_pages = memory::paging::supports_large_pages();
+
+    memory::paging::init_cache_policies();
+
     auto [paging, error] =
-        memory::paging::make(kernel.heap,
+        memory::paging::make(kernel.arena,
                              {
                                  memory::paging::PriviledgeLevel::KERNEL,
                                  memory::paging::AccessType::READ_WRITE,
@@ -28,23 +112,97 @@ with_error<kernel> make(allocator* heap) {
                                  memory::paging::PriviledgeLevel::KERNEL,
                                  memory::paging::AccessType::READ_WRITE,
                                  memory::paging::Present::TRUE,
-                             });
+                                 memory::paging::CachePolicy::WRITE_BACK,
+                                 memory::paging::Global::TRUE,
+                             },
+                             large_pages);
     kernel.kernel_paging = paging;
     if (errors::set(error)) {
         errors::enrich(&error, "initialize paging");
         return {kernel, error};
     }
 
+    error = map_devices(&kernel.kernel_paging);
+    if (errors::set(error)) {
+        errors::enrich(&error, "map devices");
+        return {kernel, error};
+    }
+
+    if (large_pages) {
+        memory::paging::enable_large();
+    }
     memory::paging::load(paging);
     memory::paging::enable();
+
+    // Kernel mappings are the same in every address space, so they are
+    // global and stay in the TLB when switching between them.
+    if (memory::paging::supports_global_pages()) {
+        memory::paging::enable_global();
+    }
     logging::debug("Initialized paging...");
 
+    // Without a swap disk, only clean pages can be reclaimed.
+    const bool has_swap_disk =
+        drivers::storage::ata::is_present(&kernel.swap_disk);
+    if (has_swap_disk) {
+        error = memory::paging::swap::init(kernel.swap_disk, 0, SWAP_SLOTS,
+                                           kernel.heap);
+        if (errors::set(error)) {
+            errors::enrich(&error, "initialize swap");
+            return {kernel, error};
+        }
+        logging::debug("Initialized swap...");
+    } else {
+        logging::warn("No swap disk, running without swap");
+    }
+
+    auto [pci_devices, pci_error] = drivers::pci::scan(kernel.heap);
+    if (errors::set(pci_error)) {
+        errors::enrich(&pci_error, "scan PCI buses");
+        return {kernel, pci_error};
+    }
+    kernel.pci_devices = pci_devices;
+    log_pci_devices(&kernel.pci_devices);
+
+    error = drivers::storage::ata::dma::init(&kernel.pci_devices, kernel.heap);
+    if (errors::set(error)) {
+        errors::enrich(&error, "initialize DMA");
+        return {kernel, error};
+    }
+
+    // Swapped pages don't outlive the kernel, so they never need to be
+    // flushed. Swap still works without the cache, only slower.
+    if (has_swap_disk) {
+        error =
+            drivers::storage::ata::set_write_cache(&kernel.swap_disk, true);
+        if (errors::set(error)) {
+            errors::enrich(&error, "enable swap write cache");
+            errors::log(error);
+        }
+    }
+
+    error = check_copy_on_write(&kernel);
+    if (errors::set(error)) {
+        errors::enrich(&error, "check copy on write");
+        errors::log(error);
+    }
+
+    if constexpr (RUN_BENCHMARKS) {
+        run_benchmarks(&kernel, has_swap_disk);
+    }
+
     return {kernel, errors::nil()};
 }
 
 error destroy(kernel* kernel) {
+    error err = drivers::pci::destroy(&kernel->pci_devices);
+    if (errors::set(err)) {
+        errors::enrich(&err, "destroy PCI devices");
+        return err;
+    }
+
     memory::paging::disable();
-    error err = memory::paging::destroy(&kernel->kernel_paging);
+    err = memory::paging::destroy(&kernel->kernel_paging);
     if (errors::set(err)) {
         errors::enrich(&err, "destory paging");
         return err;
@@ -52,3 +210,570 @@ error destroy(kernel* kernel) {
 
     return errors::nil();
 }
+
+error map_devices(memory::paging::paging* paging) {
+    // The text buffer is only written to, except when scrolling, so writes are
+    // combined instead of each going to the device on its own.
+    const void* const video = reinterpret_cast<const void*>(
+        static_cast<size_t>(memory::Layout::VIDEO));
+
+    return memory::paging::map(
+        paging, video, video,
+        {
+            .priviledge_level = memory::paging::PriviledgeLevel::KERNEL,
+            .access_type = memory::paging::AccessType::READ_WRITE,
+            .cache_policy = memory::paging::CachePolicy::WRITE_COMBINING,
+            .global = memory::paging::Global::TRUE,
+        });
+}
+
+void log_pci_devices(const drivers::pci::device_table* table) {
+    constexpr size_t LINE_SIZE = 80;
+
+    for (size_t i = 0; i < drivers::pci::get_count(table); i++) {
+        const drivers::pci::device* const device =
+            drivers::pci::get_device(table, i);
+
+        char line[LINE_SIZE] = "PCI ";
+        utilities::append_hex(line, LINE_SIZE, device->address.bus);
+        utilities::append(line, LINE_SIZE, ":");
+        utilities::append_hex(line, LINE_SIZE, device->address.device);
+        utilities::append(line, LINE_SIZE, ".");
+        utilities::append_decimal(line, LINE_SIZE, device->address.function);
+        utilities::append(line, LINE_SIZE, " ");
+        utilities::append_hex(line, LINE_SIZE, device->vendor_id);
+        utilities::append(line, LINE_SIZE, ":");
+        utilities::append_hex(line, LINE_SIZE, device->device_id);
+        utilities::append(line, LINE_SIZE, " class ");
+        utilities::append_hex(line, LINE_SIZE, device->class_code);
+        utilities::append(line, LINE_SIZE, ".");
+        utilities::append_hex(line, LINE_SIZE, device->subclass);
+        utilities::append(line, LINE_SIZE, " IRQ ");
+        utilities::append_decimal(line, LINE_SIZE, device->interrupt_line);
+        logging::debug(line);
+    }
+}
+
+error check_copy_on_write(kernel* kernel) {
+    constexpr size_t PAGE_SIZE = memory::paging::PAGE_SIZE_IN_BYTES;
+    constexpr uint32_t ORIGINAL = 0x1234;
+    constexpr uint32_t WRITTEN = 0x5678;
+
+    // The heaps are the same in every address space, so the page is taken
+    // from private memory instead.
+    auto [page, region_error] = memory::paging::allocate_region(
+        &kernel->kernel_paging,
+        reinterpret_cast<const void*>(memory::Layout::PRIVATE),
+        reinterpret_cast<const void*>(memory::Layout::PRIVATE_END),
+        {
+            .bytes = PAGE_SIZE,
+            .type = memory::paging::regions::Type::ANONYMOUS,
+            .page_flags =
+                {
+                    .priviledge_level = memory::paging::PriviledgeLevel::KERNEL,
+                    .access_type = memory::paging::AccessType::READ_WRITE,
+                },
+            .frames = kernel->frames,
+        });
+    if (errors::set(region_error)) {
+        errors::enrich(&region_error, "allocate private page");
+        return region_error;
+    }
+
+    volatile uint32_t* const word =
+        static_cast<volatile uint32_t*>(const_cast<void*>(page));
+    *word = ORIGINAL;
+
+    auto [child, clone_error] = memory::paging::clone(&kernel->kernel_paging);
+    if (errors::set(clone_error)) {
+        errors::log(memory::paging::destroy(&child));
+        errors::log(
+            memory::paging::remove_region(&kernel->kernel_paging, page));
+        errors::enrich(&clone_error, "clone kernel paging");
+        return clone_error;
+    }
+
+    // The write faults, since the page became read only in both address
+    // spaces, and gives the kernel a copy of its own.
+    *word = WRITTEN;
+
+    auto [parent_frame, parent_error] =
+        memory::paging::get_physical_address(&kernel->kernel_paging, page);
+    auto [child_frame, child_error] =
+        memory::paging::get_physical_address(&child, page);
+    const bool copied =
+        !errors::set(parent_error) && !errors::set(child_error) &&
+        parent_frame != child_frame &&
+        *static_cast<const volatile uint32_t*>(child_frame) == ORIGINAL;
+
+    // Destroying the clone releases its reference to the original frame.
+    errors::log(memory::paging::destroy(&child));
+    errors::log(memory::paging::remove_region(&kernel->kernel_paging, page));
+
+    if (!copied) {
+        return errors::make(WITH_LOCATION("write didn't copy shared page"));
+    }
+
+    logging::debug("Copy on write works...");
+
+    return errors::nil();
+}
+
+void run_benchmarks(kernel* kernel, bool has_swap_disk) {
+    benchmark_cache_policies(kernel);
+    benchmark_allocators(kernel);
+
+    // The disk benchmarks use the swap disk, since it is the only disk known
+    // to be large enough.
+    if (!has_swap_disk) {
+        logging::warn("No swap disk, skipping disk benchmarks");
+        return;
+    }
+
+    benchmark_disk_reads(kernel);
+    benchmark_disk_writes(kernel);
+    exercise_reclaim(kernel);
+}
+
+void benchmark_cache_policies(kernel* kernel) {
+    constexpr size_t BENCHMARK_BYTES = 64 * 1024;
+    constexpr size_t LINE_SIZE = 80;
+
+    auto [buffer, buffer_error] =
+        try_malloc(kernel->virtual_heap, BENCHMARK_BYTES);
+    if (errors::set(buffer_error)) {
+        errors::enrich(&buffer_error, "allocate benchmark buffer");
+        errors::log(buffer_error);
+        return;
+    }
+
+    volatile uint32_t* const words = static_cast<volatile uint32_t*>(buffer);
+
+    const uint64_t write_back_cycles = measure_cycles(words, BENCHMARK_BYTES);
+
+    // The same frames are measured again through uncached mappings, which is
+    // how all memory was mapped before cache policies.
+    uint64_t uncached_cycles = 0;
+    memory::paging::flags flags{
+        .priviledge_level = memory::paging::PriviledgeLevel::KERNEL,
+        .access_type = memory::paging::AccessType::READ_WRITE,
+        .cache_policy = memory::paging::CachePolicy::UNCACHED,
+        .global = memory::paging::Global::TRUE,
+    };
+    error protect_error = memory::paging::protect(
+        &kernel->kernel_paging, buffer, BENCHMARK_BYTES, flags);
+    if (!errors::set(protect_error)) {
+        uncached_cycles = measure_cycles(words, BENCHMARK_BYTES);
+
+        flags.cache_policy = memory::paging::CachePolicy::WRITE_BACK;
+        protect_error = memory::paging::protect(&kernel->kernel_paging, buffer,
+                                                BENCHMARK_BYTES, flags);
+    }
+
+    free(kernel->virtual_heap, buffer, BENCHMARK_BYTES);
+
+    if (errors::set(protect_error)) {
+        errors::enrich(&protect_error, "change benchmark cache policy");
+        errors::log(protect_error);
+        return;
+    }
+
+    char line[LINE_SIZE] = "Cycles to write and read 64 KiB: write-back ";
+    utilities::append_decimal64(line, LINE_SIZE, write_back_cycles);
+    utilities::append(line, LINE_SIZE, ", uncached ");
+    utilities::append_decimal64(line, LINE_SIZE, uncached_cycles);
+    logging::debug(line);
+}
+
+void benchmark_allocators(kernel* kernel) {
+    namespace block_heap = memory::allocation::block_heap;
+    namespace extent_heap = memory::allocation::extent_heap;
+
+    // Both heaps get the same 1 MiB, one after the other.
+    constexpr size_t BLOCK_SIZE = 64;
+    constexpr size_t BLOCKS = 16 * 1024;
+    constexpr size_t HEAP_BYTES = BLOCK_SIZE * BLOCKS;
+    constexpr size_t TABLE_BYTES = BLOCKS * sizeof(block_heap::block_metadata);
+    constexpr size_t EXTENTS_BYTES = BLOCKS * sizeof(extent_heap::extent);
+    constexpr size_t BENCHMARK_BYTES = HEAP_BYTES + TABLE_BYTES + EXTENTS_BYTES;
+
+    auto [buffer, buffer_error] =
+        try_malloc(kernel->virtual_heap, BENCHMARK_BYTES);
+    if (errors::set(buffer_error)) {
+        errors::enrich(&buffer_error, "allocate benchmark heaps");
+        errors::log(buffer_error);
+        return;
+    }
+
+    uint8_t* const start = static_cast<uint8_t*>(buffer);
+    block_heap::block_metadata* const table =
+        reinterpret_cast<block_heap::block_metadata*>(start + HEAP_BYTES);
+    extent_heap::extent* const extents = reinterpret_cast<extent_heap::extent*>(
+        start + HEAP_BYTES + TABLE_BYTES);
+
+    // The block heap takes a zeroed table to mean every block is free.
+    std::memset(table, 0, TABLE_BYTES);
+    block_heap::block_heap blocks =
+        block_heap::make_block_heap(start, table, BLOCK_SIZE, BLOCKS);
+    allocator blocks_allocator = block_heap::make_allocator(&blocks);
+    log_workload("Block heap", run_mixed_workload(&blocks_allocator));
+
+    extent_heap::extent_heap extent_tree =
+        extent_heap::make_extent_heap(start, extents, BLOCK_SIZE, BLOCKS);
+    allocator extent_tree_allocator = extent_heap::make_allocator(&extent_tree);
+    log_workload("Extent tree", run_mixed_workload(&extent_tree_allocator));
+
+    free(kernel->virtual_heap, buffer, BENCHMARK_BYTES);
+}
+
+workload_result run_mixed_workload(allocator* allocator) {
+    constexpr size_t SLOTS = 256;
+    constexpr size_t STEPS = 16 * 1024;
+    // The same seed gives every allocator the same requests.
+    constexpr uint32_t SEED = 0x2545f491;
+
+    void* allocations[SLOTS] = {};
+    uint32_t random = SEED;
+    workload_result result{};
+
+    // A random slot is freed if it holds an allocation, and filled
+    // otherwise, so about half of the slots stay live.
+    for (size_t step = 0; step < STEPS; step++) {
+        void** const slot = &allocations[next_random(&random) % SLOTS];
+
+        if (*slot != nullptr) {
+            const uint64_t start = utilities::read_cycles();
+            error free_error = try_free(allocator, *slot);
+            result.free_cycles += utilities::read_cycles() - start;
+            result.frees++;
+            errors::log(free_error);
+            *slot = nullptr;
+            continue;
+        }
+
+        const size_t bytes = pick_allocation_size(&random);
+        const uint64_t start = utilities::read_cycles();
+        auto [allocation, allocation_error] = try_malloc(allocator, bytes);
+        result.malloc_cycles += utilities::read_cycles() - start;
+        result.mallocs++;
+        if (errors::set(allocation_error)) {
+            result.failures++;
+            continue;
+        }
+
+        *slot = allocation;
+    }
+
+    // Measured while the workload's allocations are still live.
+    auto [usage, usage_error] = try_get_usage(allocator);
+    if (errors::set(usage_error)) {
+        errors::enrich(&usage_error, "get workload usage");
+        errors::log(usage_error);
+    } else {
+        result.fragmentation = get_fragmentation(usage);
+    }
+
+    for (size_t i = 0; i < SLOTS; i++) {
+        if (allocations[i] != nullptr) {
+            errors::log(try_free(allocator, allocations[i]));
+        }
+    }
+
+    return result;
+}
+
+size_t pick_allocation_size(uint32_t* random) {
+    // Mostly small objects, some buffers of a few pages, and the occasional
+    // large table, like the kernel heap sees.
+    const uint32_t kind = next_random(random) % 16;
+    if (kind < 12) {
+        return 16 + next_random(random) % 496;
+    }
+
+    if (kind < 15) {
+        return 1024 + next_random(random) % (7 * 1024);
+    }
+
+    return 16 * 1024 + next_random(random) % (48 * 1024);
+}
+
+uint32_t next_random(uint32_t* random) {
+    // Xorshift - cheap, and good enough to spread the requests.
+    uint32_t value = *random;
+    value ^= value << 13;
+    value ^= value >> 17;
+    value ^= value << 5;
+    *random = value;
+
+    return value;
+}
+
+void log_workload(const char* name, const workload_result& result) {
+    constexpr size_t LINE_SIZE = 80;
+
+    const uint64_t malloc_cycles =
+        result.mallocs == 0
+            ? 0
+            : utilities::divide(result.malloc_cycles, result.mallocs);
+    const uint64_t free_cycles =
+        result.frees == 0 ? 0
+                          : utilities::divide(result.free_cycles, result.frees);
+
+    char line[LINE_SIZE] = "";
+    utilities::append(line, LINE_SIZE, name);
+    utilities::append(line, LINE_SIZE, ": malloc ");
+    utilities::append_decimal64(line, LINE_SIZE, malloc_cycles);
+    utilities::append(line, LINE_SIZE, " cycles, free ");
+    utilities::append_decimal64(line, LINE_SIZE, free_cycles);
+    utilities::append(line, LINE_SIZE, ", ");
+    utilities::append_decimal(line, LINE_SIZE, result.fragmentation);
+    utilities::append(line, LINE_SIZE, "% fragmented, ");
+    utilities::append_decimal(line, LINE_SIZE, result.failures);
+    utilities::append(line, LINE_SIZE, " failed");
+    logging::debug(line);
+}
+
+void benchmark_disk_reads(kernel* kernel) {
+    namespace ata = drivers::storage::ata;
+
+    constexpr size_t BUFFER_SECTORS = 128;
+
+    auto [buffer, buffer_error] = try_malloc(
+        kernel->virtual_heap, BUFFER_SECTORS * ata::SECTOR_SIZE_IN_BYTES);
+    if (errors::set(buffer_error)) {
+        errors::enrich(&buffer_error, "allocate benchmark buffer");
+        errors::log(buffer_error);
+        return;
+    }
+
+    ata::disk disk = kernel->swap_disk;
+    ata::sector* const sectors = static_cast<ata::sector*>(buffer);
+
+    // The same sectors are read into the same buffer in every mode. Moving
+    // each word with its own in instruction is measured next to rep insw.
+    disk.mode = ata::Mode::PIO;
+    log_read_cycles("PIO per word",
+                    measure_reads(&disk, sectors, BUFFER_SECTORS,
+                                  MEGABYTE_SECTORS,
+                                  ata::pio::read_sectors_by_word));
+    log_read_cycles("PIO polling",
+                    measure_reads(&disk, sectors, BUFFER_SECTORS,
+                                  MEGABYTE_SECTORS, ata::read_sectors));
+
+    disk.mode = ata::Mode::PIO_INTERRUPTS;
+    log_read_cycles("PIO interrupts",
+                    measure_reads(&disk, sectors, BUFFER_SECTORS,
+                                  MEGABYTE_SECTORS, ata::read_sectors));
+
+    if (ata::dma::is_available()) {
+        disk.mode = ata::Mode::DMA;
+        log_read_cycles("DMA",
+                        measure_reads(&disk, sectors, BUFFER_SECTORS,
+                                      MEGABYTE_SECTORS, ata::read_sectors));
+    }
+
+    free(kernel->virtual_heap, buffer,
+         BUFFER_SECTORS * ata::SECTOR_SIZE_IN_BYTES);
+}
+
+with_error<read_cycles> measure_reads(drivers::storage::ata::disk* disk,
+                                      drivers::storage::ata::sector* buffer,
+                                      size_t buffer_sectors, size_t sectors,
+                                      SectorsReader read) {
+    // The buffer is touched first, so faulting its pages in isn't counted.
+    std::memset(buffer, 0,
+                buffer_sectors * drivers::storage::ata::SECTOR_SIZE_IN_BYTES);
+
+    const uint64_t start = utilities::read_cycles();
+    const uint64_t idle_start = drivers::storage::ata::get_idle_cycles();
+
+    for (size_t offset = 0; offset < sectors; offset += buffer_sectors) {
+        error read_error = read(disk, buffer, offset, buffer_sectors);
+        if (errors::set(read_error)) {
+            return {{}, read_error};
+        }
+    }
+
+    // Cycles spent halted were free for other work.
+    const uint64_t elapsed = utilities::read_cycles() - start;
+    const uint64_t idle = drivers::storage::ata::get_idle_cycles() - idle_start;
+    return {{.elapsed = elapsed, .busy = elapsed - idle}, errors::nil()};
+}
+
+void benchmark_disk_writes(kernel* kernel) {
+    namespace ata = drivers::storage::ata;
+
+    // Writes the size of a page, as swap makes them.
+    constexpr size_t BUFFER_SECTORS = 8;
+    constexpr size_t LINE_SIZE = 80;
+
+    auto [buffer, buffer_error] = try_malloc(
+        kernel->virtual_heap, BUFFER_SECTORS * ata::SECTOR_SIZE_IN_BYTES);
+    if (errors::set(buffer_error)) {
+        errors::enrich(&buffer_error, "allocate benchmark buffer");
+        errors::log(buffer_error);
+        return;
+    }
+
+    // Nothing is swapped out yet, so the swap disk can be overwritten.
+    ata::disk disk = kernel->swap_disk;
+    const ata::sector* const sectors = static_cast<ata::sector*>(buffer);
+
+    auto [each_cycles, each_error] =
+        measure_writes(&disk, sectors, BUFFER_SECTORS, true);
+    auto [once_cycles, once_error] =
+        measure_writes(&disk, sectors, BUFFER_SECTORS, false);
+
+    free(kernel->virtual_heap, buffer,
+         BUFFER_SECTORS * ata::SECTOR_SIZE_IN_BYTES);
+
+    if (errors::set(each_error) || errors::set(once_error)) {
+        error write_error = errors::set(each_error) ? each_error : once_error;
+        errors::enrich(&write_error, "benchmark disk writes");
+        errors::log(write_error);
+        return;
+    }
+
+    char line[LINE_SIZE] = "Cycles per MiB written: flush per page ";
+    utilities::append_decimal64(line, LINE_SIZE, each_cycles);
+    utilities::append(line, LINE_SIZE, ", flush once ");
+    utilities::append_decimal64(line, LINE_SIZE, once_cycles);
+    logging::debug(line);
+}
+
+void exercise_reclaim(kernel* kernel) {
+    constexpr size_t PAGE_SIZE = memory::paging::PAGE_SIZE_IN_BYTES;
+    constexpr size_t PAGE_SIZE_IN_WORDS = PAGE_SIZE / sizeof(uint32_t);
+    constexpr size_t MEGABYTE = 1024 * 1024;
+    constexpr size_t LINE_SIZE = 80;
+
+    auto [frames, usage_error] = try_get_usage(kernel->frames);
+    if (errors::set(usage_error)) {
+        errors::enrich(&usage_error, "get frame usage");
+        errors::log(usage_error);
+        return;
+    }
+
+    // Writing more pages than there are free frames makes reclaim swap the
+    // rest out, while half of swap leaves room for them. Run with a small
+    // MEMORY for a quick run.
+    const size_t pages = frames.free_bytes / PAGE_SIZE + SWAP_SLOTS / 2;
+
+    auto [buffer, buffer_error] =
+        try_malloc(kernel->virtual_heap, pages * PAGE_SIZE);
+    if (errors::set(buffer_error)) {
+        errors::enrich(&buffer_error, "allocate reclaim buffer");
+        errors::log(buffer_error);
+        return;
+    }
+
+    volatile uint32_t* const words = static_cast<volatile uint32_t*>(buffer);
+    const memory::paging::swap::statistics before =
+        memory::paging::swap::get_statistics();
+
+    for (size_t page = 0; page < pages; page++) {
+        words[page * PAGE_SIZE_IN_WORDS] = page;
+    }
+
+    // Pages that were swapped out are read back.
+    size_t lost = 0;
+    for (size_t page = 0; page < pages; page++) {
+        if (words[page * PAGE_SIZE_IN_WORDS] != page) {
+            lost++;
+        }
+    }
+
+    const memory::paging::swap::statistics after =
+        memory::paging::swap::get_statistics();
+
+    free(kernel->virtual_heap, buffer, pages * PAGE_SIZE);
+
+    char line[LINE_SIZE] = "Reclaim over ";
+    utilities::append_decimal(line, LINE_SIZE, pages * PAGE_SIZE / MEGABYTE);
+    utilities::append(line, LINE_SIZE, " MiB: evicted ");
+    utilities::append_decimal(line, LINE_SIZE, after.evicted - before.evicted);
+    utilities::append(line, LINE_SIZE, ", out ");
+    utilities::append_decimal(line, LINE_SIZE,
+                              after.swapped_out - before.swapped_out);
+    utilities::append(line, LINE_SIZE, ", in ");
+    utilities::append_decimal(line, LINE_SIZE,
+                              after.swapped_in - before.swapped_in);
+    utilities::append(line, LINE_SIZE, ", lost ");
+    utilities::append_decimal(line, LINE_SIZE, lost);
+    logging::debug(line);
+}
+
+with_error<uint64_t> measure_writes(
+    drivers::storage::ata::disk* disk,
+    const drivers::storage::ata::sector* buffer, size_t buffer_sectors,
+    bool flush_each) {
+    const uint64_t start = utilities::read_cycles();
+
+    for (size_t offset = 0; offset < MEGABYTE_SECTORS;
+         offset += buffer_sectors) {
+        error write_error = drivers::storage::ata::write_sectors(
+            disk, buffer, offset, buffer_sectors);
+        if (errors::set(write_error)) {
+            return {0, write_error};
+        }
+
+        if (!flush_each) {
+            continue;
+        }
+
+        error flush_error = drivers::storage::ata::flush(disk);
+        if (errors::set(flush_error)) {
+            return {0, flush_error};
+        }
+    }
+
+    error flush_error = drivers::storage::ata::flush(disk);
+    if (errors::set(flush_error)) {
+        return {0, flush_error};
+    }
+
+    return {utilities::read_cycles() - start, errors::nil()};
+}
+
+void log_read_cycles(const char* mode,
+                     const with_error<read_cycles>& measurement) {
+    constexpr size_t LINE_SIZE = 80;
+
+    auto [cycles, read_error] = measurement;
+    if (errors::set(read_error)) {
+        errors::enrich(&read_error, "benchmark disk reads");
+        errors::log(read_error);
+        return;
+    }
+
+    char line[LINE_SIZE] = "";
+    utilities::append(line, LINE_SIZE, mode);
+    utilities::append(line, LINE_SIZE, ": ");
+    utilities::append_decimal64(line, LINE_SIZE, cycles.elapsed);
+    utilities::append(line, LINE_SIZE, " cycles/MiB, ");
+    utilities::append_decimal64(line, LINE_SIZE, cycles.busy);
+    utilities::append(line, LINE_SIZE, " on CPU, ");
+    utilities::append_decimal64(
+        line, LINE_SIZE, utilities::divide(cycles.elapsed, MEGABYTE_SECTORS));
+    utilities::append(line, LINE_SIZE, " per sector");
+    logging::debug(line);
+}
+
+uint64_t measure_cycles(volatile uint32_t* buffer, size_t bytes) {
+    const size_t words = bytes / sizeof(uint32_t);
+    const uint64_t start = utilities::read_cycles();
+
+    for (size_t i = 0; i < words; i++) {
+        buffer[i] = i;
+    }
+
+    uint32_t sum = 0;
+    for (size_t i = 0; i < words; i++) {
+        sum += buffer[i];
+    }
+
+    // The sum is only computed so the reads aren't dropped.
+    buffer[0] = sum;
+
+    return utilities::read_cycles() - start;
+}
@@ -0,0 +1,50 @@
+#include "memory/allocation/alignment.hpp"
+
+namespace memory::allocation {
+
+bool is_power_of_two(size_t value) {
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+size_t align_up(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+bool is_aligned(const void *address, size_t alignment) {
+    return (reinterpret_cast<uintptr_t>(address) & (alignment - 1)) == 0;
+}
+
+with_error<block_alignment> get_block_alignment(const uint8_t *start,
+                                                size_t block_size,
+                                                size_t alignment) {
+    if (!is_power_of_two(alignment) || !is_power_of_two(block_size)) {
+        return {{}, errors::make(WITH_LOCATION(
+                        "alignment and block size must be powers of two"))};
+    }
+
+    const size_t misalignment =
+        reinterpret_cast<uintptr_t>(start) & (alignment - 1);
+
+    // Since both are powers of two, one of them divides the other.
+    if (alignment <= block_size) {
+        if (misalignment != 0) {
+            return {{},
+                    errors::make(WITH_LOCATION(
+                        "heap start is not aligned to requested alignment"))};
+        }
+
+        return {{.first = 0, .stride = 1}, errors::nil()};
+    }
+
+    const size_t distance_to_aligned = (alignment - misalignment) % alignment;
+    if (distance_to_aligned % block_size != 0) {
+        return {{}, errors::make(WITH_LOCATION(
+                        "heap start is not aligned to block size"))};
+    }
+
+    return {{.first = distance_to_aligned / block_size,
+             .stride = alignment / block_size},
+            errors::nil()};
+}
+
+}  // namespace memory::allocation
@@ -1,26 +1,191 @@
 #include "memory/allocation/allocator.hpp"
 
 #include <cassert>
+#include <cstring>
+
+#include "memory/allocation/alignment.hpp"
 
 namespace memory::allocation {
 
+// Fixed point fragmentation calculations must not overflow 32 bits.
+constexpr size_t MAX_EXACT_FRAGMENTATION_BYTES = 1 << 25;
+
+static with_error<void *> dispatch_aligned_malloc(allocator *self,
+                                                  size_t size,
+                                                  size_t alignment);
+static error dispatch_sized_free(allocator *self, const void *allocation,
+                                 size_t size);
+static with_error<void *> dispatch_realloc(allocator *self, void *allocation,
+                                           size_t size, size_t new_size);
+
+static const void *call_site = nullptr;
+
 void *malloc(allocator *self, size_t size) {
+    call_site = __builtin_return_address(0);
     auto [allocation, error] = self->_malloc(self->self, size);
     assertm(!errors::set(error), "failed to allocate memory");
     return allocation;
 }
 
 with_error<void *> try_malloc(allocator *self, size_t size) {
+    call_site = __builtin_return_address(0);
     return self->_malloc(self->self, size);
 }
 
 void free(allocator *self, const void *allocation) {
+    call_site = __builtin_return_address(0);
     error error = self->_free(self->self, allocation);
     assertm(!errors::set(error), "failed to free memory");
 }
 
 error try_free(allocator *self, const void *allocation) {
+    call_site = __builtin_return_address(0);
     return self->_free(self->self, allocation);
 }
 
+void *aligned_malloc(allocator *self, size_t size, size_t alignment) {
+    call_site = __builtin_return_address(0);
+    auto [allocation, error] = dispatch_aligned_malloc(self, size, alignment);
+    assertm(!errors::set(error), "failed to allocate aligned memory");
+    return allocation;
+}
+
+with_error<void *> try_aligned_malloc(allocator *self, size_t size,
+                                      size_t alignment) {
+    call_site = __builtin_return_address(0);
+    return dispatch_aligned_malloc(self, size, alignment);
+}
+
+void free(allocator *self, const void *allocation, size_t size) {
+    call_site = __builtin_return_address(0);
+    error error = dispatch_sized_free(self, allocation, size);
+    assertm(!errors::set(error), "failed to free memory");
+}
+
+error try_free(allocator *self, const void *allocation, size_t size) {
+    call_site = __builtin_return_address(0);
+    return dispatch_sized_free(self, allocation, size);
+}
+
+error try_grow_in_place(allocator *self, const void *allocation, size_t size,
+                        size_t new_size) {
+    if (self->_grow_in_place == nullptr) {
+        return errors::make(
+            WITH_LOCATION("allocator doesn't support growing in place"));
+    }
+
+    return self->_grow_in_place(self->self, allocation, size, new_size);
+}
+
+void *realloc(allocator *self, void *allocation, size_t size,
+              size_t new_size) {
+    call_site = __builtin_return_address(0);
+    auto [reallocation, error] =
+        dispatch_realloc(self, allocation, size, new_size);
+    assertm(!errors::set(error), "failed to reallocate memory");
+    return reallocation;
+}
+
+with_error<void *> try_realloc(allocator *self, void *allocation, size_t size,
+                               size_t new_size) {
+    call_site = __builtin_return_address(0);
+    return dispatch_realloc(self, allocation, size, new_size);
+}
+
+with_error<size_t> try_get_size(allocator *self, const void *allocation) {
+    if (self->_get_size == nullptr) {
+        return {0, errors::make(WITH_LOCATION(
+                       "allocator doesn't support size queries"))};
+    }
+
+    return self->_get_size(self->self, allocation);
+}
+
+with_error<usage> try_get_usage(allocator *self) {
+    if (self->_get_usage == nullptr) {
+        return {{}, errors::make(WITH_LOCATION(
+                        "allocator doesn't support usage queries"))};
+    }
+
+    return {self->_get_usage(self->self), errors::nil()};
+}
+
+size_t get_fragmentation(const usage &usage) {
+    size_t free_bytes = usage.free_bytes;
+    size_t largest_free_bytes = usage.largest_free_bytes;
+
+    if (free_bytes == 0) {
+        return 0;
+    }
+
+    while (free_bytes > MAX_EXACT_FRAGMENTATION_BYTES) {
+        free_bytes >>= 1;
+        largest_free_bytes >>= 1;
+    }
+
+    return 100 - (largest_free_bytes * 100) / free_bytes;
+}
+
+const void *get_call_site() {
+    return call_site;
+}
+
+with_error<void *> dispatch_aligned_malloc(allocator *self, size_t size,
+                                           size_t alignment) {
+    if (!is_power_of_two(alignment)) {
+        return {nullptr, errors::make(WITH_LOCATION(
+                             "alignment must be a power of two"))};
+    }
+
+    if (self->_aligned_malloc != nullptr) {
+        return self->_aligned_malloc(self->self, size, alignment);
+    }
+
+    auto [allocation, error] = self->_malloc(self->self, size);
+    if (errors::set(error)) {
+        return {nullptr, error};
+    }
+
+    if (!is_aligned(allocation, alignment)) {
+        self->_free(self->self, allocation);
+        return {nullptr, errors::make(WITH_LOCATION(
+                             "allocator doesn't support alignment"))};
+    }
+
+    return {allocation, errors::nil()};
+}
+
+error dispatch_sized_free(allocator *self, const void *allocation,
+                          size_t size) {
+    if (self->_sized_free != nullptr) {
+        return self->_sized_free(self->self, allocation, size);
+    }
+
+    return self->_free(self->self, allocation);
+}
+
+with_error<void *> dispatch_realloc(allocator *self, void *allocation,
+                                    size_t size, size_t new_size) {
+    if (!errors::set(try_grow_in_place(self, allocation, size, new_size))) {
+        return {allocation, errors::nil()};
+    }
+
+    auto [reallocation, error] = self->_malloc(self->self, new_size);
+    if (errors::set(error)) {
+        errors::enrich(&error, "allocate new memory");
+        return {nullptr, error};
+    }
+
+    std::memcpy(reallocation, allocation, size < new_size ? size : new_size);
+
+    error = dispatch_sized_free(self, allocation, size);
+    if (errors::set(error)) {
+        errors::enrich(&error, "free old memory");
+        dispatch_sized_free(self, reallocation, new_size);
+        return {nullptr, error};
+    }
+
+    return {reallocation, errors::nil()};
+}
+
 }  // namespace memory::allocation
@@ -0,0 +1,218 @@
+#include "memory/allocation/arena.hpp"
+
+#include "memory/allocation/alignment.hpp"
+
+namespace memory::allocation::arena {
+
+static with_error<void *> malloc(arena *arena, size_t bytes);
+static with_error<void *> aligned_malloc(arena *arena, size_t bytes,
+                                         size_t alignment);
+static error free(arena *arena, const void *allocation);
+static error sized_free(arena *arena, const void *allocation, size_t bytes);
+static error grow_in_place(arena *arena, const void *allocation, size_t bytes,
+                           size_t new_bytes);
+static with_error<chunk *> make_chunk(arena *arena, size_t bytes,
+                                      size_t alignment);
+[[nodiscard]] static uint8_t *align_pointer(uint8_t *pointer,
+                                            size_t alignment);
+[[nodiscard]] static uint8_t *get_first_byte(chunk *chunk);
+static error pop_chunk(arena *arena);
+
+arena make_arena(::memory::allocation::allocator *backing, size_t chunk_size) {
+    return arena{
+        .malloc = malloc,
+        .free = free,
+        ._backing = backing,
+        ._chunk_size = chunk_size,
+        ._current = nullptr,
+    };
+}
+
+::memory::allocation::allocator make_allocator(arena *arena) {
+    return ::memory::allocation::allocator{
+        .self = arena,
+        ._malloc = reinterpret_cast<MallocType>(malloc),
+        ._free = reinterpret_cast<FreeType>(free),
+        ._aligned_malloc = reinterpret_cast<AlignedMallocType>(aligned_malloc),
+        ._sized_free = reinterpret_cast<SizedFreeType>(sized_free),
+        ._grow_in_place = reinterpret_cast<GrowInPlaceType>(grow_in_place),
+    };
+}
+
+marker get_marker(const arena *arena) {
+    return marker{
+        .current = arena->_current,
+        .top = arena->_current != nullptr ? arena->_current->top : nullptr,
+    };
+}
+
+error rewind(arena *arena, const marker &marker) {
+    while (arena->_current != marker.current) {
+        if (arena->_current == nullptr) {
+            return errors::make(
+                WITH_LOCATION("marker doesn't belong to the arena"));
+        }
+
+        error error = pop_chunk(arena);
+        if (errors::set(error)) {
+            errors::enrich(&error, "free chunk");
+            return error;
+        }
+    }
+
+    if (arena->_current != nullptr) {
+        arena->_current->top = marker.top;
+    }
+
+    return errors::nil();
+}
+
+error reset(arena *arena) {
+    if (arena->_current == nullptr) {
+        return errors::nil();
+    }
+
+    while (arena->_current->previous != nullptr) {
+        error error = pop_chunk(arena);
+        if (errors::set(error)) {
+            errors::enrich(&error, "free chunk");
+            return error;
+        }
+    }
+
+    arena->_current->top = get_first_byte(arena->_current);
+
+    return errors::nil();
+}
+
+error destroy(arena *arena) {
+    while (arena->_current != nullptr) {
+        error error = pop_chunk(arena);
+        if (errors::set(error)) {
+            errors::enrich(&error, "free chunk");
+            return error;
+        }
+    }
+
+    return errors::nil();
+}
+
+with_error<void *> malloc(arena *arena, size_t bytes) {
+    return aligned_malloc(arena, bytes, DEFAULT_ALIGNMENT);
+}
+
+with_error<void *> aligned_malloc(arena *arena, size_t bytes,
+                                  size_t alignment) {
+    if (bytes == 0) {
+        return {nullptr, errors::make(WITH_LOCATION("can't allocate 0 bytes"))};
+    }
+
+    if (!is_power_of_two(alignment)) {
+        return {nullptr, errors::make(WITH_LOCATION(
+                             "alignment must be a power of two"))};
+    }
+
+    chunk *current = arena->_current;
+    uint8_t *allocation = nullptr;
+
+    if (current != nullptr) {
+        allocation = align_pointer(current->top, alignment);
+    }
+
+    if (current == nullptr || allocation > current->end ||
+        static_cast<size_t>(current->end - allocation) < bytes) {
+        auto [new_chunk, error] = make_chunk(arena, bytes, alignment);
+        if (errors::set(error)) {
+            errors::enrich(&error, "make chunk");
+            return {nullptr, error};
+        }
+
+        current = new_chunk;
+        allocation = align_pointer(current->top, alignment);
+    }
+
+    current->top = allocation + bytes;
+
+    return {allocation, errors::nil()};
+}
+
+error free(arena *, const void *) {
+    return errors::nil();
+}
+
+error sized_free(arena *arena, const void *allocation, size_t bytes) {
+    chunk *const current = arena->_current;
+
+    // The most recent allocation can be taken back, which makes the arena
+    // behave like a stack for short lived allocations.
+    if (current != nullptr &&
+        static_cast<const uint8_t *>(allocation) + bytes == current->top) {
+        current->top = const_cast<uint8_t *>(
+            static_cast<const uint8_t *>(allocation));
+    }
+
+    return errors::nil();
+}
+
+error grow_in_place(arena *arena, const void *allocation, size_t bytes,
+                    size_t new_bytes) {
+    chunk *const current = arena->_current;
+    const uint8_t *const allocation_ = static_cast<const uint8_t *>(allocation);
+
+    if (current == nullptr || allocation_ + bytes != current->top) {
+        return errors::make(
+            WITH_LOCATION("only the most recent allocation can grow"));
+    }
+
+    if (new_bytes > static_cast<size_t>(current->end - allocation_)) {
+        return errors::make(
+            WITH_LOCATION("new size doesn't fit in the current chunk"));
+    }
+
+    if (new_bytes > bytes) {
+        current->top = const_cast<uint8_t *>(allocation_) + new_bytes;
+    }
+
+    return errors::nil();
+}
+
+with_error<chunk *> make_chunk(arena *arena, size_t bytes, size_t alignment) {
+    // Leave room for aligning the allocation after the header.
+    const size_t required = sizeof(chunk) + alignment - 1 + bytes;
+    const size_t chunk_size =
+        required > arena->_chunk_size ? required : arena->_chunk_size;
+
+    auto [allocation, error] = try_malloc(arena->_backing, chunk_size);
+    if (errors::set(error)) {
+        errors::enrich(&error, "allocate from backing allocator");
+        return {nullptr, error};
+    }
+
+    chunk *const new_chunk = static_cast<chunk *>(allocation);
+    new_chunk->previous = arena->_current;
+    new_chunk->top = get_first_byte(new_chunk);
+    new_chunk->end = static_cast<uint8_t *>(allocation) + chunk_size;
+    arena->_current = new_chunk;
+
+    return {new_chunk, errors::nil()};
+}
+
+uint8_t *align_pointer(uint8_t *pointer, size_t alignment) {
+    return reinterpret_cast<uint8_t *>(
+        align_up(reinterpret_cast<uintptr_t>(pointer), alignment));
+}
+
+uint8_t *get_first_byte(chunk *chunk) {
+    return reinterpret_cast<uint8_t *>(chunk) + sizeof(struct chunk);
+}
+
+error pop_chunk(arena *arena) {
+    chunk *const popped = arena->_current;
+    arena->_current = popped->previous;
+
+    return try_free(arena->_backing, popped,
+                    static_cast<size_t>(popped->end -
+                                        reinterpret_cast<uint8_t *>(popped)));
+}
+
+}  // namespace memory::allocation::arena
@@ -0,0 +1,606 @@
+#include "memory/allocation/bitmap_heap.hpp"
+
+#include <cstring>
+
+#include "memory/allocation/alignment.hpp"
+#include "utilities/bitranges.hpp"
+
+namespace memory::allocation::bitmap_heap {
+
+constexpr bitmap_word ALL_UNUSED = 0;
+constexpr bitmap_word ALL_USED = ~ALL_UNUSED;
+
+static with_error<void *> malloc(bitmap_heap *heap, size_t bytes);
+static with_error<void *> aligned_malloc(bitmap_heap *heap, size_t bytes,
+                                         size_t alignment);
+static error free(bitmap_heap *heap, const void *allocation);
+static error sized_free(bitmap_heap *heap, const void *allocation,
+                        size_t bytes);
+static error grow_in_place(bitmap_heap *heap, const void *allocation,
+                           size_t bytes, size_t new_bytes);
+static with_error<size_t> get_size(bitmap_heap *heap, const void *allocation);
+static usage get_usage(bitmap_heap *heap);
+static with_error<void *> allocate(bitmap_heap *heap, size_t bytes,
+                                   const block_alignment &alignment);
+static with_error<size_t> get_offset(bitmap_heap *heap,
+                                     const void *allocation);
+static error check_bounds(bitmap_heap *heap, size_t offset, size_t blocks);
+static void release(bitmap_heap *heap, size_t offset, size_t blocks);
+static size_t divide_round_up(size_t a, size_t b);
+static with_error<size_t> find_aligned_offset(
+    bitmap_heap *heap, size_t blocks, const block_alignment &alignment);
+static with_error<size_t> find_allocation_offset(bitmap_heap *heap,
+                                                 size_t blocks, size_t from);
+static with_error<size_t> find_last_block(bitmap_heap *heap, size_t first);
+[[nodiscard]] static bool get_bit(const bitmap_word *bitmap, size_t offset);
+static void set_bits(bitmap_word *bitmap, size_t offset, size_t count);
+static void clear_bits(bitmap_word *bitmap, size_t offset, size_t count);
+[[nodiscard]] static bool are_bits_set(const bitmap_word *bitmap,
+                                       size_t offset, size_t count);
+[[nodiscard]] static bool are_bits_clear(const bitmap_word *bitmap,
+                                         size_t offset, size_t count);
+[[nodiscard]] static bitmap_word make_mask(size_t offset, size_t count);
+[[nodiscard]] static size_t count_bits(bitmap_word word);
+[[nodiscard]] static size_t clamp_blocks(const bitmap_heap *heap, size_t offset,
+                                         size_t blocks);
+
+size_t metadata_words(size_t blocks) {
+    constexpr size_t BITMAPS = 3;
+    return BITMAPS * divide_round_up(blocks, BITS_PER_WORD);
+}
+
+bitmap_heap make_bitmap_heap(uint8_t *start, bitmap_word *metadata,
+                             size_t block_size, size_t blocks) {
+    const size_t words = divide_round_up(blocks, BITS_PER_WORD);
+
+    bitmap_heap heap{
+        .malloc = malloc,
+        .free = free,
+        ._start = start,
+        ._used = metadata,
+        ._first = metadata + words,
+        ._last = metadata + 2 * words,
+        ._block_size = block_size,
+        ._blocks = blocks,
+        ._used_blocks = 0,
+    };
+
+    std::memset(metadata, 0, metadata_words(blocks) * sizeof(bitmap_word));
+
+    // Bits past the end of the heap are marked as used so that the search
+    // never has to check whether a run exceeds the heap.
+    const size_t padding = words * BITS_PER_WORD - blocks;
+    if (padding != 0) {
+        set_bits(heap._used, blocks, padding);
+    }
+
+    return heap;
+}
+
+::memory::allocation::allocator make_allocator(bitmap_heap *heap) {
+    return ::memory::allocation::allocator{
+        .self = heap,
+        ._malloc = reinterpret_cast<MallocType>(malloc),
+        ._free = reinterpret_cast<FreeType>(free),
+        ._aligned_malloc = reinterpret_cast<AlignedMallocType>(aligned_malloc),
+        ._sized_free = reinterpret_cast<SizedFreeType>(sized_free),
+        ._grow_in_place = reinterpret_cast<GrowInPlaceType>(grow_in_place),
+        ._get_size = reinterpret_cast<GetSizeType>(get_size),
+        ._get_usage = reinterpret_cast<GetUsageType>(get_usage),
+    };
+}
+
+void reserve(bitmap_heap *heap, size_t offset, size_t blocks) {
+    blocks = clamp_blocks(heap, offset, blocks);
+
+    while (blocks > 0) {
+        const size_t word_index = offset / BITS_PER_WORD;
+        const size_t bit = offset % BITS_PER_WORD;
+        const size_t bits =
+            blocks < BITS_PER_WORD - bit ? blocks : BITS_PER_WORD - bit;
+        const bitmap_word mask = make_mask(bit, bits);
+
+        heap->_used_blocks += count_bits(mask & ~heap->_used[word_index]);
+        heap->_used[word_index] |= mask;
+        heap->_first[word_index] |= mask;
+        heap->_last[word_index] |= mask;
+
+        offset += bits;
+        blocks -= bits;
+    }
+}
+
+void unreserve(bitmap_heap *heap, size_t offset, size_t blocks) {
+    blocks = clamp_blocks(heap, offset, blocks);
+
+    while (blocks > 0) {
+        const size_t word_index = offset / BITS_PER_WORD;
+        const size_t bit = offset % BITS_PER_WORD;
+        const size_t bits =
+            blocks < BITS_PER_WORD - bit ? blocks : BITS_PER_WORD - bit;
+        const bitmap_word mask = make_mask(bit, bits);
+
+        heap->_used_blocks -= count_bits(mask & heap->_used[word_index]);
+        heap->_used[word_index] &= ~mask;
+        heap->_first[word_index] &= ~mask;
+        heap->_last[word_index] &= ~mask;
+
+        offset += bits;
+        blocks -= bits;
+    }
+}
+
+bool is_free(const bitmap_heap *heap, size_t offset, size_t blocks) {
+    if (clamp_blocks(heap, offset, blocks) != blocks) {
+        return false;
+    }
+
+    return are_bits_clear(heap->_used, offset, blocks);
+}
+
+with_error<void *> malloc(bitmap_heap *heap, size_t bytes) {
+    return allocate(heap, bytes, block_alignment{.first = 0, .stride = 1});
+}
+
+with_error<void *> aligned_malloc(bitmap_heap *heap, size_t bytes,
+                                  size_t alignment) {
+    auto [aligned_blocks, error] =
+        get_block_alignment(heap->_start, heap->_block_size, alignment);
+    if (errors::set(error)) {
+        errors::enrich(&error, "get block alignment");
+        return {nullptr, error};
+    }
+
+    return allocate(heap, bytes, aligned_blocks);
+}
+
+error free(bitmap_heap *heap, const void *allocation) {
+    auto [first, error] = get_offset(heap, allocation);
+    if (errors::set(error)) {
+        return error;
+    }
+
+    if (!get_bit(heap->_first, first)) {
+        return errors::make(
+            WITH_LOCATION("first block in allocation isn't marked as first"));
+    }
+
+    auto [last, last_error] = find_last_block(heap, first);
+    if (errors::set(last_error)) {
+        errors::enrich(&last_error, "find last block");
+        return last_error;
+    }
+
+    const size_t blocks = last - first + 1;
+    if (!are_bits_set(heap->_used, first, blocks)) {
+        return errors::make(
+            WITH_LOCATION("unused block in the middle of an allocation"));
+    }
+
+    release(heap, first, blocks);
+
+    return errors::nil();
+}
+
+error sized_free(bitmap_heap *heap, const void *allocation, size_t bytes) {
+    auto [offset, error] = get_offset(heap, allocation);
+    if (errors::set(error)) {
+        return error;
+    }
+
+    const size_t blocks = divide_round_up(bytes, heap->_block_size);
+    error = check_bounds(heap, offset, blocks);
+    if (errors::set(error)) {
+        return error;
+    }
+
+    release(heap, offset, blocks);
+
+    return errors::nil();
+}
+
+error grow_in_place(bitmap_heap *heap, const void *allocation, size_t bytes,
+                    size_t new_bytes) {
+    auto [offset, error] = get_offset(heap, allocation);
+    if (errors::set(error)) {
+        return error;
+    }
+
+    const size_t blocks = divide_round_up(bytes, heap->_block_size);
+    error = check_bounds(heap, offset, blocks);
+    if (errors::set(error)) {
+        return error;
+    }
+
+    const size_t new_blocks = divide_round_up(new_bytes, heap->_block_size);
+    if (new_blocks == 0) {
+        return errors::make(WITH_LOCATION("can't shrink to 0 bytes"));
+    }
+
+    // The blocks past the new end are freed, so the allocation can later be
+    // freed with its new size.
+    if (new_blocks <= blocks) {
+        clear_bits(heap->_used, offset + new_blocks, blocks - new_blocks);
+        clear_bits(heap->_last, offset + blocks - 1, 1);
+        set_bits(heap->_last, offset + new_blocks - 1, 1);
+        heap->_used_blocks -= blocks - new_blocks;
+
+        return errors::nil();
+    }
+
+    if (offset + new_blocks > heap->_blocks) {
+        return errors::make(
+            WITH_LOCATION("allocation can't grow past the end of the heap"));
+    }
+
+    if (!are_bits_clear(heap->_used, offset + blocks, new_blocks - blocks)) {
+        return errors::make(
+            WITH_LOCATION("blocks after the allocation are in use"));
+    }
+
+    set_bits(heap->_used, offset + blocks, new_blocks - blocks);
+    clear_bits(heap->_last, offset + blocks - 1, 1);
+    set_bits(heap->_last, offset + new_blocks - 1, 1);
+    heap->_used_blocks += new_blocks - blocks;
+
+    return errors::nil();
+}
+
+with_error<size_t> get_size(bitmap_heap *heap, const void *allocation) {
+    auto [first, error] = get_offset(heap, allocation);
+    if (errors::set(error)) {
+        return {0, error};
+    }
+
+    if (!get_bit(heap->_first, first)) {
+        return {0, errors::make(WITH_LOCATION(
+                       "address is not the start of an allocation"))};
+    }
+
+    auto [last, last_error] = find_last_block(heap, first);
+    if (errors::set(last_error)) {
+        errors::enrich(&last_error, "find last block");
+        return {0, last_error};
+    }
+
+    return {(last - first + 1) * heap->_block_size, errors::nil()};
+}
+
+usage get_usage(bitmap_heap *heap) {
+    const size_t words = divide_round_up(heap->_blocks, BITS_PER_WORD);
+
+    size_t largest_run = 0;
+    size_t runs = 0;
+    size_t run_length = 0;
+
+    for (size_t word_index = 0; word_index < words; word_index++) {
+        const bitmap_word used = heap->_used[word_index];
+
+        if (used == ALL_UNUSED) {
+            run_length += BITS_PER_WORD;
+            continue;
+        }
+
+        for (size_t bit = 0; bit < BITS_PER_WORD; bit++) {
+            if (!utilities::get_flag(used, bit)) {
+                run_length++;
+                continue;
+            }
+
+            if (run_length != 0) {
+                largest_run =
+                    run_length > largest_run ? run_length : largest_run;
+                runs++;
+                run_length = 0;
+            }
+        }
+    }
+
+    if (run_length != 0) {
+        largest_run = run_length > largest_run ? run_length : largest_run;
+        runs++;
+    }
+
+    const size_t free_blocks = heap->_blocks - heap->_used_blocks;
+
+    return usage{
+        .used_bytes = heap->_used_blocks * heap->_block_size,
+        .free_bytes = free_blocks * heap->_block_size,
+        .largest_free_bytes = largest_run * heap->_block_size,
+        .free_extents = runs,
+    };
+}
+
+with_error<void *> allocate(bitmap_heap *heap, size_t bytes,
+                            const block_alignment &alignment) {
+    if (bytes == 0) {
+        return {nullptr, errors::make(WITH_LOCATION("can't allocate 0 bytes"))};
+    }
+
+    const size_t blocks = divide_round_up(bytes, heap->_block_size);
+    auto [offset, error] = find_aligned_offset(heap, blocks, alignment);
+    if (errors::set(error)) {
+        errors::enrich(&error, "find allocation offset");
+        return {nullptr, error};
+    }
+
+    set_bits(heap->_used, offset, blocks);
+    set_bits(heap->_first, offset, 1);
+    set_bits(heap->_last, offset + blocks - 1, 1);
+    heap->_used_blocks += blocks;
+    void *address = heap->_start + (heap->_block_size * offset);
+
+    return {address, errors::nil()};
+}
+
+with_error<size_t> get_offset(bitmap_heap *heap, const void *allocation) {
+    const uint8_t *allocation_ = static_cast<const uint8_t *>(allocation);
+
+    if (allocation_ < heap->_start ||
+        allocation_ >= heap->_start + (heap->_blocks * heap->_block_size)) {
+        return {0, errors::make(WITH_LOCATION(
+                       "addrees to free is outside the heap"))};
+    }
+
+    if ((allocation_ - heap->_start) % heap->_block_size != 0) {
+        return {0, errors::make(WITH_LOCATION(
+                       "address to free is not aligned to block size"))};
+    }
+
+    return {(allocation_ - heap->_start) / heap->_block_size, errors::nil()};
+}
+
+error check_bounds(bitmap_heap *heap, size_t offset, size_t blocks) {
+    if (blocks == 0 || offset + blocks > heap->_blocks) {
+        return errors::make(WITH_LOCATION("size doesn't fit in the heap"));
+    }
+
+    if (!get_bit(heap->_first, offset)) {
+        return errors::make(
+            WITH_LOCATION("first block in allocation isn't marked as first"));
+    }
+
+    if (!get_bit(heap->_last, offset + blocks - 1)) {
+        return errors::make(
+            WITH_LOCATION("last block in allocation isn't marked as last"));
+    }
+
+    // A size that is too large could otherwise end at the last block of a
+    // later allocation, and free the ones in between.
+    if (!are_bits_set(heap->_used, offset, blocks) ||
+        !are_bits_clear(heap->_first, offset + 1, blocks - 1) ||
+        !are_bits_clear(heap->_last, offset, blocks - 1)) {
+        return errors::make(
+            WITH_LOCATION("blocks don't form a single allocation"));
+    }
+
+    return errors::nil();
+}
+
+void release(bitmap_heap *heap, size_t offset, size_t blocks) {
+    clear_bits(heap->_used, offset, blocks);
+    clear_bits(heap->_first, offset, 1);
+    clear_bits(heap->_last, offset + blocks - 1, 1);
+    heap->_used_blocks -= blocks;
+}
+
+size_t divide_round_up(size_t a, size_t b) {
+    return (a + b - 1) / b;
+}
+
+with_error<size_t> find_aligned_offset(bitmap_heap *heap, size_t blocks,
+                                       const block_alignment &alignment) {
+    size_t from = alignment.first;
+
+    while (true) {
+        auto [offset, error] = find_allocation_offset(heap, blocks, from);
+        if (errors::set(error)) {
+            return {0, error};
+        }
+
+        // The run may start before the next aligned block. Check whether it
+        // is long enough to hold the allocation from there, and otherwise
+        // keep searching after it.
+        const size_t stride_offset =
+            (offset - alignment.first) % alignment.stride;
+        if (stride_offset == 0) {
+            return {offset, errors::nil()};
+        }
+
+        const size_t aligned = offset + alignment.stride - stride_offset;
+        if (aligned + blocks <= heap->_blocks &&
+            are_bits_clear(heap->_used, aligned, blocks)) {
+            return {aligned, errors::nil()};
+        }
+
+        from = aligned;
+    }
+}
+
+with_error<size_t> find_allocation_offset(bitmap_heap *heap, size_t blocks,
+                                          size_t from) {
+    const size_t words = divide_round_up(heap->_blocks, BITS_PER_WORD);
+
+    size_t run_start = 0;
+    size_t run_length = 0;
+
+    for (size_t word_index = from / BITS_PER_WORD; word_index < words;
+         word_index++) {
+        bitmap_word used = heap->_used[word_index];
+        if (word_index == from / BITS_PER_WORD) {
+            // Treat the blocks before the starting point as used.
+            used |= ~(ALL_USED << (from % BITS_PER_WORD));
+        }
+
+        if (used == ALL_USED) {
+            run_length = 0;
+            continue;
+        }
+
+        if (used == ALL_UNUSED) {
+            if (run_length == 0) {
+                run_start = word_index * BITS_PER_WORD;
+            }
+            run_length += BITS_PER_WORD;
+        } else {
+            // Walk the runs of free bits inside the word. Each iteration
+            // skips the used bits up to the next free bit, and then the free
+            // bits up to the next used bit.
+            size_t bit = 0;
+            while (bit < BITS_PER_WORD) {
+                const bitmap_word free_from_bit = ~used >> bit;
+                if (free_from_bit == 0) {
+                    run_length = 0;
+                    break;
+                }
+
+                const size_t used_bits =
+                    utilities::count_trailing_zeros(free_from_bit);
+                if (used_bits != 0) {
+                    run_length = 0;
+                    bit += used_bits;
+                }
+
+                const bitmap_word used_from_bit = used >> bit;
+                const size_t free_bits =
+                    used_from_bit == 0
+                        ? BITS_PER_WORD - bit
+                        : utilities::count_trailing_zeros(used_from_bit);
+
+                if (run_length == 0) {
+                    run_start = word_index * BITS_PER_WORD + bit;
+                }
+                run_length += free_bits;
+                bit += free_bits;
+
+                if (run_length >= blocks) {
+                    break;
+                }
+            }
+        }
+
+        if (run_length >= blocks) {
+            return {run_start, errors::nil()};
+        }
+    }
+
+    return {0, errors::make(WITH_LOCATION(
+                   "no contiguous blocks of requested size found"))};
+}
+
+with_error<size_t> find_last_block(bitmap_heap *heap, size_t first) {
+    const size_t words = divide_round_up(heap->_blocks, BITS_PER_WORD);
+
+    size_t word_index = first / BITS_PER_WORD;
+    // Ignore the bits of blocks that come before the first block.
+    bitmap_word last_bits =
+        heap->_last[word_index] & (ALL_USED << (first % BITS_PER_WORD));
+
+    while (last_bits == 0) {
+        word_index++;
+        if (word_index == words) {
+            return {0, errors::make(WITH_LOCATION(
+                           "allocation has no block marked as last"))};
+        }
+
+        last_bits = heap->_last[word_index];
+    }
+
+    return {word_index * BITS_PER_WORD +
+                utilities::count_trailing_zeros(last_bits),
+            errors::nil()};
+}
+
+bool get_bit(const bitmap_word *bitmap, size_t offset) {
+    return utilities::get_flag(bitmap[offset / BITS_PER_WORD],
+                               offset % BITS_PER_WORD);
+}
+
+void set_bits(bitmap_word *bitmap, size_t offset, size_t count) {
+    while (count > 0) {
+        const size_t bit = offset % BITS_PER_WORD;
+        const size_t bits =
+            count < BITS_PER_WORD - bit ? count : BITS_PER_WORD - bit;
+
+        bitmap[offset / BITS_PER_WORD] |= make_mask(bit, bits);
+
+        offset += bits;
+        count -= bits;
+    }
+}
+
+void clear_bits(bitmap_word *bitmap, size_t offset, size_t count) {
+    while (count > 0) {
+        const size_t bit = offset % BITS_PER_WORD;
+        const size_t bits =
+            count < BITS_PER_WORD - bit ? count : BITS_PER_WORD - bit;
+
+        bitmap[offset / BITS_PER_WORD] &= ~make_mask(bit, bits);
+
+        offset += bits;
+        count -= bits;
+    }
+}
+
+bool are_bits_set(const bitmap_word *bitmap, size_t offset, size_t count) {
+    while (count > 0) {
+        const size_t bit = offset % BITS_PER_WORD;
+        const size_t bits =
+            count < BITS_PER_WORD - bit ? count : BITS_PER_WORD - bit;
+        const bitmap_word mask = make_mask(bit, bits);
+
+        if ((bitmap[offset / BITS_PER_WORD] & mask) != mask) {
+            return false;
+        }
+
+        offset += bits;
+        count -= bits;
+    }
+
+    return true;
+}
+
+bool are_bits_clear(const bitmap_word *bitmap, size_t offset, size_t count) {
+    while (count > 0) {
+        const size_t bit = offset % BITS_PER_WORD;
+        const size_t bits =
+            count < BITS_PER_WORD - bit ? count : BITS_PER_WORD - bit;
+
+        if ((bitmap[offset / BITS_PER_WORD] & make_mask(bit, bits)) != 0) {
+            return false;
+        }
+
+        offset += bits;
+        count -= bits;
+    }
+
+    return true;
+}
+
+size_t count_bits(bitmap_word word) {
+    size_t count = 0;
+
+    // Each iteration clears the lowest set bit.
+    while (word != 0) {
+        word &= word - 1;
+        count++;
+    }
+
+    return count;
+}
+
+size_t clamp_blocks(const bitmap_heap *heap, size_t offset, size_t blocks) {
+    if (offset >= heap->_blocks) {
+        return 0;
+    }
+
+    return blocks < heap->_blocks - offset ? blocks : heap->_blocks - offset;
+}
+
+bitmap_word make_mask(size_t offset, size_t count) {
+    const bitmap_word ones =
+        count == BITS_PER_WORD ? ALL_USED : (bitmap_word(1) << count) - 1;
+    return ones << offset;
+}
+
+}  // namespace memory::allocation::bitmap_heap
@@ -1,5 +1,7 @@
 #include "memory/allocation/block_heap.hpp"
 
+#include "memory/allocation/alignment.hpp"
+
 namespace memory::allocation::block_heap {
 
 constexpr uint8_t BLOCK_UNUSED = 0;
@@ -8,10 +10,23 @@ constexpr uint8_t BLOCK_FIRST = 1 << 1;
 constexpr uint8_t BLOCK_LAST = 1 << 2;
 
 static with_error<void *> malloc(block_heap *heap, size_t bytes);
+static with_error<void *> aligned_malloc(block_heap *heap, size_t bytes,
+                                         size_t alignment);
 static error free(block_heap *heap, const void *allocation);
+static error sized_free(block_heap *heap, const void *allocation,
+                        size_t bytes);
+static error grow_in_place(block_heap *heap, const void *allocation,
+                           size_t bytes, size_t new_bytes);
+static with_error<size_t> get_size(block_heap *heap, const void *allocation);
+static usage get_usage(block_heap *heap);
+static with_error<void *> allocate(block_heap *heap, size_t bytes,
+                                   const block_alignment &alignment);
+static with_error<size_t> get_offset(block_heap *heap,
+                                     const void *allocation);
+static error check_bounds(block_heap *heap, size_t offset, size_t blocks);
 static size_t divide_round_up(size_t a, size_t b);
-static with_error<size_t> find_allocation_offset(block_heap *heap,
-                                                 size_t blocks);
+static with_error<size_t> find_allocation_offset(
+    block_heap *heap, size_t blocks, const block_alignment &alignment);
 static void mark_blocks_as_used(block_heap *heap, size_t offset, size_t blocks);
 
 block_heap make_block_heap(uint8_t *start, block_metadata *block_table,
@@ -23,6 +38,7 @@ block_heap make_block_heap(uint8_t *start, block_metadata *block_table,
         ._block_table = block_table,
         ._block_size = block_size,
         ._blocks = blocks,
+        ._used_blocks = 0,
     };
 }
 
@@ -31,59 +47,242 @@ block_heap make_block_heap(uint8_t *start, block_metadata *block_table,
         .self = heap,
         ._malloc = reinterpret_cast<MallocType>(malloc),
         ._free = reinterpret_cast<FreeType>(free),
+        ._aligned_malloc = reinterpret_cast<AlignedMallocType>(aligned_malloc),
+        ._sized_free = reinterpret_cast<SizedFreeType>(sized_free),
+        ._grow_in_place = reinterpret_cast<GrowInPlaceType>(grow_in_place),
+        ._get_size = reinterpret_cast<GetSizeType>(get_size),
+        ._get_usage = reinterpret_cast<GetUsageType>(get_usage),
     };
 }
 
 with_error<void *> malloc(block_heap *heap, size_t bytes) {
+    return allocate(heap, bytes, block_alignment{.first = 0, .stride = 1});
+}
+
+with_error<void *> aligned_malloc(block_heap *heap, size_t bytes,
+                                  size_t alignment) {
+    auto [aligned_blocks, error] =
+        get_block_alignment(heap->_start, heap->_block_size, alignment);
+    if (errors::set(error)) {
+        errors::enrich(&error, "get block alignment");
+        return {nullptr, error};
+    }
+
+    return allocate(heap, bytes, aligned_blocks);
+}
+
+error free(block_heap *heap, const void *allocation) {
+    auto [offset, error] = get_offset(heap, allocation);
+    if (errors::set(error)) {
+        return error;
+    }
+
+    block_metadata *block = heap->_block_table + offset;
+    if (!(*block & BLOCK_FIRST)) {
+        return errors::make(
+            WITH_LOCATION("first block in allocation isn't marked as first"));
+    }
+
+    while (!(*block & BLOCK_LAST)) {
+        if (!(*block & BLOCK_USED)) {
+            return errors::make(
+                WITH_LOCATION("unused block in the middle of an allocation"));
+        }
+
+        *block = BLOCK_UNUSED;
+        block++;
+        heap->_used_blocks--;
+    }
+    *block = BLOCK_UNUSED;
+    heap->_used_blocks--;
+
+    return errors::nil();
+}
+
+error sized_free(block_heap *heap, const void *allocation, size_t bytes) {
+    auto [offset, error] = get_offset(heap, allocation);
+    if (errors::set(error)) {
+        return error;
+    }
+
+    const size_t blocks = divide_round_up(bytes, heap->_block_size);
+    error = check_bounds(heap, offset, blocks);
+    if (errors::set(error)) {
+        return error;
+    }
+
+    for (size_t i = 0; i < blocks; i++) {
+        heap->_block_table[offset + i] = BLOCK_UNUSED;
+    }
+    heap->_used_blocks -= blocks;
+
+    return errors::nil();
+}
+
+error grow_in_place(block_heap *heap, const void *allocation, size_t bytes,
+                    size_t new_bytes) {
+    auto [offset, error] = get_offset(heap, allocation);
+    if (errors::set(error)) {
+        return error;
+    }
+
+    const size_t blocks = divide_round_up(bytes, heap->_block_size);
+    error = check_bounds(heap, offset, blocks);
+    if (errors::set(error)) {
+        return error;
+    }
+
+    const size_t new_blocks = divide_round_up(new_bytes, heap->_block_size);
+    if (new_blocks == 0) {
+        return errors::make(WITH_LOCATION("can't shrink to 0 bytes"));
+    }
+
+    // The blocks past the new end are freed, so the allocation can later be
+    // freed with its new size.
+    if (new_blocks <= blocks) {
+        for (size_t i = new_blocks; i < blocks; i++) {
+            heap->_block_table[offset + i] = BLOCK_UNUSED;
+        }
+        mark_blocks_as_used(heap, offset, new_blocks);
+        heap->_used_blocks -= blocks - new_blocks;
+
+        return errors::nil();
+    }
+
+    if (offset + new_blocks > heap->_blocks) {
+        return errors::make(
+            WITH_LOCATION("allocation can't grow past the end of the heap"));
+    }
+
+    for (size_t i = blocks; i < new_blocks; i++) {
+        if (heap->_block_table[offset + i] & BLOCK_USED) {
+            return errors::make(
+                WITH_LOCATION("blocks after the allocation are in use"));
+        }
+    }
+
+    mark_blocks_as_used(heap, offset, new_blocks);
+    heap->_used_blocks += new_blocks - blocks;
+
+    return errors::nil();
+}
+
+with_error<size_t> get_size(block_heap *heap, const void *allocation) {
+    auto [offset, error] = get_offset(heap, allocation);
+    if (errors::set(error)) {
+        return {0, error};
+    }
+
+    const block_metadata *block = heap->_block_table + offset;
+    if (!(*block & BLOCK_FIRST)) {
+        return {0, errors::make(WITH_LOCATION(
+                       "address is not the start of an allocation"))};
+    }
+
+    size_t blocks = 1;
+    while (!(*block & BLOCK_LAST)) {
+        block++;
+        blocks++;
+    }
+
+    return {blocks * heap->_block_size, errors::nil()};
+}
+
+usage get_usage(block_heap *heap) {
+    size_t largest_run = 0;
+    size_t runs = 0;
+    size_t run_length = 0;
+
+    for (size_t offset = 0; offset < heap->_blocks; offset++) {
+        if (!(heap->_block_table[offset] & BLOCK_USED)) {
+            run_length++;
+            continue;
+        }
+
+        if (run_length != 0) {
+            largest_run = run_length > largest_run ? run_length : largest_run;
+            runs++;
+            run_length = 0;
+        }
+    }
+
+    if (run_length != 0) {
+        largest_run = run_length > largest_run ? run_length : largest_run;
+        runs++;
+    }
+
+    const size_t free_blocks = heap->_blocks - heap->_used_blocks;
+
+    return usage{
+        .used_bytes = heap->_used_blocks * heap->_block_size,
+        .free_bytes = free_blocks * heap->_block_size,
+        .largest_free_bytes = largest_run * heap->_block_size,
+        .free_extents = runs,
+    };
+}
+
+with_error<void *> allocate(block_heap *heap, size_t bytes,
+                            const block_alignment &alignment) {
     if (bytes == 0) {
         return {nullptr, errors::make(WITH_LOCATION("can't allocate 0 bytes"))};
     }
 
     const size_t blocks = divide_round_up(bytes, heap->_block_size);
-    auto [offset, error] = find_allocation_offset(heap, blocks);
+    auto [offset, error] = find_allocation_offset(heap, blocks, alignment);
     if (errors::set(error)) {
         errors::enrich(&error, "find allocation offset");
         return {nullptr, error};
     }
 
     mark_blocks_as_used(heap, offset, blocks);
+    heap->_used_blocks += blocks;
     void *address = heap->_start + (heap->_block_size * offset);
 
     return {address, errors::nil()};
 }
 
-error free(block_heap *heap, const void *allocation) {
+with_error<size_t> get_offset(block_heap *heap, const void *allocation) {
     const uint8_t *allocation_ = static_cast<const uint8_t *>(allocation);
 
     if (allocation_ < heap->_start ||
-        allocation_ > heap->_start + (heap->_blocks * heap->_block_size)) {
-        return errors::make(
-            WITH_LOCATION("addrees to free is outside the heap"));
+        allocation_ >= heap->_start + (heap->_blocks * heap->_block_size)) {
+        return {0, errors::make(WITH_LOCATION(
+                       "addrees to free is outside the heap"))};
     }
 
     if ((allocation_ - heap->_start) % heap->_block_size != 0) {
-        return errors::make(
-            WITH_LOCATION("address to free is not aligned to block size"));
+        return {0, errors::make(WITH_LOCATION(
+                       "address to free is not aligned to block size"))};
     }
 
-    size_t offset = (allocation_ - heap->_start) / heap->_block_size;
+    return {(allocation_ - heap->_start) / heap->_block_size, errors::nil()};
+}
 
-    block_metadata *block = heap->_block_table + offset;
-    if (!(*block & BLOCK_FIRST)) {
+error check_bounds(block_heap *heap, size_t offset, size_t blocks) {
+    if (blocks == 0 || offset + blocks > heap->_blocks) {
+        return errors::make(WITH_LOCATION("size doesn't fit in the heap"));
+    }
+
+    if (!(heap->_block_table[offset] & BLOCK_FIRST)) {
         return errors::make(
             WITH_LOCATION("first block in allocation isn't marked as first"));
     }
 
-    while (!(*block & BLOCK_LAST)) {
-        if (!(*block & BLOCK_USED)) {
+    if (!(heap->_block_table[offset + blocks - 1] & BLOCK_LAST)) {
+        return errors::make(
+            WITH_LOCATION("last block in allocation isn't marked as last"));
+    }
+
+    // A size that is too large could otherwise end at the last block of a
+    // later allocation, and free the ones in between.
+    for (size_t i = 0; i < blocks; i++) {
+        const block_metadata block = heap->_block_table[offset + i];
+        if (!(block & BLOCK_USED) || (i != 0 && (block & BLOCK_FIRST)) ||
+            (i != blocks - 1 && (block & BLOCK_LAST))) {
             return errors::make(
-                WITH_LOCATION("unused block in the middle of an allocation"));
+                WITH_LOCATION("blocks don't form a single allocation"));
         }
-
-        *block = BLOCK_UNUSED;
-        block++;
     }
-    *block = BLOCK_UNUSED;
 
     return errors::nil();
 }
@@ -92,7 +291,8 @@ size_t divide_round_up(size_t a, size_t b) {
     return (a + b - 1) / b;
 }
 
-with_error<size_t> find_allocation_offset(block_heap *heap, size_t blocks) {
+with_error<size_t> find_allocation_offset(block_heap *heap, size_t blocks,
+                                          const block_alignment &alignment) {
     size_t blocks_found = 0;
     for (block_metadata *block = heap->_block_table;
          static_cast<size_t>(block - heap->_block_table) < heap->_blocks;
@@ -102,9 +302,17 @@ with_error<size_t> find_allocation_offset(block_heap *heap, size_t blocks) {
             continue;
         }
 
+        // Allocations may only start at aligned blocks.
+        const size_t current_block_offset = block - heap->_block_table;
+        if (blocks_found == 0 &&
+            (current_block_offset < alignment.first ||
+             (current_block_offset - alignment.first) % alignment.stride !=
+                 0)) {
+            continue;
+        }
+
         blocks_found++;
         if (blocks_found == blocks) {
-            const size_t current_block_offset = block - heap->_block_table;
             return {current_block_offset - (blocks - 1), errors::nil()};
         }
     }
@@ -0,0 +1,333 @@
+#include "memory/allocation/buddy_heap.hpp"
+
+#include <cassert>
+#include <cstring>
+
+#include "memory/allocation/alignment.hpp"
+
+namespace memory::allocation::buddy_heap {
+
+constexpr block_metadata BLOCK_NONE = 0;
+constexpr block_metadata BLOCK_HEAD = 1 << 7;
+constexpr block_metadata BLOCK_USED = 1 << 6;
+constexpr block_metadata BLOCK_ORDER_MASK = BLOCK_USED - 1;
+
+static with_error<void *> malloc(buddy_heap *heap, size_t bytes);
+static with_error<void *> aligned_malloc(buddy_heap *heap, size_t bytes,
+                                         size_t alignment);
+static error free(buddy_heap *heap, const void *allocation);
+static error sized_free(buddy_heap *heap, const void *allocation,
+                        size_t bytes);
+static error grow_in_place(buddy_heap *heap, const void *allocation,
+                           size_t bytes, size_t new_bytes);
+static with_error<size_t> get_size(buddy_heap *heap, const void *allocation);
+static usage get_usage(buddy_heap *heap);
+static with_error<size_t> get_allocation_order(const buddy_heap *heap,
+                                               const void *allocation);
+static with_error<size_t> get_order(const buddy_heap *heap, size_t bytes);
+static void push_free(buddy_heap *heap, size_t offset, size_t order);
+static void remove_free(buddy_heap *heap, size_t offset, size_t order);
+[[nodiscard]] static size_t pop_free(buddy_heap *heap, size_t order);
+[[nodiscard]] static bool is_free_with_order(const buddy_heap *heap,
+                                             size_t offset, size_t order);
+[[nodiscard]] static free_block *get_block(const buddy_heap *heap,
+                                           size_t offset);
+
+buddy_heap make_buddy_heap(uint8_t *start, block_metadata *block_table,
+                           size_t block_size, size_t blocks) {
+    assertm((block_size & (block_size - 1)) == 0 &&
+                block_size >= sizeof(free_block),
+            "block size must be a power of two that fits a free block");
+
+    buddy_heap heap{
+        .malloc = malloc,
+        .free = free,
+        ._start = start,
+        ._block_table = block_table,
+        ._block_size = block_size,
+        ._blocks = blocks,
+    };
+
+    for (size_t order = 0; order < ORDERS; order++) {
+        heap._free_lists[order] = nullptr;
+        heap._free_counts[order] = 0;
+    }
+
+    std::memset(block_table, BLOCK_NONE, blocks * sizeof(block_metadata));
+
+    // Cover the heap with the largest blocks that are aligned to their size
+    // and fit in the remaining space, so a heap that isn't a power of two
+    // still gets used in full.
+    size_t offset = 0;
+    while (offset < blocks) {
+        size_t order = ORDERS - 1;
+        while (offset % (1 << order) != 0 || offset + (1 << order) > blocks) {
+            order--;
+        }
+
+        push_free(&heap, offset, order);
+        offset += 1 << order;
+    }
+
+    return heap;
+}
+
+::memory::allocation::allocator make_allocator(buddy_heap *heap) {
+    return ::memory::allocation::allocator{
+        .self = heap,
+        ._malloc = reinterpret_cast<MallocType>(malloc),
+        ._free = reinterpret_cast<FreeType>(free),
+        ._aligned_malloc = reinterpret_cast<AlignedMallocType>(aligned_malloc),
+        ._sized_free = reinterpret_cast<SizedFreeType>(sized_free),
+        ._grow_in_place = reinterpret_cast<GrowInPlaceType>(grow_in_place),
+        ._get_size = reinterpret_cast<GetSizeType>(get_size),
+        ._get_usage = reinterpret_cast<GetUsageType>(get_usage),
+    };
+}
+
+size_t free_blocks(const buddy_heap *heap, size_t order) {
+    if (order >= ORDERS) {
+        return 0;
+    }
+
+    return heap->_free_counts[order];
+}
+
+with_error<void *> malloc(buddy_heap *heap, size_t bytes) {
+    if (bytes == 0) {
+        return {nullptr, errors::make(WITH_LOCATION("can't allocate 0 bytes"))};
+    }
+
+    auto [order, error] = get_order(heap, bytes);
+    if (errors::set(error)) {
+        errors::enrich(&error, "get allocation order");
+        return {nullptr, error};
+    }
+
+    size_t available_order = order;
+    while (available_order < ORDERS &&
+           heap->_free_lists[available_order] == nullptr) {
+        available_order++;
+    }
+
+    if (available_order == ORDERS) {
+        return {nullptr, errors::make(WITH_LOCATION(
+                             "no free block of requested size found"))};
+    }
+
+    const size_t offset = pop_free(heap, available_order);
+
+    // Split the block until it has the requested order, freeing the upper
+    // half each time.
+    while (available_order > order) {
+        available_order--;
+        push_free(heap, offset + (1 << available_order), available_order);
+    }
+
+    heap->_block_table[offset] = BLOCK_HEAD | BLOCK_USED | order;
+
+    return {heap->_start + heap->_block_size * offset, errors::nil()};
+}
+
+with_error<void *> aligned_malloc(buddy_heap *heap, size_t bytes,
+                                  size_t alignment) {
+    // Blocks are aligned to their size, so asking for at least `alignment`
+    // bytes gives an aligned block whenever the heap itself is aligned.
+    auto [allocation, error] =
+        malloc(heap, bytes > alignment ? bytes : alignment);
+    if (errors::set(error)) {
+        return {nullptr, error};
+    }
+
+    if (!is_aligned(allocation, alignment)) {
+        free(heap, allocation);
+        return {nullptr, errors::make(WITH_LOCATION(
+                             "heap start is not aligned to the alignment"))};
+    }
+
+    return {allocation, errors::nil()};
+}
+
+error free(buddy_heap *heap, const void *allocation) {
+    auto [order, error] = get_allocation_order(heap, allocation);
+    if (errors::set(error)) {
+        return error;
+    }
+
+    size_t offset = (static_cast<const uint8_t *>(allocation) - heap->_start) /
+                    heap->_block_size;
+    heap->_block_table[offset] = BLOCK_NONE;
+
+    // Merge with the buddy for as long as it's free and whole.
+    while (order < ORDERS - 1) {
+        const size_t buddy = offset ^ (1 << order);
+        if (buddy + (1 << order) > heap->_blocks ||
+            !is_free_with_order(heap, buddy, order)) {
+            break;
+        }
+
+        remove_free(heap, buddy, order);
+        offset = offset < buddy ? offset : buddy;
+        order++;
+    }
+
+    push_free(heap, offset, order);
+
+    return errors::nil();
+}
+
+error sized_free(buddy_heap *heap, const void *allocation, size_t bytes) {
+    auto [order, error] = get_allocation_order(heap, allocation);
+    if (errors::set(error)) {
+        return error;
+    }
+
+    // Aligned allocations may take a block larger than their size requires,
+    // so the size can only be checked against the order of the block.
+    auto [size_order, order_error] = get_order(heap, bytes);
+    if (errors::set(order_error) || size_order > order) {
+        return errors::make(
+            WITH_LOCATION("size doesn't fit in the allocated block"));
+    }
+
+    return free(heap, allocation);
+}
+
+error grow_in_place(buddy_heap *heap, const void *allocation, size_t bytes,
+                    size_t new_bytes) {
+    auto [order, error] = get_allocation_order(heap, allocation);
+    if (errors::set(error)) {
+        return error;
+    }
+
+    // Only the slack left in the block by rounding up is available. Taking
+    // over the buddy would break the alignment of the block.
+    if (new_bytes > heap->_block_size << order) {
+        return errors::make(
+            WITH_LOCATION("new size doesn't fit in the allocated block"));
+    }
+
+    return errors::nil();
+}
+
+with_error<size_t> get_size(buddy_heap *heap, const void *allocation) {
+    auto [order, error] = get_allocation_order(heap, allocation);
+    if (errors::set(error)) {
+        return {0, error};
+    }
+
+    return {heap->_block_size << order, errors::nil()};
+}
+
+usage get_usage(buddy_heap *heap) {
+    size_t free_blocks = 0;
+    size_t free_extents = 0;
+    size_t largest_free_blocks = 0;
+
+    for (size_t order = 0; order < ORDERS; order++) {
+        free_blocks += heap->_free_counts[order] << order;
+        free_extents += heap->_free_counts[order];
+        if (heap->_free_counts[order] != 0) {
+            largest_free_blocks = 1 << order;
+        }
+    }
+
+    return usage{
+        .used_bytes = (heap->_blocks - free_blocks) * heap->_block_size,
+        .free_bytes = free_blocks * heap->_block_size,
+        .largest_free_bytes = largest_free_blocks * heap->_block_size,
+        .free_extents = free_extents,
+    };
+}
+
+with_error<size_t> get_allocation_order(const buddy_heap *heap,
+                                        const void *allocation) {
+    const uint8_t *allocation_ = static_cast<const uint8_t *>(allocation);
+
+    if (allocation_ < heap->_start ||
+        allocation_ >= heap->_start + (heap->_blocks * heap->_block_size)) {
+        return {0, errors::make(WITH_LOCATION(
+                       "addrees to free is outside the heap"))};
+    }
+
+    if ((allocation_ - heap->_start) % heap->_block_size != 0) {
+        return {0, errors::make(WITH_LOCATION(
+                       "address to free is not aligned to block size"))};
+    }
+
+    const size_t offset = (allocation_ - heap->_start) / heap->_block_size;
+
+    const block_metadata metadata = heap->_block_table[offset];
+    if ((metadata & (BLOCK_HEAD | BLOCK_USED)) != (BLOCK_HEAD | BLOCK_USED)) {
+        return {0, errors::make(WITH_LOCATION(
+                       "address to free is not the start of an allocation"))};
+    }
+
+    return {static_cast<size_t>(metadata & BLOCK_ORDER_MASK), errors::nil()};
+}
+
+with_error<size_t> get_order(const buddy_heap *heap, size_t bytes) {
+    size_t order = 0;
+    while (order < ORDERS && (heap->_block_size << order) < bytes) {
+        order++;
+    }
+
+    if (order == ORDERS) {
+        return {0, errors::make(WITH_LOCATION(
+                       "requested size is larger than the largest block"))};
+    }
+
+    return {order, errors::nil()};
+}
+
+void push_free(buddy_heap *heap, size_t offset, size_t order) {
+    free_block *const block = get_block(heap, offset);
+
+    block->previous = nullptr;
+    block->next = heap->_free_lists[order];
+    if (block->next != nullptr) {
+        block->next->previous = block;
+    }
+
+    heap->_free_lists[order] = block;
+    heap->_free_counts[order]++;
+    heap->_block_table[offset] = BLOCK_HEAD | order;
+}
+
+void remove_free(buddy_heap *heap, size_t offset, size_t order) {
+    free_block *const block = get_block(heap, offset);
+
+    if (block->previous != nullptr) {
+        block->previous->next = block->next;
+    } else {
+        heap->_free_lists[order] = block->next;
+    }
+
+    if (block->next != nullptr) {
+        block->next->previous = block->previous;
+    }
+
+    heap->_free_counts[order]--;
+    heap->_block_table[offset] = BLOCK_NONE;
+}
+
+size_t pop_free(buddy_heap *heap, size_t order) {
+    const uint8_t *const block =
+        reinterpret_cast<const uint8_t *>(heap->_free_lists[order]);
+    const size_t offset = (block - heap->_start) / heap->_block_size;
+
+    remove_free(heap, offset, order);
+
+    return offset;
+}
+
+bool is_free_with_order(const buddy_heap *heap, size_t offset, size_t order) {
+    return heap->_block_table[offset] == (BLOCK_HEAD | order);
+}
+
+free_block *get_block(const buddy_heap *heap, size_t offset) {
+    return reinterpret_cast<free_block *>(heap->_start +
+                                          heap->_block_size * offset);
+}
+
+}  // namespace memory::allocation::buddy_heap
@@ -0,0 +1,293 @@
+#include "memory/allocation/extent_heap.hpp"
+
+#include "utilities/macros.hpp"
+
+namespace memory::allocation::extent_heap {
+
+namespace rbtree = utilities::rbtree;
+
+static with_error<void *> malloc(extent_heap *heap, size_t bytes);
+static error free(extent_heap *heap, const void *allocation);
+static with_error<size_t> get_size(extent_heap *heap, const void *allocation);
+static usage get_usage(extent_heap *heap);
+static size_t divide_round_up(size_t a, size_t b);
+[[nodiscard]] static extent *find_best_fit(extent_heap *heap, size_t blocks);
+[[nodiscard]] static extent *find_by_offset(extent_heap *heap, size_t offset);
+static void insert_by_address(extent_heap *heap, extent *extent);
+static void insert_by_size(extent_heap *heap, extent *extent);
+[[nodiscard]] static extent *take_unused(extent_heap *heap);
+static void release_unused(extent_heap *heap, extent *extent);
+[[nodiscard]] static extent *from_address_node(rbtree::node *node);
+[[nodiscard]] static extent *from_size_node(rbtree::node *node);
+
+extent_heap make_extent_heap(uint8_t *start, extent *extents,
+                             size_t block_size, size_t blocks) {
+    extent_heap heap{
+        .malloc = malloc,
+        .free = free,
+        ._start = start,
+        ._block_size = block_size,
+        ._blocks = blocks,
+        ._by_address = rbtree::make_tree(),
+        ._by_size = rbtree::make_tree(),
+        ._unused = nullptr,
+    };
+
+    for (size_t i = blocks; i > 0; i--) {
+        release_unused(&heap, &extents[i - 1]);
+    }
+
+    if (blocks == 0) {
+        return heap;
+    }
+
+    extent *const whole = take_unused(&heap);
+    whole->offset = 0;
+    whole->blocks = blocks;
+    whole->free = true;
+    insert_by_address(&heap, whole);
+    insert_by_size(&heap, whole);
+
+    return heap;
+}
+
+::memory::allocation::allocator make_allocator(extent_heap *heap) {
+    return ::memory::allocation::allocator{
+        .self = heap,
+        ._malloc = reinterpret_cast<MallocType>(malloc),
+        ._free = reinterpret_cast<FreeType>(free),
+        ._get_size = reinterpret_cast<GetSizeType>(get_size),
+        ._get_usage = reinterpret_cast<GetUsageType>(get_usage),
+    };
+}
+
+with_error<void *> malloc(extent_heap *heap, size_t bytes) {
+    if (bytes == 0) {
+        return {nullptr, errors::make(WITH_LOCATION("can't allocate 0 bytes"))};
+    }
+
+    const size_t blocks = divide_round_up(bytes, heap->_block_size);
+    extent *const fit = find_best_fit(heap, blocks);
+    if (fit == nullptr) {
+        return {nullptr, errors::make(WITH_LOCATION(
+                             "no contiguous blocks of requested size found"))};
+    }
+
+    rbtree::erase(&heap->_by_size, &fit->by_size);
+
+    if (fit->blocks == blocks) {
+        fit->free = false;
+        return {heap->_start + heap->_block_size * fit->offset, errors::nil()};
+    }
+
+    // Split the allocation off the start of the free extent. The remainder
+    // keeps its place in the address order, since the new extent is inserted
+    // right before it.
+    extent *const allocation = take_unused(heap);
+    if (allocation == nullptr) {
+        insert_by_size(heap, fit);
+        return {nullptr, errors::make(WITH_LOCATION(
+                             "no unused extent descriptors are left"))};
+    }
+
+    allocation->offset = fit->offset;
+    allocation->blocks = blocks;
+    allocation->free = false;
+
+    fit->offset += blocks;
+    fit->blocks -= blocks;
+
+    insert_by_address(heap, allocation);
+    insert_by_size(heap, fit);
+
+    return {heap->_start + heap->_block_size * allocation->offset,
+            errors::nil()};
+}
+
+error free(extent_heap *heap, const void *allocation) {
+    const uint8_t *allocation_ = static_cast<const uint8_t *>(allocation);
+
+    if (allocation_ < heap->_start ||
+        allocation_ >= heap->_start + (heap->_blocks * heap->_block_size)) {
+        return errors::make(
+            WITH_LOCATION("addrees to free is outside the heap"));
+    }
+
+    if ((allocation_ - heap->_start) % heap->_block_size != 0) {
+        return errors::make(
+            WITH_LOCATION("address to free is not aligned to block size"));
+    }
+
+    extent *freed = find_by_offset(
+        heap, (allocation_ - heap->_start) / heap->_block_size);
+    if (freed == nullptr || freed->free) {
+        return errors::make(
+            WITH_LOCATION("address to free is not the start of an allocation"));
+    }
+
+    freed->free = true;
+
+    rbtree::node *const previous_node = rbtree::previous(&freed->by_address);
+    rbtree::node *const next_node = rbtree::next(&freed->by_address);
+
+    if (previous_node != nullptr && from_address_node(previous_node)->free) {
+        extent *const previous = from_address_node(previous_node);
+
+        rbtree::erase(&heap->_by_size, &previous->by_size);
+        previous->blocks += freed->blocks;
+
+        rbtree::erase(&heap->_by_address, &freed->by_address);
+        release_unused(heap, freed);
+
+        freed = previous;
+    }
+
+    if (next_node != nullptr && from_address_node(next_node)->free) {
+        extent *const next = from_address_node(next_node);
+
+        rbtree::erase(&heap->_by_size, &next->by_size);
+        freed->blocks += next->blocks;
+
+        rbtree::erase(&heap->_by_address, &next->by_address);
+        release_unused(heap, next);
+    }
+
+    insert_by_size(heap, freed);
+
+    return errors::nil();
+}
+
+with_error<size_t> get_size(extent_heap *heap, const void *allocation) {
+    const uint8_t *allocation_ = static_cast<const uint8_t *>(allocation);
+
+    if (allocation_ < heap->_start ||
+        (allocation_ - heap->_start) % heap->_block_size != 0) {
+        return {0, errors::make(WITH_LOCATION(
+                       "address is not the start of a block"))};
+    }
+
+    const extent *const found = find_by_offset(
+        heap, (allocation_ - heap->_start) / heap->_block_size);
+    if (found == nullptr || found->free) {
+        return {0, errors::make(WITH_LOCATION(
+                       "address is not the start of an allocation"))};
+    }
+
+    return {found->blocks * heap->_block_size, errors::nil()};
+}
+
+usage get_usage(extent_heap *heap) {
+    size_t free_blocks = 0;
+    size_t free_extents = 0;
+
+    for (rbtree::node *node = rbtree::first(&heap->_by_size); node != nullptr;
+         node = rbtree::next(node)) {
+        free_blocks += from_size_node(node)->blocks;
+        free_extents++;
+    }
+
+    // Free extents are ordered by size, so the last one is the largest.
+    rbtree::node *const largest = rbtree::last(&heap->_by_size);
+
+    return usage{
+        .used_bytes = (heap->_blocks - free_blocks) * heap->_block_size,
+        .free_bytes = free_blocks * heap->_block_size,
+        .largest_free_bytes =
+            largest != nullptr
+                ? from_size_node(largest)->blocks * heap->_block_size
+                : 0,
+        .free_extents = free_extents,
+    };
+}
+
+size_t divide_round_up(size_t a, size_t b) {
+    return (a + b - 1) / b;
+}
+
+extent *find_best_fit(extent_heap *heap, size_t blocks) {
+    // Find the smallest extent that is large enough. Ties are broken by the
+    // lowest offset, which keeps allocations packed at the start of the heap.
+    extent *best = nullptr;
+
+    rbtree::node *node = heap->_by_size.root;
+    while (node != nullptr) {
+        extent *const current = from_size_node(node);
+        if (current->blocks >= blocks) {
+            best = current;
+            node = node->left;
+        } else {
+            node = node->right;
+        }
+    }
+
+    return best;
+}
+
+extent *find_by_offset(extent_heap *heap, size_t offset) {
+    rbtree::node *node = heap->_by_address.root;
+    while (node != nullptr) {
+        extent *const current = from_address_node(node);
+        if (offset == current->offset) {
+            return current;
+        }
+
+        node = offset < current->offset ? node->left : node->right;
+    }
+
+    return nullptr;
+}
+
+void insert_by_address(extent_heap *heap, extent *extent) {
+    rbtree::node *parent = nullptr;
+    rbtree::node **link = &heap->_by_address.root;
+
+    while (*link != nullptr) {
+        parent = *link;
+        link = extent->offset < from_address_node(parent)->offset
+                   ? &parent->left
+                   : &parent->right;
+    }
+
+    rbtree::insert(&heap->_by_address, &extent->by_address, parent, link);
+}
+
+void insert_by_size(extent_heap *heap, extent *extent) {
+    rbtree::node *parent = nullptr;
+    rbtree::node **link = &heap->_by_size.root;
+
+    while (*link != nullptr) {
+        parent = *link;
+        const struct extent *const current = from_size_node(parent);
+
+        const bool smaller =
+            extent->blocks < current->blocks ||
+            (extent->blocks == current->blocks &&
+             extent->offset < current->offset);
+        link = smaller ? &parent->left : &parent->right;
+    }
+
+    rbtree::insert(&heap->_by_size, &extent->by_size, parent, link);
+}
+
+extent *take_unused(extent_heap *heap) {
+    extent *const extent = heap->_unused;
+    if (extent != nullptr) {
+        heap->_unused = extent->next_unused;
+    }
+    return extent;
+}
+
+void release_unused(extent_heap *heap, extent *extent) {
+    extent->next_unused = heap->_unused;
+    heap->_unused = extent;
+}
+
+extent *from_address_node(rbtree::node *node) {
+    return CONTAINER_OF(node, extent, by_address);
+}
+
+extent *from_size_node(rbtree::node *node) {
+    return CONTAINER_OF(node, extent, by_size);
+}
+
+}  // namespace memory::allocation::extent_heap
@@ -0,0 +1,372 @@
+#include "memory/allocation/instrumented_heap.hpp"
+
+#include "logging/logger.hpp"
+#include "utilities/bitranges.hpp"
+#include "utilities/format.hpp"
+#include "utilities/timestamp.hpp"
+
+namespace memory::allocation::instrumented_heap {
+
+// The amount of call sites dump() logs, busiest first.
+constexpr size_t DUMPED_CALL_SITES = 8;
+constexpr size_t LINE_SIZE = 160;
+
+static with_error<void *> malloc(instrumented_heap *heap, size_t bytes);
+static with_error<void *> aligned_malloc(instrumented_heap *heap,
+                                         size_t bytes, size_t alignment);
+static error free(instrumented_heap *heap, const void *allocation);
+static error sized_free(instrumented_heap *heap, const void *allocation,
+                        size_t bytes);
+static error grow_in_place(instrumented_heap *heap, const void *allocation,
+                           size_t bytes, size_t new_bytes);
+static with_error<size_t> get_size(instrumented_heap *heap,
+                                   const void *allocation);
+static usage get_usage(instrumented_heap *heap);
+static void record_malloc(instrumented_heap *heap, const void *call_site,
+                          size_t bytes, uint64_t cycles);
+static void record_free(instrumented_heap *heap, size_t bytes,
+                        uint64_t cycles);
+static void record_call_site(instrumented_heap *heap, const void *address,
+                             size_t bytes);
+[[nodiscard]] static size_t get_usable_size(instrumented_heap *heap,
+                                            const void *allocation);
+[[nodiscard]] static size_t get_latency_bucket(uint64_t cycles);
+static void dump_latencies(const char *name, const size_t *buckets);
+static void dump_call_sites(instrumented_heap *heap);
+
+instrumented_heap make_instrumented_heap(
+    ::memory::allocation::allocator *inner, bool track_call_sites) {
+    instrumented_heap heap{
+        .malloc = malloc,
+        .free = free,
+        ._inner = inner,
+        ._statistics = {},
+        ._track_call_sites = track_call_sites,
+        ._untracked_mallocs = 0,
+    };
+
+    for (size_t i = 0; i < CALL_SITES; i++) {
+        heap._call_sites[i] = call_site{
+            .address = nullptr,
+            .mallocs = 0,
+            .bytes = 0,
+        };
+    }
+
+    return heap;
+}
+
+::memory::allocation::allocator make_allocator(instrumented_heap *heap) {
+    return ::memory::allocation::allocator{
+        .self = heap,
+        ._malloc = reinterpret_cast<MallocType>(malloc),
+        ._free = reinterpret_cast<FreeType>(free),
+        ._aligned_malloc = reinterpret_cast<AlignedMallocType>(aligned_malloc),
+        ._sized_free = reinterpret_cast<SizedFreeType>(sized_free),
+        ._grow_in_place = reinterpret_cast<GrowInPlaceType>(grow_in_place),
+        ._get_size = reinterpret_cast<GetSizeType>(get_size),
+        ._get_usage = reinterpret_cast<GetUsageType>(get_usage),
+    };
+}
+
+void dump(instrumented_heap *heap) {
+    const statistics &statistics = heap->_statistics;
+    char line[LINE_SIZE] = "";
+
+    utilities::append(line, LINE_SIZE, "heap: ");
+    utilities::append_decimal(line, LINE_SIZE, statistics.live_allocations);
+    utilities::append(line, LINE_SIZE, " live allocations, ");
+    utilities::append_decimal(line, LINE_SIZE, statistics.live_bytes);
+    utilities::append(line, LINE_SIZE, " bytes live, ");
+    utilities::append_decimal(line, LINE_SIZE, statistics.peak_bytes);
+    utilities::append(line, LINE_SIZE, " bytes peak");
+    logging::info(line);
+
+    line[0] = '\0';
+    utilities::append(line, LINE_SIZE, "heap: ");
+    utilities::append_decimal(line, LINE_SIZE, statistics.mallocs);
+    utilities::append(line, LINE_SIZE, " mallocs (");
+    utilities::append_decimal(line, LINE_SIZE, statistics.failed_mallocs);
+    utilities::append(line, LINE_SIZE, " failed), ");
+    utilities::append_decimal(line, LINE_SIZE, statistics.frees);
+    utilities::append(line, LINE_SIZE, " frees (");
+    utilities::append_decimal(line, LINE_SIZE, statistics.failed_frees);
+    utilities::append(line, LINE_SIZE, " failed)");
+    logging::info(line);
+
+    auto [usage, error] = try_get_usage(heap->_inner);
+    if (!errors::set(error)) {
+        line[0] = '\0';
+        utilities::append(line, LINE_SIZE, "heap: ");
+        utilities::append_decimal(line, LINE_SIZE, usage.used_bytes);
+        utilities::append(line, LINE_SIZE, " bytes used, ");
+        utilities::append_decimal(line, LINE_SIZE, usage.free_bytes);
+        utilities::append(line, LINE_SIZE, " free in ");
+        utilities::append_decimal(line, LINE_SIZE, usage.free_extents);
+        utilities::append(line, LINE_SIZE, " extents, largest ");
+        utilities::append_decimal(line, LINE_SIZE, usage.largest_free_bytes);
+        utilities::append(line, LINE_SIZE, ", fragmentation ");
+        utilities::append_decimal(line, LINE_SIZE, get_fragmentation(usage));
+        utilities::append(line, LINE_SIZE, "%");
+        logging::info(line);
+    }
+
+    dump_latencies("malloc", statistics.malloc_cycles);
+    dump_latencies("free", statistics.free_cycles);
+
+    if (heap->_track_call_sites) {
+        dump_call_sites(heap);
+    }
+}
+
+with_error<void *> malloc(instrumented_heap *heap, size_t bytes) {
+    // Must be read before forwarding, which overwrites it.
+    const void *const call_site = get_call_site();
+
+    const uint64_t start = utilities::read_cycles();
+    auto [allocation, error] = try_malloc(heap->_inner, bytes);
+    const uint64_t cycles = utilities::read_cycles() - start;
+
+    if (errors::set(error)) {
+        heap->_statistics.failed_mallocs++;
+        return {nullptr, error};
+    }
+
+    record_malloc(heap, call_site, bytes, cycles);
+
+    return {allocation, errors::nil()};
+}
+
+with_error<void *> aligned_malloc(instrumented_heap *heap, size_t bytes,
+                                  size_t alignment) {
+    const void *const call_site = get_call_site();
+
+    const uint64_t start = utilities::read_cycles();
+    auto [allocation, error] =
+        try_aligned_malloc(heap->_inner, bytes, alignment);
+    const uint64_t cycles = utilities::read_cycles() - start;
+
+    if (errors::set(error)) {
+        heap->_statistics.failed_mallocs++;
+        return {nullptr, error};
+    }
+
+    record_malloc(heap, call_site, bytes, cycles);
+
+    return {allocation, errors::nil()};
+}
+
+error free(instrumented_heap *heap, const void *allocation) {
+    // Only unsized frees have to ask the wrapped allocator for the size.
+    const size_t usable_size = get_usable_size(heap, allocation);
+
+    const uint64_t start = utilities::read_cycles();
+    error error = try_free(heap->_inner, allocation);
+    const uint64_t cycles = utilities::read_cycles() - start;
+
+    if (errors::set(error)) {
+        heap->_statistics.failed_frees++;
+        return error;
+    }
+
+    record_free(heap, usable_size, cycles);
+
+    return errors::nil();
+}
+
+error sized_free(instrumented_heap *heap, const void *allocation,
+                 size_t bytes) {
+    const uint64_t start = utilities::read_cycles();
+    error error = try_free(heap->_inner, allocation, bytes);
+    const uint64_t cycles = utilities::read_cycles() - start;
+
+    if (errors::set(error)) {
+        heap->_statistics.failed_frees++;
+        return error;
+    }
+
+    record_free(heap, bytes, cycles);
+
+    return errors::nil();
+}
+
+error grow_in_place(instrumented_heap *heap, const void *allocation,
+                    size_t bytes, size_t new_bytes) {
+    error error = try_grow_in_place(heap->_inner, allocation, bytes, new_bytes);
+    if (errors::set(error)) {
+        return error;
+    }
+
+    statistics *const statistics = &heap->_statistics;
+    statistics->live_bytes -=
+        bytes < statistics->live_bytes ? bytes : statistics->live_bytes;
+    statistics->live_bytes += new_bytes;
+    if (statistics->live_bytes > statistics->peak_bytes) {
+        statistics->peak_bytes = statistics->live_bytes;
+    }
+
+    return errors::nil();
+}
+
+with_error<size_t> get_size(instrumented_heap *heap, const void *allocation) {
+    return try_get_size(heap->_inner, allocation);
+}
+
+usage get_usage(instrumented_heap *heap) {
+    auto [usage, error] = try_get_usage(heap->_inner);
+    if (errors::set(error)) {
+        return ::memory::allocation::usage{};
+    }
+
+    return usage;
+}
+
+void record_malloc(instrumented_heap *heap, const void *call_site,
+                   size_t bytes, uint64_t cycles) {
+    statistics *const statistics = &heap->_statistics;
+
+    statistics->mallocs++;
+    statistics->live_allocations++;
+    statistics->live_bytes += bytes;
+    if (statistics->live_bytes > statistics->peak_bytes) {
+        statistics->peak_bytes = statistics->live_bytes;
+    }
+    statistics->malloc_cycles[get_latency_bucket(cycles)]++;
+
+    if (heap->_track_call_sites) {
+        record_call_site(heap, call_site, bytes);
+    }
+}
+
+void record_free(instrumented_heap *heap, size_t bytes, uint64_t cycles) {
+    statistics *const statistics = &heap->_statistics;
+
+    statistics->frees++;
+    statistics->live_allocations--;
+    // Unsized frees count the usable size, which may be more than was
+    // requested.
+    statistics->live_bytes -=
+        bytes < statistics->live_bytes ? bytes : statistics->live_bytes;
+    statistics->free_cycles[get_latency_bucket(cycles)]++;
+}
+
+void record_call_site(instrumented_heap *heap, const void *address,
+                      size_t bytes) {
+    // Open addressing with linear probing. Entries are never removed, so the
+    // first unused entry ends the search.
+    const size_t hash =
+        (reinterpret_cast<uintptr_t>(address) >> 2) % CALL_SITES;
+
+    for (size_t probe = 0; probe < CALL_SITES; probe++) {
+        call_site *const site = &heap->_call_sites[(hash + probe) % CALL_SITES];
+
+        if (site->address == nullptr) {
+            site->address = address;
+        }
+
+        if (site->address == address) {
+            site->mallocs++;
+            site->bytes += bytes;
+            return;
+        }
+    }
+
+    heap->_untracked_mallocs++;
+}
+
+size_t get_usable_size(instrumented_heap *heap, const void *allocation) {
+    auto [size, error] = try_get_size(heap->_inner, allocation);
+    if (errors::set(error)) {
+        return 0;
+    }
+
+    return size;
+}
+
+size_t get_latency_bucket(uint64_t cycles) {
+    constexpr size_t BITS_PER_WORD = 32;
+
+    if ((cycles >> BITS_PER_WORD) != 0) {
+        return LATENCY_BUCKETS - 1;
+    }
+
+    const uint32_t low = static_cast<uint32_t>(cycles);
+    if (low == 0) {
+        return 0;
+    }
+
+    const size_t bucket =
+        BITS_PER_WORD - 1 - utilities::count_leading_zeros(low);
+    return bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1;
+}
+
+void dump_latencies(const char *name, const size_t *buckets) {
+    char line[LINE_SIZE] = "";
+
+    utilities::append(line, LINE_SIZE, "heap: ");
+    utilities::append(line, LINE_SIZE, name);
+    utilities::append(line, LINE_SIZE, " cycles (log2:count)");
+
+    for (size_t bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+        if (buckets[bucket] == 0) {
+            continue;
+        }
+
+        utilities::append(line, LINE_SIZE, " ");
+        utilities::append_decimal(line, LINE_SIZE, bucket);
+        utilities::append(line, LINE_SIZE, ":");
+        utilities::append_decimal(line, LINE_SIZE, buckets[bucket]);
+    }
+
+    logging::info(line);
+}
+
+void dump_call_sites(instrumented_heap *heap) {
+    bool dumped[CALL_SITES] = {};
+
+    // Selection of the busiest sites. Both counts are tiny, so this is
+    // cheaper than sorting.
+    for (size_t i = 0; i < DUMPED_CALL_SITES; i++) {
+        const call_site *busiest = nullptr;
+        size_t busiest_index = 0;
+
+        for (size_t j = 0; j < CALL_SITES; j++) {
+            const call_site *const site = &heap->_call_sites[j];
+            if (site->address == nullptr || dumped[j]) {
+                continue;
+            }
+
+            if (busiest == nullptr || site->bytes > busiest->bytes) {
+                busiest = site;
+                busiest_index = j;
+            }
+        }
+
+        if (busiest == nullptr) {
+            break;
+        }
+
+        dumped[busiest_index] = true;
+
+        char line[LINE_SIZE] = "";
+        utilities::append(line, LINE_SIZE, "heap: ");
+        utilities::append_hex(line, LINE_SIZE,
+                              reinterpret_cast<uintptr_t>(busiest->address));
+        utilities::append(line, LINE_SIZE, " ");
+        utilities::append_decimal(line, LINE_SIZE, busiest->mallocs);
+        utilities::append(line, LINE_SIZE, " mallocs, ");
+        utilities::append_decimal(line, LINE_SIZE, busiest->bytes);
+        utilities::append(line, LINE_SIZE, " bytes");
+        logging::info(line);
+    }
+
+    if (heap->_untracked_mallocs != 0) {
+        char line[LINE_SIZE] = "";
+        utilities::append(line, LINE_SIZE, "heap: ");
+        utilities::append_decimal(line, LINE_SIZE, heap->_untracked_mallocs);
+        utilities::append(line, LINE_SIZE, " mallocs from untracked sites");
+        logging::info(line);
+    }
+}
+
+}  // namespace memory::allocation::instrumented_heap
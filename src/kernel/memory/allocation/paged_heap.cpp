@@ -0,0 +1,241 @@
+#include "memory/allocation/paged_heap.hpp"
+
+#include "memory/paging/paging.hpp"
+
+namespace memory::allocation::paged_heap {
+
+using ::memory::paging::PAGE_SIZE_IN_BYTES;
+
+static with_error<void *> malloc(paged_heap *heap, size_t bytes);
+static with_error<void *> aligned_malloc(paged_heap *heap, size_t bytes,
+                                         size_t alignment);
+static error free(paged_heap *heap, const void *allocation);
+static error sized_free(paged_heap *heap, const void *allocation,
+                        size_t bytes);
+static error grow_in_place(paged_heap *heap, const void *allocation,
+                           size_t bytes, size_t new_bytes);
+static with_error<size_t> get_size(paged_heap *heap, const void *allocation);
+static usage get_usage(paged_heap *heap);
+static with_error<void *> allocate(paged_heap *heap, size_t bytes,
+                                  size_t alignment);
+static error grow(paged_heap *heap, size_t blocks);
+static error after_free(paged_heap *heap, error free_error);
+[[nodiscard]] static size_t divide_round_up(size_t a, size_t b);
+
+size_t metadata_words(size_t bytes) {
+    return bitmap_heap::metadata_words(bytes / PAGE_SIZE_IN_BYTES);
+}
+
+paged_heap make_paged_heap(uint8_t *start, size_t bytes,
+                           bitmap_heap::bitmap_word *metadata,
+                           ::memory::allocation::allocator *frames,
+                           size_t growth_bytes, bool shrink_on_free) {
+    const size_t blocks = bytes / PAGE_SIZE_IN_BYTES;
+
+    paged_heap heap{
+        .malloc = malloc,
+        .free = free,
+        ._heap = bitmap_heap::make_bitmap_heap(start, metadata,
+                                               PAGE_SIZE_IN_BYTES, blocks),
+        ._frames = frames,
+        ._mapped_blocks = 0,
+        ._growth_blocks = divide_round_up(growth_bytes, PAGE_SIZE_IN_BYTES),
+        ._shrink_on_free = shrink_on_free,
+    };
+
+    bitmap_heap::reserve(&heap._heap, 0, blocks);
+
+    return heap;
+}
+
+::memory::allocation::allocator make_allocator(paged_heap *heap) {
+    return ::memory::allocation::allocator{
+        .self = heap,
+        ._malloc = reinterpret_cast<MallocType>(malloc),
+        ._free = reinterpret_cast<FreeType>(free),
+        ._aligned_malloc = reinterpret_cast<AlignedMallocType>(aligned_malloc),
+        ._sized_free = reinterpret_cast<SizedFreeType>(sized_free),
+        ._grow_in_place = reinterpret_cast<GrowInPlaceType>(grow_in_place),
+        ._get_size = reinterpret_cast<GetSizeType>(get_size),
+        ._get_usage = reinterpret_cast<GetUsageType>(get_usage),
+    };
+}
+
+error shrink(paged_heap *heap) {
+    const size_t kept = heap->_growth_blocks;
+
+    // The last mapped page is released while it and the pages that are kept
+    // before it are all free.
+    while (heap->_mapped_blocks > kept &&
+           bitmap_heap::is_free(&heap->_heap, heap->_mapped_blocks - kept - 1,
+                                kept + 1)) {
+        ::memory::paging::paging *const paging =
+            ::memory::paging::get_loaded();
+        if (paging == nullptr) {
+            return errors::make(WITH_LOCATION("paging is not loaded"));
+        }
+
+        const size_t last = heap->_mapped_blocks - 1;
+        bitmap_heap::reserve(&heap->_heap, last, 1);
+
+        auto [frame, unmap_error] = ::memory::paging::unmap(
+            paging, heap->_heap._start + last * PAGE_SIZE_IN_BYTES);
+        if (errors::set(unmap_error)) {
+            bitmap_heap::unreserve(&heap->_heap, last, 1);
+            errors::enrich(&unmap_error, "unmap heap page");
+            return unmap_error;
+        }
+
+        heap->_mapped_blocks = last;
+
+        error free_error = try_free(heap->_frames, frame, PAGE_SIZE_IN_BYTES);
+        if (errors::set(free_error)) {
+            errors::enrich(&free_error, "free heap frame");
+            return free_error;
+        }
+    }
+
+    return errors::nil();
+}
+
+with_error<void *> malloc(paged_heap *heap, size_t bytes) {
+    return allocate(heap, bytes, 1);
+}
+
+with_error<void *> aligned_malloc(paged_heap *heap, size_t bytes,
+                                  size_t alignment) {
+    return allocate(heap, bytes, alignment);
+}
+
+error free(paged_heap *heap, const void *allocation) {
+    ::memory::allocation::allocator blocks =
+        bitmap_heap::make_allocator(&heap->_heap);
+    return after_free(heap, try_free(&blocks, allocation));
+}
+
+error sized_free(paged_heap *heap, const void *allocation, size_t bytes) {
+    ::memory::allocation::allocator blocks =
+        bitmap_heap::make_allocator(&heap->_heap);
+    return after_free(heap, try_free(&blocks, allocation, bytes));
+}
+
+error grow_in_place(paged_heap *heap, const void *allocation, size_t bytes,
+                    size_t new_bytes) {
+    ::memory::allocation::allocator blocks =
+        bitmap_heap::make_allocator(&heap->_heap);
+    error error = try_grow_in_place(&blocks, allocation, bytes, new_bytes);
+
+    // Shrinking frees the tail, which may leave whole pages unused.
+    return new_bytes < bytes ? after_free(heap, error) : error;
+}
+
+with_error<size_t> get_size(paged_heap *heap, const void *allocation) {
+    ::memory::allocation::allocator blocks =
+        bitmap_heap::make_allocator(&heap->_heap);
+    return try_get_size(&blocks, allocation);
+}
+
+usage get_usage(paged_heap *heap) {
+    ::memory::allocation::allocator blocks =
+        bitmap_heap::make_allocator(&heap->_heap);
+    auto [usage, usage_error] = try_get_usage(&blocks);
+    if (errors::set(usage_error)) {
+        return {};
+    }
+
+    // Blocks that aren't mapped are reserved, but they aren't memory in use.
+    usage.used_bytes -=
+        (heap->_heap._blocks - heap->_mapped_blocks) * PAGE_SIZE_IN_BYTES;
+
+    return usage;
+}
+
+with_error<void *> allocate(paged_heap *heap, size_t bytes, size_t alignment) {
+    ::memory::allocation::allocator blocks =
+        bitmap_heap::make_allocator(&heap->_heap);
+
+    auto [allocation, allocation_error] =
+        try_aligned_malloc(&blocks, bytes, alignment);
+    if (!errors::set(allocation_error)) {
+        return {allocation, errors::nil()};
+    }
+
+    // New pages extend the free run at the end of the mapped part, so mapping
+    // enough pages for the allocation and its worst case alignment padding
+    // guarantees it fits.
+    const size_t padding_blocks =
+        alignment > PAGE_SIZE_IN_BYTES ? alignment / PAGE_SIZE_IN_BYTES - 1
+                                       : 0;
+    error grow_error =
+        grow(heap, divide_round_up(bytes, PAGE_SIZE_IN_BYTES) + padding_blocks);
+    if (errors::set(grow_error)) {
+        errors::enrich(&grow_error, "grow heap");
+        return {nullptr, grow_error};
+    }
+
+    return try_aligned_malloc(&blocks, bytes, alignment);
+}
+
+error grow(paged_heap *heap, size_t blocks) {
+    ::memory::paging::paging *const paging = ::memory::paging::get_loaded();
+    if (paging == nullptr) {
+        return errors::make(WITH_LOCATION("paging is not loaded"));
+    }
+
+    const size_t unmapped_blocks = heap->_heap._blocks - heap->_mapped_blocks;
+    if (unmapped_blocks == 0) {
+        return errors::make(WITH_LOCATION("heap range is exhausted"));
+    }
+
+    if (blocks < heap->_growth_blocks) {
+        blocks = heap->_growth_blocks;
+    }
+    if (blocks > unmapped_blocks) {
+        blocks = unmapped_blocks;
+    }
+
+    for (size_t i = 0; i < blocks; i++) {
+        auto [frame, frame_error] = try_aligned_malloc(
+            heap->_frames, PAGE_SIZE_IN_BYTES, PAGE_SIZE_IN_BYTES);
+        if (errors::set(frame_error)) {
+            errors::enrich(&frame_error, "allocate heap frame");
+            return frame_error;
+        }
+
+        error map_error = ::memory::paging::map(
+            paging,
+            heap->_heap._start + heap->_mapped_blocks * PAGE_SIZE_IN_BYTES,
+            frame,
+            {
+                .priviledge_level = ::memory::paging::PriviledgeLevel::KERNEL,
+                .access_type = ::memory::paging::AccessType::READ_WRITE,
+                .global = ::memory::paging::Global::TRUE,
+            });
+        if (errors::set(map_error)) {
+            ::memory::allocation::free(heap->_frames, frame,
+                                       PAGE_SIZE_IN_BYTES);
+            errors::enrich(&map_error, "map heap page");
+            return map_error;
+        }
+
+        // Pages that were mapped stay mapped even if a later one fails.
+        bitmap_heap::unreserve(&heap->_heap, heap->_mapped_blocks, 1);
+        heap->_mapped_blocks++;
+    }
+
+    return errors::nil();
+}
+
+error after_free(paged_heap *heap, error free_error) {
+    if (errors::set(free_error) || !heap->_shrink_on_free) {
+        return free_error;
+    }
+
+    return shrink(heap);
+}
+
+size_t divide_round_up(size_t a, size_t b) {
+    return (a + b - 1) / b;
+}
+
+}  // namespace memory::allocation::paged_heap
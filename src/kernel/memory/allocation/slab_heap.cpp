@@ -0,0 +1,322 @@
+#include "memory/allocation/slab_heap.hpp"
+
+#include <cassert>
+
+#include "memory/allocation/alignment.hpp"
+
+namespace memory::allocation::slab_heap {
+
+static with_error<void *> malloc(slab_heap *heap, size_t bytes);
+static with_error<void *> aligned_malloc(slab_heap *heap, size_t bytes,
+                                         size_t alignment);
+static error free(slab_heap *heap, const void *allocation);
+static error sized_free(slab_heap *heap, const void *allocation,
+                        size_t bytes);
+static error grow_in_place(slab_heap *heap, const void *allocation,
+                           size_t bytes, size_t new_bytes);
+static with_error<size_t> get_size(slab_heap *heap, const void *allocation);
+static usage get_usage(slab_heap *heap);
+[[nodiscard]] static size_t round_up(size_t value, size_t multiple);
+[[nodiscard]] static size_t get_size_class(size_t bytes);
+static with_error<slab *> make_slab(slab_heap *heap, size_t size_class);
+static void push(slab **list, slab *slab);
+static void remove(slab **list, slab *slab);
+[[nodiscard]] static bool is_slab_aligned(const slab_heap *heap,
+                                          const void *address);
+
+slab_heap make_slab_heap(::memory::allocation::allocator *backing,
+                         size_t slab_size) {
+    assertm(slab_size >= MIN_LARGEST_OBJECTS_PER_SLAB * LARGEST_SIZE_CLASS &&
+                (slab_size & (slab_size - 1)) == 0,
+            "slab size must be a power of two that fits the largest objects");
+
+    slab_heap heap{
+        .malloc = malloc,
+        .free = free,
+        ._backing = backing,
+        ._slab_size = slab_size,
+    };
+
+    size_t object_size = SMALLEST_SIZE_CLASS;
+    for (size_t size_class = 0; size_class < SIZE_CLASSES; size_class++) {
+        const size_t first_object_offset = round_up(sizeof(slab), object_size);
+
+        heap._caches[size_class] = cache{
+            .object_size = object_size,
+            .objects_per_slab =
+                (slab_size - first_object_offset) / object_size,
+            .first_object_offset = first_object_offset,
+            .partial = nullptr,
+            .full = nullptr,
+        };
+
+        object_size *= 2;
+    }
+
+    return heap;
+}
+
+::memory::allocation::allocator make_allocator(slab_heap *heap) {
+    return ::memory::allocation::allocator{
+        .self = heap,
+        ._malloc = reinterpret_cast<MallocType>(malloc),
+        ._free = reinterpret_cast<FreeType>(free),
+        ._aligned_malloc = reinterpret_cast<AlignedMallocType>(aligned_malloc),
+        ._sized_free = reinterpret_cast<SizedFreeType>(sized_free),
+        ._grow_in_place = reinterpret_cast<GrowInPlaceType>(grow_in_place),
+        ._get_size = reinterpret_cast<GetSizeType>(get_size),
+        ._get_usage = reinterpret_cast<GetUsageType>(get_usage),
+    };
+}
+
+with_error<void *> malloc(slab_heap *heap, size_t bytes) {
+    if (bytes == 0) {
+        return {nullptr, errors::make(WITH_LOCATION("can't allocate 0 bytes"))};
+    }
+
+    if (bytes > LARGEST_SIZE_CLASS) {
+        auto [allocation, error] = try_malloc(heap->_backing, bytes);
+        if (errors::set(error)) {
+            errors::enrich(&error, "allocate from backing allocator");
+            return {nullptr, error};
+        }
+
+        if (!is_slab_aligned(heap, allocation)) {
+            try_free(heap->_backing, allocation);
+            return {nullptr,
+                    errors::make(WITH_LOCATION(
+                        "backing allocation is not aligned to slab size"))};
+        }
+
+        return {allocation, errors::nil()};
+    }
+
+    const size_t size_class = get_size_class(bytes);
+    cache *const cache = &heap->_caches[size_class];
+
+    if (cache->partial == nullptr) {
+        auto [new_slab, error] = make_slab(heap, size_class);
+        if (errors::set(error)) {
+            errors::enrich(&error, "make slab");
+            return {nullptr, error};
+        }
+
+        push(&cache->partial, new_slab);
+    }
+
+    slab *const slab = cache->partial;
+    void *const object = slab->free_objects;
+    slab->free_objects = *static_cast<void **>(object);
+    slab->used_objects++;
+
+    if (slab->free_objects == nullptr) {
+        remove(&cache->partial, slab);
+        push(&cache->full, slab);
+    }
+
+    return {object, errors::nil()};
+}
+
+with_error<void *> aligned_malloc(slab_heap *heap, size_t bytes,
+                                  size_t alignment) {
+    if (!is_power_of_two(alignment)) {
+        return {nullptr, errors::make(WITH_LOCATION(
+                             "alignment must be a power of two"))};
+    }
+
+    // Objects are aligned to their size class, so a small allocation only
+    // has to be rounded up to the alignment.
+    if (bytes <= LARGEST_SIZE_CLASS && alignment <= LARGEST_SIZE_CLASS) {
+        return malloc(heap, bytes > alignment ? bytes : alignment);
+    }
+
+    // Large allocations must stay slab aligned so free() can tell them apart
+    // from objects.
+    auto [allocation, error] = try_aligned_malloc(
+        heap->_backing, bytes,
+        alignment > heap->_slab_size ? alignment : heap->_slab_size);
+    if (errors::set(error)) {
+        errors::enrich(&error, "allocate from backing allocator");
+        return {nullptr, error};
+    }
+
+    return {allocation, errors::nil()};
+}
+
+error free(slab_heap *heap, const void *allocation) {
+    if (is_slab_aligned(heap, allocation)) {
+        return try_free(heap->_backing, allocation);
+    }
+
+    const uintptr_t address = reinterpret_cast<uintptr_t>(allocation);
+    slab *const slab =
+        reinterpret_cast<struct slab *>(address & ~(heap->_slab_size - 1));
+
+    if (slab->size_class >= SIZE_CLASSES) {
+        return errors::make(WITH_LOCATION("address to free is not in a slab"));
+    }
+
+    cache *const cache = &heap->_caches[slab->size_class];
+    const size_t offset = address - reinterpret_cast<uintptr_t>(slab);
+    if (offset < cache->first_object_offset ||
+        (offset - cache->first_object_offset) % cache->object_size != 0) {
+        return errors::make(
+            WITH_LOCATION("address to free is not the start of an object"));
+    }
+
+    if (slab->free_objects == nullptr) {
+        remove(&cache->full, slab);
+        push(&cache->partial, slab);
+    }
+
+    void **const object =
+        const_cast<void **>(static_cast<void *const *>(allocation));
+    *object = slab->free_objects;
+    slab->free_objects = object;
+    slab->used_objects--;
+
+    if (slab->used_objects == 0) {
+        remove(&cache->partial, slab);
+        return try_free(heap->_backing, slab);
+    }
+
+    return errors::nil();
+}
+
+error sized_free(slab_heap *heap, const void *allocation, size_t bytes) {
+    if (is_slab_aligned(heap, allocation)) {
+        return try_free(heap->_backing, allocation, bytes);
+    }
+
+    return free(heap, allocation);
+}
+
+error grow_in_place(slab_heap *heap, const void *allocation, size_t bytes,
+                    size_t new_bytes) {
+    if (is_slab_aligned(heap, allocation)) {
+        return try_grow_in_place(heap->_backing, allocation, bytes, new_bytes);
+    }
+
+    // An object can only grow within its size class.
+    const uintptr_t address = reinterpret_cast<uintptr_t>(allocation);
+    const slab *const slab = reinterpret_cast<const struct slab *>(
+        address & ~(heap->_slab_size - 1));
+
+    if (slab->size_class >= SIZE_CLASSES) {
+        return errors::make(WITH_LOCATION("address is not in a slab"));
+    }
+
+    if (new_bytes > heap->_caches[slab->size_class].object_size) {
+        return errors::make(
+            WITH_LOCATION("new size doesn't fit in the size class"));
+    }
+
+    return errors::nil();
+}
+
+with_error<size_t> get_size(slab_heap *heap, const void *allocation) {
+    if (is_slab_aligned(heap, allocation)) {
+        return try_get_size(heap->_backing, allocation);
+    }
+
+    const uintptr_t address = reinterpret_cast<uintptr_t>(allocation);
+    const slab *const slab = reinterpret_cast<const struct slab *>(
+        address & ~(heap->_slab_size - 1));
+
+    if (slab->size_class >= SIZE_CLASSES) {
+        return {0, errors::make(WITH_LOCATION("address is not in a slab"))};
+    }
+
+    return {heap->_caches[slab->size_class].object_size, errors::nil()};
+}
+
+usage get_usage(slab_heap *heap) {
+    // Slabs count as used memory of the backing allocator, including their
+    // free objects.
+    auto [backing_usage, error] = try_get_usage(heap->_backing);
+    if (errors::set(error)) {
+        return usage{};
+    }
+
+    return backing_usage;
+}
+
+size_t round_up(size_t value, size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+size_t get_size_class(size_t bytes) {
+    size_t size_class = 0;
+    for (size_t object_size = SMALLEST_SIZE_CLASS; object_size < bytes;
+         object_size *= 2) {
+        size_class++;
+    }
+    return size_class;
+}
+
+with_error<slab *> make_slab(slab_heap *heap, size_t size_class) {
+    auto [allocation, error] = try_malloc(heap->_backing, heap->_slab_size);
+    if (errors::set(error)) {
+        errors::enrich(&error, "allocate from backing allocator");
+        return {nullptr, error};
+    }
+
+    if (!is_slab_aligned(heap, allocation)) {
+        try_free(heap->_backing, allocation);
+        return {nullptr, errors::make(WITH_LOCATION(
+                             "slab is not aligned to slab size"))};
+    }
+
+    const cache *const cache = &heap->_caches[size_class];
+    slab *const slab = static_cast<struct slab *>(allocation);
+    uint8_t *const objects =
+        static_cast<uint8_t *>(allocation) + cache->first_object_offset;
+
+    slab->previous = nullptr;
+    slab->next = nullptr;
+    slab->used_objects = 0;
+    slab->size_class = size_class;
+    slab->free_objects = nullptr;
+
+    // Link the objects from last to first, so they are handed out in order.
+    for (size_t i = cache->objects_per_slab; i > 0; i--) {
+        void **const object =
+            reinterpret_cast<void **>(objects + (i - 1) * cache->object_size);
+        *object = slab->free_objects;
+        slab->free_objects = object;
+    }
+
+    return {slab, errors::nil()};
+}
+
+void push(slab **list, slab *slab) {
+    slab->previous = nullptr;
+    slab->next = *list;
+    if (*list != nullptr) {
+        (*list)->previous = slab;
+    }
+    *list = slab;
+}
+
+void remove(slab **list, slab *slab) {
+    if (slab->previous != nullptr) {
+        slab->previous->next = slab->next;
+    } else {
+        *list = slab->next;
+    }
+
+    if (slab->next != nullptr) {
+        slab->next->previous = slab->previous;
+    }
+
+    slab->previous = nullptr;
+    slab->next = nullptr;
+}
+
+bool is_slab_aligned(const slab_heap *heap, const void *address) {
+    const uintptr_t offset_in_slab =
+        reinterpret_cast<uintptr_t>(address) & (heap->_slab_size - 1);
+    return offset_in_slab == 0;
+}
+
+}  // namespace memory::allocation::slab_heap
@@ -0,0 +1,179 @@
+#include "memory/allocation/virtual_heap.hpp"
+
+#include "memory/paging/faults.hpp"
+#include "memory/paging/paging.hpp"
+
+namespace memory::allocation::virtual_heap {
+
+using ::memory::paging::PAGE_SIZE_IN_BYTES;
+
+// Pages reserved after every allocation that are in no region, so they are
+// never mapped.
+constexpr size_t GUARD_PAGES = 1;
+
+static with_error<void *> malloc(virtual_heap *heap, size_t bytes);
+static with_error<void *> aligned_malloc(virtual_heap *heap, size_t bytes,
+                                         size_t alignment);
+static error free(virtual_heap *heap, const void *allocation);
+static error sized_free(virtual_heap *heap, const void *allocation,
+                        size_t bytes);
+static with_error<size_t> get_size(virtual_heap *heap,
+                                   const void *allocation);
+static usage get_usage(virtual_heap *heap);
+static error add_region(virtual_heap *heap, uint8_t *start, size_t pages);
+static error remove_region(const uint8_t *start);
+[[nodiscard]] static size_t divide_round_up(size_t a, size_t b);
+
+size_t metadata_words(size_t bytes) {
+    return bitmap_heap::metadata_words(bytes / PAGE_SIZE_IN_BYTES);
+}
+
+virtual_heap make_virtual_heap(uint8_t *start, size_t bytes,
+                               bitmap_heap::bitmap_word *metadata,
+                               ::memory::allocation::allocator *frames) {
+    return virtual_heap{
+        .malloc = malloc,
+        .free = free,
+        ._pages = bitmap_heap::make_bitmap_heap(
+            start, metadata, PAGE_SIZE_IN_BYTES, bytes / PAGE_SIZE_IN_BYTES),
+        ._frames = frames,
+    };
+}
+
+::memory::allocation::allocator make_allocator(virtual_heap *heap) {
+    return ::memory::allocation::allocator{
+        .self = heap,
+        ._malloc = reinterpret_cast<MallocType>(malloc),
+        ._free = reinterpret_cast<FreeType>(free),
+        ._aligned_malloc = reinterpret_cast<AlignedMallocType>(aligned_malloc),
+        ._sized_free = reinterpret_cast<SizedFreeType>(sized_free),
+        ._get_size = reinterpret_cast<GetSizeType>(get_size),
+        ._get_usage = reinterpret_cast<GetUsageType>(get_usage),
+    };
+}
+
+with_error<void *> malloc(virtual_heap *heap, size_t bytes) {
+    return aligned_malloc(heap, bytes, PAGE_SIZE_IN_BYTES);
+}
+
+with_error<void *> aligned_malloc(virtual_heap *heap, size_t bytes,
+                                  size_t alignment) {
+    if (bytes == 0) {
+        return {nullptr,
+                errors::make(WITH_LOCATION("can't allocate zero bytes"))};
+    }
+
+    const size_t pages = divide_round_up(bytes, PAGE_SIZE_IN_BYTES);
+
+    ::memory::allocation::allocator ranges =
+        bitmap_heap::make_allocator(&heap->_pages);
+    auto [range, range_error] = try_aligned_malloc(
+        &ranges, (pages + GUARD_PAGES) * PAGE_SIZE_IN_BYTES, alignment);
+    if (errors::set(range_error)) {
+        errors::enrich(&range_error, "reserve virtual range");
+        return {nullptr, range_error};
+    }
+
+    error region_error =
+        add_region(heap, static_cast<uint8_t *>(range), pages);
+    if (errors::set(region_error)) {
+        ::memory::allocation::free(&ranges, range);
+        errors::enrich(&region_error, "back virtual range");
+        return {nullptr, region_error};
+    }
+
+    return {range, errors::nil()};
+}
+
+error free(virtual_heap *heap, const void *allocation) {
+    auto [size, size_error] = get_size(heap, allocation);
+    if (errors::set(size_error)) {
+        return size_error;
+    }
+
+    error region_error =
+        remove_region(static_cast<const uint8_t *>(allocation));
+
+    ::memory::allocation::allocator ranges =
+        bitmap_heap::make_allocator(&heap->_pages);
+    error free_error = try_free(&ranges, allocation);
+    if (errors::set(free_error)) {
+        return free_error;
+    }
+
+    return region_error;
+}
+
+error sized_free(virtual_heap *heap, const void *allocation, size_t bytes) {
+    auto [size, size_error] = get_size(heap, allocation);
+    if (errors::set(size_error)) {
+        return size_error;
+    }
+
+    if (bytes > size) {
+        return errors::make(WITH_LOCATION("size doesn't match allocation"));
+    }
+
+    return free(heap, allocation);
+}
+
+with_error<size_t> get_size(virtual_heap *heap, const void *allocation) {
+    ::memory::allocation::allocator ranges =
+        bitmap_heap::make_allocator(&heap->_pages);
+    auto [size, size_error] = try_get_size(&ranges, allocation);
+    if (errors::set(size_error)) {
+        return {0, size_error};
+    }
+
+    return {size - GUARD_PAGES * PAGE_SIZE_IN_BYTES, errors::nil()};
+}
+
+usage get_usage(virtual_heap *heap) {
+    // Usage is that of the virtual memory range, guard pages included.
+    ::memory::allocation::allocator ranges =
+        bitmap_heap::make_allocator(&heap->_pages);
+    auto [usage, usage_error] = try_get_usage(&ranges);
+    if (errors::set(usage_error)) {
+        return {};
+    }
+
+    return usage;
+}
+
+error add_region(virtual_heap *heap, uint8_t *start, size_t pages) {
+    ::memory::paging::paging *const paging = ::memory::paging::get_loaded();
+    if (paging == nullptr) {
+        return errors::make(WITH_LOCATION("paging is not loaded"));
+    }
+
+    return ::memory::paging::add_region(
+        paging,
+        {
+            .start = reinterpret_cast<const std::byte *>(start),
+            .bytes = pages * PAGE_SIZE_IN_BYTES,
+            .type = ::memory::paging::regions::Type::ANONYMOUS,
+            .page_flags =
+                {
+                    .priviledge_level =
+                        ::memory::paging::PriviledgeLevel::KERNEL,
+                    .access_type = ::memory::paging::AccessType::READ_WRITE,
+                    .global = ::memory::paging::Global::TRUE,
+                },
+            .frames = heap->_frames,
+        });
+}
+
+error remove_region(const uint8_t *start) {
+    ::memory::paging::paging *const paging = ::memory::paging::get_loaded();
+    if (paging == nullptr) {
+        return errors::make(WITH_LOCATION("paging is not loaded"));
+    }
+
+    return ::memory::paging::remove_region(paging, start);
+}
+
+size_t divide_round_up(size_t a, size_t b) {
+    return (a + b - 1) / b;
+}
+
+}  // namespace memory::allocation::virtual_heap
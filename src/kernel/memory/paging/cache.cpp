@@ -0,0 +1,76 @@
+#include "memory/paging/cache.hpp"
+
+#include <stdint.h>
+
+#include "utilities/processor.hpp"
+
+extern "C" void load_page_attribute_table(uint32_t low, uint32_t high);
+
+namespace memory::paging {
+
+// Memory types of page attribute table entries.
+enum class MemoryType : uint32_t {
+    STRONG_UNCACHEABLE = 0x00,
+    WRITE_COMBINING = 0x01,
+    WRITE_THROUGH = 0x04,
+    WRITE_BACK = 0x06,
+    // Like STRONG_UNCACHEABLE, unless the memory type range registers say
+    // write combining.
+    UNCACHEABLE = 0x07,
+};
+
+static bool page_attributes_enabled = false;
+
+[[nodiscard]] static uint32_t make_table_half(MemoryType first,
+                                              MemoryType second,
+                                              MemoryType third,
+                                              MemoryType fourth);
+
+void init_cache_policies() {
+    if (!utilities::has_feature(utilities::Feature::PAGE_ATTRIBUTE_TABLE)) {
+        return;
+    }
+
+    // The first half keeps the power-on entries, which the page attribute bit
+    // being clear selects. The second half only differs in its first entry,
+    // which is write combining.
+    load_page_attribute_table(
+        make_table_half(MemoryType::WRITE_BACK, MemoryType::WRITE_THROUGH,
+                        MemoryType::UNCACHEABLE,
+                        MemoryType::STRONG_UNCACHEABLE),
+        make_table_half(MemoryType::WRITE_COMBINING, MemoryType::WRITE_THROUGH,
+                        MemoryType::UNCACHEABLE,
+                        MemoryType::STRONG_UNCACHEABLE));
+
+    page_attributes_enabled = true;
+}
+
+cache_bits get_cache_bits(CachePolicy policy) {
+    switch (policy) {
+        case CachePolicy::WRITE_BACK:
+            return {false, false, false};
+        case CachePolicy::WRITE_THROUGH:
+            return {false, false, true};
+        case CachePolicy::WRITE_COMBINING:
+            if (page_attributes_enabled) {
+                return {true, false, false};
+            }
+            [[fallthrough]];
+        case CachePolicy::UNCACHED:
+            break;
+    }
+
+    return {false, true, true};
+}
+
+uint32_t make_table_half(MemoryType first, MemoryType second, MemoryType third,
+                         MemoryType fourth) {
+    constexpr size_t ENTRY_BITS = 8;
+
+    return static_cast<uint32_t>(first) |
+           static_cast<uint32_t>(second) << ENTRY_BITS |
+           static_cast<uint32_t>(third) << (2 * ENTRY_BITS) |
+           static_cast<uint32_t>(fourth) << (3 * ENTRY_BITS);
+}
+
+}  // namespace memory::paging
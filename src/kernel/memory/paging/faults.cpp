@@ -0,0 +1,331 @@
+#include "memory/paging/faults.hpp"
+
+#include <cstddef>
+#include <cstring>
+
+#include "interrupts/interrupts.hpp"
+#include "logging/logger.hpp"
+#include "memory/paging/swap.hpp"
+#include "memory/physical/references.hpp"
+#include "utilities/format.hpp"
+
+extern "C" const void* read_page_fault_address();
+
+namespace memory::paging {
+
+// Bits of the page fault error code.
+constexpr uint32_t PROTECTION_VIOLATION = 1 << 0;
+constexpr uint32_t WRITE_ACCESS = 1 << 1;
+constexpr uint32_t USER_ACCESS = 1 << 2;
+
+// The amount of pages evicted at once when there are no free frames.
+constexpr size_t RECLAIM_BATCH = 16;
+
+static error resolve(const void* address, uint32_t error_code);
+static error map_frame(paging* paging, const regions::region* region,
+                       const std::byte* page);
+[[nodiscard]] static with_error<void*> allocate_frame(
+    paging* paging, const regions::region* region);
+static error fill(const regions::region* region, const std::byte* page,
+                  void* frame);
+[[noreturn]] static void halt();
+
+error add_region(paging* paging, const regions::region& description) {
+    if (reinterpret_cast<size_t>(description.start) % PAGE_SIZE_IN_BYTES !=
+            0 ||
+        description.bytes % PAGE_SIZE_IN_BYTES != 0) {
+        return errors::make(
+            WITH_LOCATION("region is not a multiple of page size"));
+    }
+
+    if (description.bytes == 0) {
+        return errors::make(WITH_LOCATION("region is empty"));
+    }
+
+    regions::region_tree* const tree =
+        get_region_tree(paging, description.start, description.bytes);
+    if (tree == nullptr) {
+        return errors::make(WITH_LOCATION("region is partly in the heaps"));
+    }
+
+    auto [region, insert_error] = regions::insert(tree, description);
+    if (errors::set(insert_error)) {
+        errors::enrich(&insert_error, "insert region");
+        return insert_error;
+    }
+
+    // Mapped pages would never fault, so the region could never back them.
+    for (size_t offset = 0; offset < region->bytes;
+         offset += PAGE_SIZE_IN_BYTES) {
+        const std::byte* const page = region->start + offset;
+        if (!is_mapped(paging, page)) {
+            continue;
+        }
+
+        auto [frame, unmap_error] = unmap(paging, page);
+        if (errors::set(unmap_error)) {
+            errors::log(regions::erase(tree, region));
+            errors::enrich(&unmap_error, "unmap page of region");
+            return unmap_error;
+        }
+    }
+
+    return errors::nil();
+}
+
+with_error<const void*> allocate_region(paging* paging, const void* lower,
+                                        const void* upper,
+                                        const regions::region& description) {
+    if (upper <= lower) {
+        return {nullptr, errors::make(WITH_LOCATION("window is empty"))};
+    }
+
+    regions::region_tree* const tree = get_region_tree(
+        paging, lower,
+        static_cast<const std::byte*>(upper) -
+            static_cast<const std::byte*>(lower));
+    if (tree == nullptr) {
+        return {nullptr,
+                errors::make(WITH_LOCATION("window is partly in the heaps"))};
+    }
+
+    auto [start, find_error] = regions::find_free(
+        tree, lower, upper, description.bytes, PAGE_SIZE_IN_BYTES);
+    if (errors::set(find_error)) {
+        errors::enrich(&find_error, "find free range");
+        return {nullptr, find_error};
+    }
+
+    regions::region placed = description;
+    placed.start = start;
+
+    error add_error = add_region(paging, placed);
+    if (errors::set(add_error)) {
+        return {nullptr, add_error};
+    }
+
+    return {start, errors::nil()};
+}
+
+error remove_region(paging* paging, const void* start) {
+    regions::region_tree* const tree = get_region_tree(paging, start, 1);
+    regions::region* const region = regions::find(tree, start);
+    if (region == nullptr || region->start != start) {
+        return errors::make(WITH_LOCATION("no region starts at address"));
+    }
+
+    // The region is removed before its pages, so a failure can't leave it
+    // pointing at frames that were freed.
+    const regions::region removed = *region;
+    error first = regions::erase(tree, region);
+
+    // Keep going after an error, so a single bad page doesn't leak the frames
+    // of the rest.
+    for (size_t offset = 0; offset < removed.bytes;
+         offset += PAGE_SIZE_IN_BYTES) {
+        if (!is_mapped(paging, removed.start + offset)) {
+            swap::discard(paging, removed.start + offset);
+            continue;
+        }
+
+        auto [frame, unmap_error] = unmap(paging, removed.start + offset);
+        if (errors::set(unmap_error)) {
+            if (!errors::set(first)) {
+                first = unmap_error;
+            }
+            continue;
+        }
+
+        // Frames that are still shared with another address space stay
+        // allocated.
+        if (!regions::owns_frames(&removed) ||
+            !::memory::physical::release_frame(frame)) {
+            continue;
+        }
+
+        const error free_error =
+            try_free(removed.frames, frame, PAGE_SIZE_IN_BYTES);
+        if (errors::set(free_error) && !errors::set(first)) {
+            first = free_error;
+        }
+    }
+
+    return first;
+}
+
+void handle_page_fault(uint32_t error_code) {
+    constexpr size_t LINE_SIZE = 80;
+
+    const void* const address = read_page_fault_address();
+
+    error resolve_error = resolve(address, error_code);
+    if (!errors::set(resolve_error)) {
+        return;
+    }
+
+    char line[LINE_SIZE] = "Page fault at ";
+    utilities::append_hex(line, LINE_SIZE, reinterpret_cast<size_t>(address));
+    utilities::append(line, LINE_SIZE, ", error code ");
+    utilities::append_hex(line, LINE_SIZE, error_code);
+    logging::fatal(line);
+    errors::log(resolve_error);
+
+    // Returning would retry the faulting access forever.
+    halt();
+}
+
+error resolve(const void* address, uint32_t error_code) {
+    paging* const paging = get_loaded();
+    if (paging == nullptr) {
+        return errors::make(WITH_LOCATION("paging is not loaded"));
+    }
+
+    const regions::region* const region =
+        regions::find(get_region_tree(paging, address, 1), address);
+
+    const std::byte* const page =
+        static_cast<const std::byte*>(address) -
+        reinterpret_cast<size_t>(address) % PAGE_SIZE_IN_BYTES;
+
+    // The only writes to present pages that are allowed are the first writes
+    // to copy on write pages, which only pages that own frames can be.
+    if ((error_code & PROTECTION_VIOLATION) != 0) {
+        if ((error_code & WRITE_ACCESS) == 0 || region == nullptr ||
+            !regions::owns_frames(region)) {
+            return errors::make(WITH_LOCATION("access violates page rights"));
+        }
+
+        error copy_error = copy_on_write(paging, page, region->frames);
+        if (errors::set(copy_error)) {
+            errors::enrich(&copy_error, "copy page on write");
+        }
+        return copy_error;
+    }
+
+    if (region == nullptr) {
+        return errors::make(WITH_LOCATION("address is not in a region"));
+    }
+
+    if ((error_code & WRITE_ACCESS) != 0 &&
+        region->page_flags.access_type == AccessType::READ_ONLY) {
+        return errors::make(WITH_LOCATION("write to a read only region"));
+    }
+
+    if ((error_code & USER_ACCESS) != 0 &&
+        region->page_flags.priviledge_level == PriviledgeLevel::KERNEL) {
+        return errors::make(WITH_LOCATION("user access to a kernel region"));
+    }
+
+    switch (region->type) {
+        case regions::Type::ANONYMOUS:
+        case regions::Type::FILE:
+            return map_frame(paging, region, page);
+        case regions::Type::MMIO: {
+            error map_error =
+                map(paging, page,
+                    static_cast<const std::byte*>(region->physical_address) +
+                        (page - region->start),
+                    region->page_flags);
+            if (errors::set(map_error)) {
+                errors::enrich(&map_error, "map device page");
+            }
+            return map_error;
+        }
+        case regions::Type::GUARD:
+            return errors::make(WITH_LOCATION("access to a guard region"));
+    }
+
+    return errors::make(WITH_LOCATION("unknown region type"));
+}
+
+error map_frame(paging* paging, const regions::region* region,
+                const std::byte* page) {
+    auto [frame, frame_error] = allocate_frame(paging, region);
+    if (errors::set(frame_error)) {
+        errors::enrich(&frame_error, "allocate region frame");
+        return frame_error;
+    }
+
+    // Pages that were evicted dirty are read back from swap instead.
+    const table::Entry* const pte = get_entry(paging, page);
+    if (pte != nullptr && table::is_swapped(*pte)) {
+        error swap_error = swap::swap_in(paging, region, page, frame);
+        if (errors::set(swap_error)) {
+            ::memory::allocation::free(region->frames, frame,
+                                       PAGE_SIZE_IN_BYTES);
+            errors::enrich(&swap_error, "swap page in");
+        }
+        return swap_error;
+    }
+
+    error fill_error = fill(region, page, frame);
+    if (errors::set(fill_error)) {
+        ::memory::allocation::free(region->frames, frame, PAGE_SIZE_IN_BYTES);
+        errors::enrich(&fill_error, "fill region frame");
+        return fill_error;
+    }
+
+    error map_error = map(paging, page, frame, region->page_flags);
+    if (errors::set(map_error)) {
+        ::memory::allocation::free(region->frames, frame, PAGE_SIZE_IN_BYTES);
+        errors::enrich(&map_error, "map region page");
+        return map_error;
+    }
+
+    return errors::nil();
+}
+
+with_error<void*> allocate_frame(paging* paging,
+                                const regions::region* region) {
+    auto [frame, frame_error] = try_aligned_malloc(
+        region->frames, PAGE_SIZE_IN_BYTES, PAGE_SIZE_IN_BYTES);
+    if (!errors::set(frame_error)) {
+        return {frame, errors::nil()};
+    }
+
+    // Pages that weren't accessed recently make room for the new one.
+    if (swap::reclaim(paging, RECLAIM_BATCH) == 0) {
+        return {nullptr, frame_error};
+    }
+
+    return try_aligned_malloc(region->frames, PAGE_SIZE_IN_BYTES,
+                              PAGE_SIZE_IN_BYTES);
+}
+
+error fill(const regions::region* region, const std::byte* page,
+           void* frame) {
+    namespace ata = drivers::storage::ata;
+
+    constexpr size_t SECTORS_PER_PAGE =
+        PAGE_SIZE_IN_BYTES / ata::SECTOR_SIZE_IN_BYTES;
+
+    // Frames are identity mapped, so they can be written before the page is
+    // mapped.
+    switch (region->type) {
+        case regions::Type::ANONYMOUS:
+            std::memset(frame, 0, PAGE_SIZE_IN_BYTES);
+            return errors::nil();
+        case regions::Type::FILE: {
+            error read_error = ata::read_sectors(
+                region->disk, static_cast<ata::sector*>(frame),
+                region->first_sector +
+                    (page - region->start) / ata::SECTOR_SIZE_IN_BYTES,
+                SECTORS_PER_PAGE);
+            if (errors::set(read_error)) {
+                errors::enrich(&read_error, "read file sectors");
+            }
+            return read_error;
+        }
+        default:
+            return errors::make(WITH_LOCATION("region has no frames"));
+    }
+}
+
+void halt() {
+    DISABLE_INTERRUPTS();
+    while (true) {
+        __asm__("hlt;");
+    }
+}
+
+}  // namespace memory::paging
@@ -9,6 +9,10 @@ namespace memory::paging::directory {
 
 constexpr size_t PAGE_TABLE_ADDRESS_MSB = 31;
 constexpr size_t PAGE_TABLE_ADDRESS_LSB = 12;
+constexpr size_t LARGE_PAGE_ADDRESS_MSB = 31;
+constexpr size_t LARGE_PAGE_ADDRESS_LSB = 22;
+constexpr size_t LARGE_PAGE_PAT_FLAG_OFFSET = 12;
+constexpr size_t LARGE_PAGE_GLOBAL_FLAG_OFFSET = 8;
 constexpr size_t PAGE_SIZE_FLAG_OFFSET = 7;
 constexpr size_t ACCESSED_FLAG_OFFSET = 5;
 constexpr size_t CACHE_DISABLE_FLAG_OFFSET = 4;
@@ -20,8 +24,8 @@ constexpr size_t PRESENT_FLAG_OFFSET = 0;
 Entry make_entry(const PTE* page_table, const Flags& flags) {
     constexpr bool PAGE_SIZE_4KB = 0;
     constexpr bool WASNT_ACCESSED = 0;
-    constexpr bool CACHE_DISABLED = 1;
-    constexpr bool WRITE_THROUGH = 1;
+    constexpr bool CACHE_ENABLED = 0;
+    constexpr bool WRITE_BACK = 0;
 
     const uint32_t page_table_address_field =
         utilities::get_field(reinterpret_cast<uint32_t>(page_table),
@@ -34,8 +38,8 @@ Entry make_entry(const PTE* page_table, const Flags& flags) {
     return page_table_address_field << PAGE_TABLE_ADDRESS_LSB |
            PAGE_SIZE_4KB << PAGE_SIZE_FLAG_OFFSET |
            WASNT_ACCESSED << ACCESSED_FLAG_OFFSET |
-           CACHE_DISABLED << CACHE_DISABLE_FLAG_OFFSET |
-           WRITE_THROUGH << CACHE_WRITE_MODE_FLAG_OFFSET |
+           CACHE_ENABLED << CACHE_DISABLE_FLAG_OFFSET |
+           WRITE_BACK << CACHE_WRITE_MODE_FLAG_OFFSET |
            std::underlying_type_t<PriviledgeLevel>(flags.priviledge_level)
                << PRIVILEDGE_LEVEL_FLAG_OFFSET |
            std::underlying_type_t<AccessType>(flags.access_type)
@@ -44,6 +48,64 @@ Entry make_entry(const PTE* page_table, const Flags& flags) {
                << PRESENT_FLAG_OFFSET;
 }
 
+Entry make_large_entry(const void* page_address, const Flags& flags) {
+    constexpr bool PAGE_SIZE_4MB = 1;
+    constexpr bool WASNT_ACCESSED = 0;
+
+    const cache_bits cache = get_cache_bits(flags.cache_policy);
+
+    const uint32_t page_address_field =
+        utilities::get_field(reinterpret_cast<uint32_t>(page_address),
+                             LARGE_PAGE_ADDRESS_MSB, LARGE_PAGE_ADDRESS_LSB);
+
+    assertm(page_address_field << LARGE_PAGE_ADDRESS_LSB ==
+                reinterpret_cast<uint32_t>(page_address),
+            "Large page address is not properly aligned");
+
+    return page_address_field << LARGE_PAGE_ADDRESS_LSB |
+           cache.page_attribute << LARGE_PAGE_PAT_FLAG_OFFSET |
+           std::underlying_type_t<Global>(flags.global)
+               << LARGE_PAGE_GLOBAL_FLAG_OFFSET |
+           PAGE_SIZE_4MB << PAGE_SIZE_FLAG_OFFSET |
+           WASNT_ACCESSED << ACCESSED_FLAG_OFFSET |
+           cache.cache_disabled << CACHE_DISABLE_FLAG_OFFSET |
+           cache.write_through << CACHE_WRITE_MODE_FLAG_OFFSET |
+           std::underlying_type_t<PriviledgeLevel>(flags.priviledge_level)
+               << PRIVILEDGE_LEVEL_FLAG_OFFSET |
+           std::underlying_type_t<AccessType>(flags.access_type)
+               << ACCESS_TYPE_FLAG_OFFSET |
+           std::underlying_type_t<Present>(flags.present)
+               << PRESENT_FLAG_OFFSET;
+}
+
+bool is_large(Entry entry) {
+    return utilities::get_flag(entry, PAGE_SIZE_FLAG_OFFSET);
+}
+
+const void* get_large_page_address(Entry entry) {
+    const uint32_t address_in_large_pages = utilities::get_field(
+        entry, LARGE_PAGE_ADDRESS_MSB, LARGE_PAGE_ADDRESS_LSB);
+
+    return reinterpret_cast<const void*>(address_in_large_pages
+                                         << LARGE_PAGE_ADDRESS_LSB);
+}
+
+cache_bits get_large_cache_bits(Entry entry) {
+    return {
+        .page_attribute =
+            utilities::get_flag(entry, LARGE_PAGE_PAT_FLAG_OFFSET),
+        .cache_disabled =
+            utilities::get_flag(entry, CACHE_DISABLE_FLAG_OFFSET),
+        .write_through =
+            utilities::get_flag(entry, CACHE_WRITE_MODE_FLAG_OFFSET),
+    };
+}
+
+Global get_large_global(Entry entry) {
+    return static_cast<Global>(
+        utilities::get_flag(entry, LARGE_PAGE_GLOBAL_FLAG_OFFSET));
+}
+
 PTE* get_pte_address(Entry entry) {
     const uint32_t address_in_tables = utilities::get_field(
         entry, PAGE_TABLE_ADDRESS_MSB, PAGE_TABLE_ADDRESS_LSB);
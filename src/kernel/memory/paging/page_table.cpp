@@ -8,6 +8,10 @@ namespace memory::paging::table {
 
 constexpr size_t PAGE_ADDRESS_MSB = 31;
 constexpr size_t PAGE_ADDRESS_LSB = 12;
+// Bits the processor leaves to the operating system.
+constexpr size_t WRITEABLE_WHEN_COPIED_FLAG_OFFSET = 11;
+constexpr size_t SWAPPED_FLAG_OFFSET = 10;
+constexpr size_t COPY_ON_WRITE_FLAG_OFFSET = 9;
 constexpr size_t GLOBAL_FLAG_OFFSET = 8;
 constexpr size_t PAT_FLAG_OFFSET = 7;
 constexpr size_t DIRTY_FLAG_OFFSET = 6;
@@ -19,23 +23,23 @@ constexpr size_t ACCESS_TYPE_FLAG_OFFSET = 1;
 constexpr size_t PRESENT_FLAG_OFFSET = 0;
 
 Entry make_entry(const void* page_address, const Flags& flags) {
-    constexpr bool NOT_GLOBAL = false;
-    constexpr bool PAT_DISABLED = 0;
     constexpr bool NOT_DIRTY = 0;
     constexpr bool WASNT_ACCESSED = 0;
-    constexpr bool CACHE_DISABLED = 1;
-    constexpr bool WRITE_THROUGH = 1;
+
+    const cache_bits cache =
+        ::memory::paging::get_cache_bits(flags.cache_policy);
 
     const uint32_t page_address_field =
         utilities::get_field(reinterpret_cast<uint32_t>(page_address),
                              PAGE_ADDRESS_MSB, PAGE_ADDRESS_LSB);
 
     return page_address_field << PAGE_ADDRESS_LSB |
-           NOT_GLOBAL << GLOBAL_FLAG_OFFSET | PAT_DISABLED << PAT_FLAG_OFFSET |
+           std::underlying_type_t<Global>(flags.global) << GLOBAL_FLAG_OFFSET |
+           cache.page_attribute << PAT_FLAG_OFFSET |
            NOT_DIRTY << DIRTY_FLAG_OFFSET |
            WASNT_ACCESSED << ACCESSED_FLAG_OFFSET |
-           CACHE_DISABLED << CACHE_DISABLE_FLAG_OFFSET |
-           WRITE_THROUGH << CACHE_WRITE_MODE_FLAG_OFFSET |
+           cache.cache_disabled << CACHE_DISABLE_FLAG_OFFSET |
+           cache.write_through << CACHE_WRITE_MODE_FLAG_OFFSET |
            std::underlying_type_t<PriviledgeLevel>(flags.priviledge_level)
                << PRIVILEDGE_LEVEL_FLAG_OFFSET |
            std::underlying_type_t<AccessType>(flags.access_type)
@@ -59,10 +63,37 @@ void set_page_address(Entry* entry, const void* address) {
                                   address_in_pages);
 }
 
+cache_bits get_cache_bits(Entry entry) {
+    return {
+        .page_attribute = utilities::get_flag(entry, PAT_FLAG_OFFSET),
+        .cache_disabled =
+            utilities::get_flag(entry, CACHE_DISABLE_FLAG_OFFSET),
+        .write_through =
+            utilities::get_flag(entry, CACHE_WRITE_MODE_FLAG_OFFSET),
+    };
+}
+
+void set_cache_bits(Entry* entry, const cache_bits& bits) {
+    *entry = utilities::set_flag(*entry, PAT_FLAG_OFFSET, bits.page_attribute);
+    *entry = utilities::set_flag(*entry, CACHE_DISABLE_FLAG_OFFSET,
+                                 bits.cache_disabled);
+    *entry = utilities::set_flag(*entry, CACHE_WRITE_MODE_FLAG_OFFSET,
+                                 bits.write_through);
+}
+
+void set_global(Entry* entry, Global global) {
+    *entry = utilities::set_flag(*entry, GLOBAL_FLAG_OFFSET,
+                                 std::underlying_type_t<Global>(global));
+}
+
 bool is_dirty(Entry entry) {
     return utilities::get_flag(entry, DIRTY_FLAG_OFFSET);
 }
 
+void mark_dirty(Entry* entry) {
+    *entry = utilities::set_flag(*entry, DIRTY_FLAG_OFFSET);
+}
+
 bool was_accessed(Entry entry) {
     return utilities::get_flag(entry, ACCESSED_FLAG_OFFSET);
 }
@@ -95,6 +126,54 @@ void disable_writing(Entry* entry) {
     *entry = utilities::clear_flag(*entry, ACCESS_TYPE_FLAG_OFFSET);
 }
 
+bool is_copy_on_write(Entry entry) {
+    return utilities::get_flag(entry, COPY_ON_WRITE_FLAG_OFFSET);
+}
+
+void mark_copy_on_write(Entry* entry) {
+    if (is_copy_on_write(*entry)) {
+        return;
+    }
+
+    set_writeable_when_copied(entry, is_writeable(*entry));
+    disable_writing(entry);
+    *entry = utilities::set_flag(*entry, COPY_ON_WRITE_FLAG_OFFSET);
+}
+
+void clear_copy_on_write(Entry* entry) {
+    if (is_writeable_when_copied(*entry)) {
+        enable_writing(entry);
+    }
+
+    *entry = utilities::clear_flag(*entry, WRITEABLE_WHEN_COPIED_FLAG_OFFSET);
+    *entry = utilities::clear_flag(*entry, COPY_ON_WRITE_FLAG_OFFSET);
+}
+
+bool is_writeable_when_copied(Entry entry) {
+    return utilities::get_flag(entry, WRITEABLE_WHEN_COPIED_FLAG_OFFSET);
+}
+
+void set_writeable_when_copied(Entry* entry, bool writeable) {
+    *entry = utilities::set_flag(*entry, WRITEABLE_WHEN_COPIED_FLAG_OFFSET,
+                                 writeable);
+}
+
+Entry make_swapped_entry(size_t slot) {
+    // The slot takes the place of the page address. The entry is not
+    // present, so the processor ignores all of it.
+    return utilities::set_field(0, PAGE_ADDRESS_MSB, PAGE_ADDRESS_LSB, slot) |
+           1 << SWAPPED_FLAG_OFFSET;
+}
+
+bool is_swapped(Entry entry) {
+    return !is_present(entry) &&
+           utilities::get_flag(entry, SWAPPED_FLAG_OFFSET);
+}
+
+size_t get_swap_slot(Entry entry) {
+    return utilities::get_field(entry, PAGE_ADDRESS_MSB, PAGE_ADDRESS_LSB);
+}
+
 bool is_present(Entry entry) {
     return utilities::get_flag(entry, PRESENT_FLAG_OFFSET);
 }
@@ -17,12 +17,14 @@ load_page_directory:
 
 global enable_paging
 
-; Enable the paging mechanism. Set a flag in CR0 to do so.
+; Enable the paging mechanism. Set a flag in CR0 to do so. Also set CR0.WP, so
+; the kernel's writes to read only pages fault as well, which copy on write
+; relies on.
 enable_paging:
     push ebp
     mov ebp, esp
     mov eax, cr0
-    or eax, 80000000h
+    or eax, 80010000h
     mov cr0, eax
     pop ebp
     ret
@@ -37,3 +39,92 @@ disable_paging:
     mov cr0, eax
     pop ebp
     ret
+
+global invalidate_page
+
+; Drop the TLB entry of a page, so a changed mapping takes effect.
+;
+; @param ebp + 8 - The virtual address of the page.
+invalidate_page:
+    push ebp
+    mov ebp, esp
+    mov eax, [ebp + 8]
+    invlpg [eax]
+    pop ebp
+    ret
+
+global enable_large_pages
+
+; Enable page size extensions, so directory entries can map 4 MiB pages. Set a
+; flag in CR4 to do so.
+enable_large_pages:
+    push ebp
+    mov ebp, esp
+    mov eax, cr4
+    or eax, 10h
+    mov cr4, eax
+    pop ebp
+    ret
+
+global load_page_attribute_table
+
+; Set the page attribute table, which maps the cache bits of paging entries to
+; memory types. Written to the IA32_PAT model specific register.
+;
+; @param ebp + 8 - The low half of the table, entries 0 to 3.
+; @param ebp + 12 - The high half of the table, entries 4 to 7.
+load_page_attribute_table:
+    push ebp
+    mov ebp, esp
+    mov ecx, 277h
+    mov eax, [ebp + 8]
+    mov edx, [ebp + 12]
+    wrmsr
+    pop ebp
+    ret
+
+global flush_tlb
+
+; Drop all TLB entries. Reloading CR3 keeps the entries of global pages, so
+; while global pages are enabled they are dropped by toggling CR4.PGE instead.
+flush_tlb:
+    push ebp
+    mov ebp, esp
+    mov eax, cr4
+    test eax, 80h
+    jz .reload
+    and eax, ~80h
+    mov cr4, eax
+    or eax, 80h
+    mov cr4, eax
+    pop ebp
+    ret
+.reload:
+    mov eax, cr3
+    mov cr3, eax
+    pop ebp
+    ret
+
+global enable_global_pages
+
+; Enable global pages, whose TLB entries survive reloading CR3. Set a flag in
+; CR4 to do so.
+enable_global_pages:
+    push ebp
+    mov ebp, esp
+    mov eax, cr4
+    or eax, 80h
+    mov cr4, eax
+    pop ebp
+    ret
+
+global read_page_fault_address
+
+; Get the address whose access caused the last page fault, which the processor
+; keeps in CR2.
+read_page_fault_address:
+    push ebp
+    mov ebp, esp
+    mov eax, cr2
+    pop ebp
+    ret
@@ -3,96 +3,223 @@
 #include <stddef.h>
 
 #include <cstddef>
+#include <cstring>
 #include <utility>
 
+#include "memory/layout.hpp"
+#include "memory/paging/faults.hpp"
+#include "memory/paging/regions.hpp"
+#include "memory/paging/swap.hpp"
+#include "memory/physical/references.hpp"
 #include "utilities/bitranges.hpp"
+#include "utilities/processor.hpp"
 
 extern "C" void enable_paging();
 extern "C" void disable_paging();
 extern "C" void load_page_directory(const void* page_directory);
+extern "C" void invalidate_page(const void* virtual_address);
+extern "C" void enable_large_pages();
+extern "C" void flush_tlb();
+extern "C" void enable_global_pages();
 
 namespace memory::paging {
 
+// Above this amount of pages, reloading the whole TLB is cheaper than
+// invalidating the pages one by one.
+constexpr size_t INVALIDATION_THRESHOLD = 32;
+
+// The last directory entry points back at the directory, so the directory is
+// its own page table for the last 4 MiB of the address space. The table of
+// every directory entry shows up there as a page, and the directory itself is
+// the last of them.
+constexpr size_t SELF_MAP_OFFSET = directory::ENTRY_NUM - 1;
+constexpr size_t SELF_MAP_TABLES = SELF_MAP_OFFSET * LARGE_PAGE_SIZE_IN_BYTES;
+constexpr size_t SELF_MAP_DIRECTORY =
+    SELF_MAP_TABLES + SELF_MAP_OFFSET * PAGE_SIZE_IN_BYTES;
+
 size_t get_directory_offset(const void* virtual_address);
 size_t get_table_offset(const void* virtual_address);
+static error set_entry(paging* paging, const void* virtual_address,
+                       const void* physical_address, const flags& flags);
+static with_error<table::Entry*> get_mapped_entry(
+    paging* paging, const void* virtual_address);
+static void set_flags(directory::Entry* pde, table::Entry* pte,
+                      const flags& flags);
+static error release_if_empty(paging* paging, size_t directory_offset);
+[[nodiscard]] static bool is_self_mapped(const paging* paging);
+[[nodiscard]] static directory::Entry* get_directory(const paging* paging);
+[[nodiscard]] static table::Entry* get_table(const paging* paging,
+                                             size_t directory_offset);
+static void set_table(paging* paging, size_t directory_offset,
+                      directory::Entry entry);
+[[nodiscard]] static directory::Entry make_self_entry(const paging* paging);
+[[nodiscard]] static size_t divide_round_up(size_t a, size_t b);
+static error copy_tables(const paging* parent, paging* child);
+static error copy_regions(const paging* parent, paging* child);
+static error share_region_pages(paging* parent, paging* child);
+static error share_page(paging* parent, paging* child, const std::byte* page);
+static void forget_unshared_pages(paging* child,
+                                  const regions::region* region,
+                                  size_t offset);
+static error remove_regions(paging* paging, regions::region_tree* tree);
+static error free_region_tree(paging* paging, regions::region_tree* tree);
+static error allocate_directory(paging* paging);
+[[nodiscard]] static with_error<regions::region_tree*> allocate_region_tree(
+    paging* paging);
+static error add_heaps(paging* paging);
+static error add_table(paging* paging, size_t directory_offset);
+static error split_large_page(paging* paging, size_t directory_offset);
+[[nodiscard]] static bool is_table_empty(const table::Entry* table);
+[[nodiscard]] static bool is_heap_directory_offset(size_t directory_offset);
+[[nodiscard]] static bool is_private_directory_offset(
+    size_t directory_offset);
+
+// The instance the processor currently uses. Its directory is nullptr while
+// none is loaded.
+static paging loaded{};
+// Whether paging is enabled in the processor. Until then, the self map of the
+// loaded instance can't be used.
+static bool enabled = false;
 
 with_error<paging> make(allocator* allocator,
                         const directory::Flags& directory_flags,
-                        const table::Flags& table_flags) {
+                        const table::Flags& table_flags, bool large_pages) {
     paging paging{.allocator_ = allocator};
 
-    auto [directory_allocation, directory_error] =
-        try_malloc(allocator, directory::ENTRY_NUM * sizeof(directory::Entry));
-    if (errors::set(directory_error)) {
-        errors::enrich(&directory_error, "allocate page directory");
-        return {paging, directory_error};
+    error allocation_error = allocate_directory(&paging);
+    if (errors::set(allocation_error)) {
+        return {paging, allocation_error};
     }
 
-    directory::Entry* const directory =
-        reinterpret_cast<directory::Entry*>(directory_allocation);
-    paging.directory = directory;
-
-    auto [tables_allocation, tables_error] =
-        try_malloc(allocator, directory::ENTRY_NUM * sizeof(table::Entry*));
-    if (errors::set(tables_error)) {
-        errors::enrich(&tables_error, "allocate page tables");
-        return {paging, tables_error};
+    allocation_error = add_heaps(&paging);
+    if (errors::set(allocation_error)) {
+        return {paging, allocation_error};
     }
 
-    table::Entry** const tables =
-        reinterpret_cast<table::Entry**>(tables_allocation);
-    paging.tables = tables;
+    directory::Entry* const directory = paging.directory;
 
     const std::byte* address = 0;
 
-    for (size_t directory_index = 0; directory_index < directory::ENTRY_NUM;
+    // Large pages are mapped directly by the directory, with the flags of
+    // pages.
+    const directory::Flags large_page_flags{
+        .priviledge_level = table_flags.priviledge_level,
+        .access_type = table_flags.access_type,
+        .present = table_flags.present,
+        .cache_policy = table_flags.cache_policy,
+        .global = table_flags.global,
+    };
+
+    // The last 4 MiB hold the self map, so they aren't identity mapped.
+    for (size_t directory_index = 0; directory_index < SELF_MAP_OFFSET;
          directory_index++) {
-        auto [table, table_error] =
-            try_malloc(allocator, table::ENTRY_NUM * sizeof(table::Entry));
+        // The heaps and private memory map their pages as they are used, so
+        // the pages they didn't map, such as guard pages, fault.
+        if (is_heap_directory_offset(directory_index) ||
+            is_private_directory_offset(directory_index)) {
+            address += LARGE_PAGE_SIZE_IN_BYTES;
+            continue;
+        }
+
+        if (large_pages) {
+            directory[directory_index] =
+                directory::make_large_entry(address, large_page_flags);
+
+            address += LARGE_PAGE_SIZE_IN_BYTES;
+            continue;
+        }
+
+        auto [table, table_error] = try_aligned_malloc(
+            allocator, table::ENTRY_NUM * sizeof(table::Entry),
+            PAGE_SIZE_IN_BYTES);
         if (errors::set(table_error)) {
             errors::enrich(&table_error, "allocate page table");
             return {paging, table_error};
         }
 
-        tables[directory_index] = reinterpret_cast<table::Entry*>(table);
+        table::Entry* const entries = reinterpret_cast<table::Entry*>(table);
 
         for (size_t table_index = 0; table_index < table::ENTRY_NUM;
              table_index++) {
-            tables[directory_index][table_index] =
-                table::make_entry(address, table_flags);
+            entries[table_index] = table::make_entry(address, table_flags);
 
             address += PAGE_SIZE_IN_BYTES;
         }
 
         directory[directory_index] =
-            directory::make_entry(tables[directory_index], directory_flags);
+            directory::make_entry(entries, directory_flags);
+    }
+
+    return {paging, errors::nil()};
+}
+
+with_error<paging> make_empty(allocator* allocator) {
+    paging paging{.allocator_ = allocator};
+
+    error allocation_error = allocate_directory(&paging);
+    if (errors::set(allocation_error)) {
+        return {paging, allocation_error};
+    }
+
+    allocation_error = add_heaps(&paging);
+    if (errors::set(allocation_error)) {
+        return {paging, allocation_error};
     }
 
     return {paging, errors::nil()};
 }
 
 error destroy(paging* paging) {
-    error first = errors::nil();
+    // Pages are released like when their regions are removed, so frames and
+    // swap slots that are shared with other instances stay allocated.
+    error first = remove_regions(paging, paging->regions);
+    if (!paging->is_clone) {
+        const error temp = remove_regions(paging, paging->kernel_regions);
+        if (errors::set(temp) && !errors::set(first)) {
+            first = temp;
+        }
+    }
 
-    if (paging->tables != nullptr) {
-        for (size_t i = 0; i < directory::ENTRY_NUM; i++) {
-            if (paging->tables[i] != nullptr) {
-                const error temp =
-                    try_free(paging->allocator_, paging->tables[i]);
-                if (errors::set(temp) && !errors::set(first)) {
-                    first = temp;
-                }
+    if (paging->directory != nullptr) {
+        // Tables are freed by the address the allocator gave, which is the
+        // one in the directory, not the one in the self map. The tables of
+        // the heaps belong to the instance a clone was cloned from.
+        for (size_t i = 0; i < SELF_MAP_OFFSET; i++) {
+            const directory::Entry pde = get_directory(paging)[i];
+            if (!directory::is_present(pde) || directory::is_large(pde) ||
+                (paging->is_clone && is_heap_directory_offset(i))) {
+                continue;
+            }
+
+            const error temp =
+                try_free(paging->allocator_, directory::get_pte_address(pde),
+                         table::ENTRY_NUM * sizeof(table::Entry));
+            if (errors::set(temp) && !errors::set(first)) {
+                first = temp;
             }
         }
+    }
+
+    if (paging->directory != nullptr && paging->directory == loaded.directory) {
+        loaded = {};
+    }
 
-        const error temp = try_free(paging->allocator_, paging->tables);
+    error temp = free_region_tree(paging, paging->regions);
+    if (errors::set(temp) && !errors::set(first)) {
+        first = temp;
+    }
+
+    if (!paging->is_clone) {
+        temp = free_region_tree(paging, paging->kernel_regions);
         if (errors::set(temp) && !errors::set(first)) {
             first = temp;
         }
     }
 
     if (paging->directory != nullptr) {
-        const error temp = try_free(paging->allocator_, paging->directory);
+        const error temp =
+            try_free(paging->allocator_, paging->directory,
+                     directory::ENTRY_NUM * sizeof(directory::Entry));
         if (errors::set(temp) && !errors::set(first)) {
             first = temp;
         }
@@ -101,24 +228,319 @@ error destroy(paging* paging) {
     return first;
 }
 
+with_error<paging> clone(paging* parent) {
+    if (!physical::has_references()) {
+        return {{}, errors::make(WITH_LOCATION("frames can't be shared"))};
+    }
+
+    paging child{
+        .allocator_ = parent->allocator_,
+        .kernel_regions = parent->kernel_regions,
+        .is_clone = true,
+    };
+    error allocation_error = allocate_directory(&child);
+    if (errors::set(allocation_error)) {
+        return {child, allocation_error};
+    }
+
+    // Everything that is allocated is copied before any frame is shared.
+    // Until the pages are shared, the child holds no references to them, so
+    // it must not release them when it is destroyed.
+    error copy_error = copy_tables(parent, &child);
+    if (errors::set(copy_error)) {
+        errors::enrich(&copy_error, "copy page tables");
+        return {child, copy_error};
+    }
+
+    copy_error = copy_regions(parent, &child);
+    if (errors::set(copy_error)) {
+        errors::log(regions::destroy(child.regions));
+        errors::enrich(&copy_error, "copy regions");
+        return {child, copy_error};
+    }
+
+    // If sharing fails, destroying the child only releases the pages that
+    // were shared. They stay copy on write in the parent, which keeps their
+    // frames when it next writes to them.
+    error share_error = share_region_pages(parent, &child);
+
+    // Writeable pages of the parent became read only.
+    if (parent->directory == loaded.directory) {
+        flush_tlb();
+    }
+
+    if (errors::set(share_error)) {
+        errors::enrich(&share_error, "share region pages");
+        return {child, share_error};
+    }
+
+    return {child, errors::nil()};
+}
+
+error copy_on_write(paging* paging, const void* virtual_address,
+                    allocator* frames) {
+    auto [pte, entry_error] = get_mapped_entry(paging, virtual_address);
+    if (errors::set(entry_error)) {
+        return entry_error;
+    }
+
+    if (!table::is_copy_on_write(*pte)) {
+        return errors::make(WITH_LOCATION("page is not copy on write"));
+    }
+
+    if (!table::is_writeable_when_copied(*pte)) {
+        return errors::make(WITH_LOCATION("page is read only"));
+    }
+
+    // The last address space to write to a shared frame keeps it.
+    const void* const frame = table::get_page_address(*pte);
+    if (physical::get_references(frame) > 1) {
+        auto [copy, copy_error] =
+            try_aligned_malloc(frames, PAGE_SIZE_IN_BYTES, PAGE_SIZE_IN_BYTES);
+        if (errors::set(copy_error)) {
+            errors::enrich(&copy_error, "allocate copy");
+            return copy_error;
+        }
+
+        // Frames are identity mapped, so both can be accessed directly.
+        std::memcpy(copy, frame, PAGE_SIZE_IN_BYTES);
+        table::set_page_address(pte, copy);
+
+        if (physical::release_frame(frame)) {
+            ::memory::allocation::free(frames, frame, PAGE_SIZE_IN_BYTES);
+        }
+    }
+
+    table::clear_copy_on_write(pte);
+
+    invalidate(paging, virtual_address, 1);
+
+    return errors::nil();
+}
+
 error map(paging* paging, const void* virtual_address,
           const void* physical_address, const flags& flags) {
+    error map_error =
+        set_entry(paging, virtual_address, physical_address, flags);
+    if (errors::set(map_error)) {
+        return map_error;
+    }
+
+    invalidate(paging, virtual_address, 1);
+
+    return errors::nil();
+}
+
+error map_range(paging* paging, const void* virtual_address,
+                const void* physical_address, size_t bytes,
+                const flags& flags) {
+    if (reinterpret_cast<uint32_t>(physical_address) % PAGE_SIZE_IN_BYTES !=
+        0) {
+        return errors::make(
+            WITH_LOCATION("physical address is not a multiple of page size"));
+    }
+
+    const std::byte* const virtual_start =
+        static_cast<const std::byte*>(virtual_address);
+    const std::byte* const physical_start =
+        static_cast<const std::byte*>(physical_address);
+    const size_t pages = divide_round_up(bytes, PAGE_SIZE_IN_BYTES);
+
+    error map_error = errors::nil();
+    size_t page = 0;
+    for (; page < pages; page++) {
+        map_error = set_entry(paging, virtual_start + page * PAGE_SIZE_IN_BYTES,
+                              physical_start + page * PAGE_SIZE_IN_BYTES,
+                              flags);
+        if (errors::set(map_error)) {
+            errors::enrich(&map_error, "map page in range");
+            break;
+        }
+    }
+
+    // Pages that were mapped before an error stay mapped.
+    invalidate(paging, virtual_address, page);
+
+    return map_error;
+}
+
+with_error<const void*> unmap(paging* paging, const void* virtual_address) {
+    auto [pte, entry_error] = get_mapped_entry(paging, virtual_address);
+    if (errors::set(entry_error)) {
+        return {nullptr, entry_error};
+    }
+
+    const void* const physical_address = table::get_page_address(*pte);
+    table::mark_not_present(pte);
+
+    error release_error =
+        release_if_empty(paging, get_directory_offset(virtual_address));
+
+    invalidate(paging, virtual_address, 1);
+
+    if (errors::set(release_error)) {
+        return {nullptr, release_error};
+    }
+
+    return {physical_address, errors::nil()};
+}
+
+error unmap_range(paging* paging, const void* virtual_address, size_t bytes) {
+    const std::byte* const start =
+        static_cast<const std::byte*>(virtual_address);
+    const size_t pages = divide_round_up(bytes, PAGE_SIZE_IN_BYTES);
+
+    error unmap_error = errors::nil();
+    size_t page = 0;
+    for (; page < pages; page++) {
+        auto [pte, entry_error] =
+            get_mapped_entry(paging, start + page * PAGE_SIZE_IN_BYTES);
+        if (errors::set(entry_error)) {
+            unmap_error = entry_error;
+            errors::enrich(&unmap_error, "unmap page in range");
+            break;
+        }
+
+        table::mark_not_present(pte);
+    }
+
+    // Each table is checked once, after all of its pages are unmapped.
+    if (page > 0) {
+        const size_t first = get_directory_offset(start);
+        const size_t last =
+            get_directory_offset(start + (page - 1) * PAGE_SIZE_IN_BYTES);
+        for (size_t directory_offset = first; directory_offset <= last;
+             directory_offset++) {
+            const error release_error =
+                release_if_empty(paging, directory_offset);
+            if (errors::set(release_error) && !errors::set(unmap_error)) {
+                unmap_error = release_error;
+            }
+        }
+    }
+
+    invalidate(paging, virtual_address, page);
+
+    return unmap_error;
+}
+
+error protect(paging* paging, const void* virtual_address, size_t bytes,
+              const flags& flags) {
+    const std::byte* const start =
+        static_cast<const std::byte*>(virtual_address);
+    const size_t pages = divide_round_up(bytes, PAGE_SIZE_IN_BYTES);
+
+    error protect_error = errors::nil();
+    size_t page = 0;
+    for (; page < pages; page++) {
+        const std::byte* const address = start + page * PAGE_SIZE_IN_BYTES;
+
+        auto [pte, entry_error] = get_mapped_entry(paging, address);
+        if (errors::set(entry_error)) {
+            protect_error = entry_error;
+            errors::enrich(&protect_error, "protect page in range");
+            break;
+        }
+
+        set_flags(&get_directory(paging)[get_directory_offset(address)], pte,
+                  flags);
+
+        // Shared pages stay read only and local until they are copied, and
+        // only then get the new rights.
+        if (table::is_copy_on_write(*pte)) {
+            const bool writeable = table::is_writeable(*pte);
+            table::disable_writing(pte);
+            table::set_writeable_when_copied(pte, writeable);
+            table::set_global(pte, Global::FALSE);
+        }
+    }
+
+    invalidate(paging, virtual_address, page);
+
+    return protect_error;
+}
+
+error set_entry(paging* paging, const void* virtual_address,
+                const void* physical_address, const flags& flags) {
     if (reinterpret_cast<uint32_t>(virtual_address) % PAGE_SIZE_IN_BYTES != 0) {
         return errors::make(
             WITH_LOCATION("virtual address is not a multiple of page size"));
     }
 
     const size_t directory_offset = get_directory_offset(virtual_address);
-    directory::Entry* const pde = &paging->directory[directory_offset];
+    if (directory_offset == SELF_MAP_OFFSET) {
+        return errors::make(WITH_LOCATION("address is in the self map"));
+    }
+
+    directory::Entry* const pde = &get_directory(paging)[directory_offset];
     if (!directory::is_present(*pde)) {
-        return errors::make(WITH_LOCATION("non-present page table"));
+        error table_error = add_table(paging, directory_offset);
+        if (errors::set(table_error)) {
+            errors::enrich(&table_error, "add page table");
+            return table_error;
+        }
+    } else if (directory::is_large(*pde)) {
+        error split_error = split_large_page(paging, directory_offset);
+        if (errors::set(split_error)) {
+            errors::enrich(&split_error, "split large page");
+            return split_error;
+        }
     }
 
     const size_t table_offset = get_table_offset(virtual_address);
-    table::Entry* const pte = &paging->tables[directory_offset][table_offset];
+    table::Entry* const pte =
+        &get_table(paging, directory_offset)[table_offset];
 
+    // The entry may be left over from an earlier mapping, with bits that
+    // don't apply to the new one.
+    *pte = 0;
     table::set_page_address(pte, physical_address);
+    set_flags(pde, pte, flags);
+    table::mark_present(pte);
+
+    return errors::nil();
+}
+
+with_error<table::Entry*> get_mapped_entry(paging* paging,
+                                           const void* virtual_address) {
+    if (reinterpret_cast<uint32_t>(virtual_address) % PAGE_SIZE_IN_BYTES != 0) {
+        return {nullptr,
+                errors::make(WITH_LOCATION(
+                    "virtual address is not a multiple of page size"))};
+    }
 
+    const size_t directory_offset = get_directory_offset(virtual_address);
+    if (directory_offset == SELF_MAP_OFFSET) {
+        return {nullptr,
+                errors::make(WITH_LOCATION("address is in the self map"))};
+    }
+
+    const directory::Entry pde = get_directory(paging)[directory_offset];
+    if (!directory::is_present(pde)) {
+        return {nullptr,
+                errors::make(WITH_LOCATION("non-present page table"))};
+    }
+
+    if (directory::is_large(pde)) {
+        error split_error = split_large_page(paging, directory_offset);
+        if (errors::set(split_error)) {
+            errors::enrich(&split_error, "split large page");
+            return {nullptr, split_error};
+        }
+    }
+
+    table::Entry* const pte =
+        &get_table(paging, directory_offset)[get_table_offset(virtual_address)];
+    if (!table::is_present(*pte)) {
+        return {nullptr, errors::make(WITH_LOCATION("page is not mapped"))};
+    }
+
+    return {pte, errors::nil()};
+}
+
+void set_flags(directory::Entry* pde, table::Entry* pte, const flags& flags) {
+    // The directory entry grants the union of the rights of its pages, so it
+    // is only ever extended.
     if (flags.access_type == AccessType::READ_WRITE) {
         table::enable_writing(pte);
         directory::enable_writing(pde);
@@ -133,11 +555,425 @@ error map(paging* paging, const void* virtual_address,
         table::disable_user_access(pte);
     }
 
-    table::mark_present(pte);
+    table::set_cache_bits(pte, get_cache_bits(flags.cache_policy));
+    table::set_global(pte, flags.global);
+}
+
+error release_if_empty(paging* paging, size_t directory_offset) {
+    // Tables that no longer map anything are released, so address spaces
+    // only pay for the tables they use. The tables of the heaps are kept,
+    // since clones point at them.
+    const directory::Entry pde = get_directory(paging)[directory_offset];
+    if (!directory::is_present(pde) || directory::is_large(pde) ||
+        is_heap_directory_offset(directory_offset) ||
+        !is_table_empty(get_table(paging, directory_offset))) {
+        return errors::nil();
+    }
+
+    set_table(paging, directory_offset, 0);
+
+    error free_error =
+        try_free(paging->allocator_, directory::get_pte_address(pde),
+                 table::ENTRY_NUM * sizeof(table::Entry));
+    if (errors::set(free_error)) {
+        errors::enrich(&free_error, "free page table");
+    }
+
+    return free_error;
+}
+
+void invalidate(const paging* paging, const void* virtual_address,
+                size_t pages) {
+    // Only translations of the loaded instance can be cached.
+    if (paging->directory != loaded.directory) {
+        return;
+    }
+
+    if (pages > INVALIDATION_THRESHOLD) {
+        flush_tlb();
+        return;
+    }
+
+    const std::byte* const start =
+        static_cast<const std::byte*>(virtual_address);
+    for (size_t page = 0; page < pages; page++) {
+        invalidate_page(start + page * PAGE_SIZE_IN_BYTES);
+    }
+}
+
+error copy_tables(const paging* parent, paging* child) {
+    const directory::Entry* const parent_directory = get_directory(parent);
+    directory::Entry* const child_directory = get_directory(child);
+
+    for (size_t directory_offset = 0; directory_offset < SELF_MAP_OFFSET;
+         directory_offset++) {
+        // The tables of the heaps are shared rather than copied, so the
+        // heaps grow and shrink in both instances at once.
+        const directory::Entry pde = parent_directory[directory_offset];
+        if (!directory::is_present(pde) || directory::is_large(pde) ||
+            is_heap_directory_offset(directory_offset)) {
+            child_directory[directory_offset] = pde;
+            continue;
+        }
+
+        auto [allocation, allocation_error] = try_aligned_malloc(
+            child->allocator_, table::ENTRY_NUM * sizeof(table::Entry),
+            PAGE_SIZE_IN_BYTES);
+        if (errors::set(allocation_error)) {
+            errors::enrich(&allocation_error, "allocate page table");
+            return allocation_error;
+        }
+
+        table::Entry* const table = reinterpret_cast<table::Entry*>(allocation);
+        std::memcpy(table, get_table(parent, directory_offset),
+                    table::ENTRY_NUM * sizeof(table::Entry));
+
+        directory::Entry copy = pde;
+        directory::set_pte_address(&copy, table);
+        child_directory[directory_offset] = copy;
+    }
+
+    return errors::nil();
+}
+
+error copy_regions(const paging* parent, paging* child) {
+    for (const regions::region* region = regions::first(parent->regions);
+         region != nullptr; region = regions::next(region)) {
+        auto [copy, insert_error] = regions::insert(child->regions, *region);
+        if (errors::set(insert_error)) {
+            return insert_error;
+        }
+    }
 
     return errors::nil();
 }
 
+error share_region_pages(paging* parent, paging* child) {
+    for (const regions::region* region = regions::first(parent->regions);
+         region != nullptr; region = regions::next(region)) {
+        if (!regions::owns_frames(region)) {
+            continue;
+        }
+
+        for (size_t offset = 0; offset < region->bytes;
+             offset += PAGE_SIZE_IN_BYTES) {
+            error share_error =
+                share_page(parent, child, region->start + offset);
+            if (errors::set(share_error)) {
+                forget_unshared_pages(child, region, offset);
+                return share_error;
+            }
+        }
+    }
+
+    return errors::nil();
+}
+
+error share_page(paging* parent, paging* child, const std::byte* page) {
+    // Both instances have the entry of a swapped page, so both refer to its
+    // slot.
+    const table::Entry* const entry = get_entry(parent, page);
+    if (entry != nullptr && table::is_swapped(*entry)) {
+        return swap::share_slot(table::get_swap_slot(*entry));
+    }
+
+    if (!is_mapped(parent, page)) {
+        return errors::nil();
+    }
+
+    auto [parent_pte, parent_error] = get_mapped_entry(parent, page);
+    if (errors::set(parent_error)) {
+        return parent_error;
+    }
+
+    auto [child_pte, child_error] = get_mapped_entry(child, page);
+    if (errors::set(child_error)) {
+        return child_error;
+    }
+
+    error share_error =
+        physical::share_frame(table::get_page_address(*parent_pte));
+    if (errors::set(share_error)) {
+        return share_error;
+    }
+
+    // Read only pages are copy on write as well, so making them writeable
+    // later can't let both instances write to the same frame. The entries
+    // are local, since the instances map different frames once either of
+    // them writes.
+    table::mark_copy_on_write(parent_pte);
+    table::set_global(parent_pte, Global::FALSE);
+    table::mark_copy_on_write(child_pte);
+    table::set_global(child_pte, Global::FALSE);
+
+    return errors::nil();
+}
+
+void forget_unshared_pages(paging* child, const regions::region* region,
+                           size_t offset) {
+    // The child's copies of these entries hold no references, so destroying
+    // it would release the parent's frames and swap slots.
+    for (; region != nullptr; region = regions::next(region), offset = 0) {
+        if (!regions::owns_frames(region)) {
+            continue;
+        }
+
+        for (; offset < region->bytes; offset += PAGE_SIZE_IN_BYTES) {
+            table::Entry* const entry =
+                get_entry(child, region->start + offset);
+            if (entry != nullptr) {
+                *entry = 0;
+            }
+        }
+    }
+}
+
+bool is_self_mapped(const paging* paging) {
+    return enabled && paging->directory == loaded.directory;
+}
+
+directory::Entry* get_directory(const paging* paging) {
+    if (is_self_mapped(paging)) {
+        return reinterpret_cast<directory::Entry*>(SELF_MAP_DIRECTORY);
+    }
+
+    return paging->directory;
+}
+
+table::Entry* get_table(const paging* paging, size_t directory_offset) {
+    if (is_self_mapped(paging)) {
+        return reinterpret_cast<table::Entry*>(
+            SELF_MAP_TABLES + directory_offset * PAGE_SIZE_IN_BYTES);
+    }
+
+    // Without the self map, tables are reached through the identity map.
+    return directory::get_pte_address(paging->directory[directory_offset]);
+}
+
+void set_table(paging* paging, size_t directory_offset,
+               directory::Entry entry) {
+    get_directory(paging)[directory_offset] = entry;
+
+    // The self map may still translate the table's page to the previous
+    // table.
+    if (is_self_mapped(paging)) {
+        invalidate_page(get_table(paging, directory_offset));
+    }
+}
+
+directory::Entry make_self_entry(const paging* paging) {
+    return directory::make_entry(
+        reinterpret_cast<const table::Entry*>(paging->directory),
+        {PriviledgeLevel::KERNEL, AccessType::READ_WRITE, Present::TRUE});
+}
+
+error remove_regions(paging* paging, regions::region_tree* tree) {
+    if (tree == nullptr) {
+        return errors::nil();
+    }
+
+    error first = errors::nil();
+
+    for (const regions::region* region = regions::first(tree);
+         region != nullptr; region = regions::first(tree)) {
+        const error temp = remove_region(paging, region->start);
+        if (errors::set(temp) && !errors::set(first)) {
+            first = temp;
+        }
+    }
+
+    return first;
+}
+
+error free_region_tree(paging* paging, regions::region_tree* tree) {
+    if (tree == nullptr) {
+        return errors::nil();
+    }
+
+    error first = regions::destroy(tree);
+
+    const error temp =
+        try_free(paging->allocator_, tree, sizeof(regions::region_tree));
+    if (errors::set(temp) && !errors::set(first)) {
+        first = temp;
+    }
+
+    return first;
+}
+
+error allocate_directory(paging* paging) {
+    auto [directory_allocation, directory_error] = try_aligned_malloc(
+        paging->allocator_, directory::ENTRY_NUM * sizeof(directory::Entry),
+        PAGE_SIZE_IN_BYTES);
+    if (errors::set(directory_error)) {
+        errors::enrich(&directory_error, "allocate page directory");
+        return directory_error;
+    }
+
+    paging->directory =
+        reinterpret_cast<directory::Entry*>(directory_allocation);
+
+    // Zeroed entries are not present, so destroy() only frees the tables
+    // that were allocated, even if making the instance failed halfway.
+    std::memset(paging->directory, 0,
+                directory::ENTRY_NUM * sizeof(directory::Entry));
+    paging->directory[SELF_MAP_OFFSET] = make_self_entry(paging);
+
+    auto [tree, tree_error] = allocate_region_tree(paging);
+    if (errors::set(tree_error)) {
+        return tree_error;
+    }
+
+    paging->regions = tree;
+
+    return errors::nil();
+}
+
+with_error<regions::region_tree*> allocate_region_tree(paging* paging) {
+    auto [allocation, allocation_error] =
+        try_malloc(paging->allocator_, sizeof(regions::region_tree));
+    if (errors::set(allocation_error)) {
+        errors::enrich(&allocation_error, "allocate region tree");
+        return {nullptr, allocation_error};
+    }
+
+    regions::region_tree* const tree =
+        reinterpret_cast<regions::region_tree*>(allocation);
+    *tree = regions::make_region_tree(paging->allocator_);
+
+    return {tree, errors::nil()};
+}
+
+error add_heaps(paging* paging) {
+    auto [tree, tree_error] = allocate_region_tree(paging);
+    if (errors::set(tree_error)) {
+        return tree_error;
+    }
+
+    paging->kernel_regions = tree;
+
+    // Clones point at the same regions and tables. Their directory entries
+    // allow writing up front, since map() only extends the entry of the
+    // instance it is given.
+    for (size_t directory_offset = 0; directory_offset < SELF_MAP_OFFSET;
+         directory_offset++) {
+        if (!is_heap_directory_offset(directory_offset)) {
+            continue;
+        }
+
+        error table_error = add_table(paging, directory_offset);
+        if (errors::set(table_error)) {
+            errors::enrich(&table_error, "add heap table");
+            return table_error;
+        }
+
+        directory::enable_writing(&get_directory(paging)[directory_offset]);
+    }
+
+    return errors::nil();
+}
+
+error add_table(paging* paging, size_t directory_offset) {
+    auto [allocation, allocation_error] = try_aligned_malloc(
+        paging->allocator_, table::ENTRY_NUM * sizeof(table::Entry),
+        PAGE_SIZE_IN_BYTES);
+    if (errors::set(allocation_error)) {
+        errors::enrich(&allocation_error, "allocate page table");
+        return allocation_error;
+    }
+
+    table::Entry* const table = reinterpret_cast<table::Entry*>(allocation);
+    std::memset(table, 0, table::ENTRY_NUM * sizeof(table::Entry));
+
+    // The entry starts with the least rights. map() extends them to those of
+    // the pages it maps.
+    set_table(paging, directory_offset,
+              directory::make_entry(table, {PriviledgeLevel::KERNEL,
+                                            AccessType::READ_ONLY,
+                                            Present::TRUE}));
+
+    return errors::nil();
+}
+
+error split_large_page(paging* paging, size_t directory_offset) {
+    const directory::Entry* const pde =
+        &get_directory(paging)[directory_offset];
+
+    auto [allocation, allocation_error] = try_aligned_malloc(
+        paging->allocator_, table::ENTRY_NUM * sizeof(table::Entry),
+        PAGE_SIZE_IN_BYTES);
+    if (errors::set(allocation_error)) {
+        errors::enrich(&allocation_error, "allocate page table");
+        return allocation_error;
+    }
+
+    table::Entry* const table = reinterpret_cast<table::Entry*>(allocation);
+
+    // The table maps the same memory as the large page, with the same access
+    // rights, cache policy and scope, so the split is invisible until an
+    // entry is changed.
+    const PriviledgeLevel priviledge_level =
+        static_cast<PriviledgeLevel>(directory::can_user_access(*pde));
+    const AccessType access_type =
+        static_cast<AccessType>(directory::is_writeable(*pde));
+    const cache_bits cache = directory::get_large_cache_bits(*pde);
+    const Global global = directory::get_large_global(*pde);
+    const std::byte* address = static_cast<const std::byte*>(
+        directory::get_large_page_address(*pde));
+
+    for (size_t table_index = 0; table_index < table::ENTRY_NUM;
+         table_index++) {
+        table[table_index] = table::make_entry(
+            address, {priviledge_level, access_type, Present::TRUE});
+        table::set_cache_bits(&table[table_index], cache);
+        table::set_global(&table[table_index], global);
+
+        address += PAGE_SIZE_IN_BYTES;
+    }
+
+    set_table(paging, directory_offset,
+              directory::make_entry(
+                  table, {priviledge_level, access_type, Present::TRUE}));
+
+    // Invalidating any address in the large page drops its TLB entry.
+    invalidate_page(reinterpret_cast<const void*>(directory_offset *
+                                                  LARGE_PAGE_SIZE_IN_BYTES));
+
+    return errors::nil();
+}
+
+bool is_table_empty(const table::Entry* table) {
+    for (size_t table_index = 0; table_index < table::ENTRY_NUM;
+         table_index++) {
+        // Swapped entries are kept, since they are the only record of
+        // where their pages are.
+        if (table::is_present(table[table_index]) ||
+            table::is_swapped(table[table_index])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool is_heap_directory_offset(size_t directory_offset) {
+    const size_t address = directory_offset * LARGE_PAGE_SIZE_IN_BYTES;
+
+    return address >= static_cast<size_t>(Layout::KERNEL_HEAP) &&
+           address < static_cast<size_t>(Layout::VIRTUAL_HEAP_END);
+}
+
+bool is_private_directory_offset(size_t directory_offset) {
+    const size_t address = directory_offset * LARGE_PAGE_SIZE_IN_BYTES;
+
+    return address >= static_cast<size_t>(Layout::PRIVATE) &&
+           address < static_cast<size_t>(Layout::PRIVATE_END);
+}
+
+size_t divide_round_up(size_t a, size_t b) {
+    return (a + b - 1) / b;
+}
+
 size_t get_directory_offset(const void* virtual_address) {
     return reinterpret_cast<size_t>(virtual_address) >>
            (PAGE_TABLE_BITS + PAGE_SIZE_BITS);
@@ -148,16 +984,113 @@ size_t get_table_offset(const void* virtual_address) {
            ((1 << PAGE_TABLE_BITS) - 1);
 }
 
+table::Entry* get_entry(paging* paging, const void* virtual_address) {
+    const size_t directory_offset = get_directory_offset(virtual_address);
+    if (directory_offset == SELF_MAP_OFFSET) {
+        return nullptr;
+    }
+
+    const directory::Entry pde = get_directory(paging)[directory_offset];
+    if (!directory::is_present(pde) || directory::is_large(pde)) {
+        return nullptr;
+    }
+
+    return &get_table(paging, directory_offset)[get_table_offset(
+        virtual_address)];
+}
+
+regions::region_tree* get_region_tree(const paging* paging,
+                                      const void* start, size_t bytes) {
+    const bool starts_in_heaps =
+        is_heap_directory_offset(get_directory_offset(start));
+    const bool ends_in_heaps = is_heap_directory_offset(get_directory_offset(
+        static_cast<const std::byte*>(start) + bytes - 1));
+    if (starts_in_heaps != ends_in_heaps) {
+        return nullptr;
+    }
+
+    return starts_in_heaps ? paging->kernel_regions : paging->regions;
+}
+
+with_error<const void*> get_physical_address(const paging* paging,
+                                             const void* virtual_address) {
+    const size_t address = reinterpret_cast<size_t>(virtual_address);
+    const size_t directory_offset = get_directory_offset(virtual_address);
+    const directory::Entry pde = get_directory(paging)[directory_offset];
+    if (directory_offset == SELF_MAP_OFFSET || !directory::is_present(pde)) {
+        return {nullptr, errors::make(WITH_LOCATION("page is not mapped"))};
+    }
+
+    if (directory::is_large(pde)) {
+        return {static_cast<const std::byte*>(
+                    directory::get_large_page_address(pde)) +
+                    address % LARGE_PAGE_SIZE_IN_BYTES,
+                errors::nil()};
+    }
+
+    const table::Entry pte =
+        get_table(paging, directory_offset)[get_table_offset(virtual_address)];
+    if (!table::is_present(pte)) {
+        return {nullptr, errors::make(WITH_LOCATION("page is not mapped"))};
+    }
+
+    return {static_cast<const std::byte*>(table::get_page_address(pte)) +
+                address % PAGE_SIZE_IN_BYTES,
+            errors::nil()};
+}
+
+bool is_mapped(const paging* paging, const void* virtual_address) {
+    const size_t directory_offset = get_directory_offset(virtual_address);
+    if (directory_offset == SELF_MAP_OFFSET) {
+        return false;
+    }
+
+    const directory::Entry pde = get_directory(paging)[directory_offset];
+    if (!directory::is_present(pde)) {
+        return false;
+    }
+
+    if (directory::is_large(pde)) {
+        return true;
+    }
+
+    return table::is_present(
+        get_table(paging, directory_offset)[get_table_offset(virtual_address)]);
+}
+
 void enable() {
     enable_paging();
+    enabled = true;
 }
 
 void disable() {
     disable_paging();
+    enabled = false;
+}
+
+bool supports_large_pages() {
+    return utilities::has_feature(utilities::Feature::PAGE_SIZE_EXTENSION);
+}
+
+void enable_large() {
+    enable_large_pages();
+}
+
+bool supports_global_pages() {
+    return utilities::has_feature(utilities::Feature::PAGE_GLOBAL_ENABLE);
+}
+
+void enable_global() {
+    enable_global_pages();
 }
 
 void load(const paging instance) {
+    loaded = instance;
     load_page_directory(instance.directory);
 }
 
+paging* get_loaded() {
+    return loaded.directory != nullptr ? &loaded : nullptr;
+}
+
 }  // namespace memory::paging
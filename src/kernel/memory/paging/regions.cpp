@@ -0,0 +1,153 @@
+#include "memory/paging/regions.hpp"
+
+#include "memory/allocation/alignment.hpp"
+#include "utilities/macros.hpp"
+
+namespace memory::paging::regions {
+
+namespace rbtree = utilities::rbtree;
+
+[[nodiscard]] static region* from_node(rbtree::node* node);
+[[nodiscard]] static const std::byte* get_end(const region* region);
+
+region_tree make_region_tree(allocator* allocator) {
+    return region_tree{
+        ._regions = rbtree::make_tree(),
+        ._allocator = allocator,
+    };
+}
+
+error destroy(region_tree* tree) {
+    error first = errors::nil();
+
+    while (tree->_regions.root != nullptr) {
+        const error temp = erase(tree, from_node(tree->_regions.root));
+        if (errors::set(temp) && !errors::set(first)) {
+            first = temp;
+        }
+    }
+
+    return first;
+}
+
+with_error<region*> insert(region_tree* tree, const region& description) {
+    if (description.bytes == 0) {
+        return {nullptr, errors::make(WITH_LOCATION("region is empty"))};
+    }
+
+    const std::byte* const start = description.start;
+    const std::byte* const end = start + description.bytes;
+
+    // The regions next to the new one are on the path to its link, so
+    // checking the path finds any overlap.
+    rbtree::node* parent = nullptr;
+    rbtree::node** link = &tree->_regions.root;
+
+    while (*link != nullptr) {
+        parent = *link;
+        const region* const current = from_node(parent);
+
+        if (start < get_end(current) && current->start < end) {
+            return {nullptr,
+                    errors::make(WITH_LOCATION("region overlaps another"))};
+        }
+
+        link = start < current->start ? &parent->left : &parent->right;
+    }
+
+    auto [allocation, allocation_error] =
+        try_malloc(tree->_allocator, sizeof(region));
+    if (errors::set(allocation_error)) {
+        errors::enrich(&allocation_error, "allocate region descriptor");
+        return {nullptr, allocation_error};
+    }
+
+    region* const inserted = static_cast<region*>(allocation);
+    *inserted = description;
+    rbtree::insert(&tree->_regions, &inserted->node, parent, link);
+
+    return {inserted, errors::nil()};
+}
+
+error erase(region_tree* tree, region* removed) {
+    rbtree::erase(&tree->_regions, &removed->node);
+
+    return try_free(tree->_allocator, removed, sizeof(region));
+}
+
+region* find(const region_tree* tree, const void* address) {
+    const std::byte* const address_ = static_cast<const std::byte*>(address);
+
+    rbtree::node* node = tree->_regions.root;
+    while (node != nullptr) {
+        region* const current = from_node(node);
+        if (address_ < current->start) {
+            node = node->left;
+        } else if (address_ >= get_end(current)) {
+            node = node->right;
+        } else {
+            return current;
+        }
+    }
+
+    return nullptr;
+}
+
+region* first(const region_tree* tree) {
+    rbtree::node* const node = rbtree::first(&tree->_regions);
+    return node != nullptr ? from_node(node) : nullptr;
+}
+
+region* next(const region* region) {
+    rbtree::node* const node = rbtree::next(&region->node);
+    return node != nullptr ? from_node(node) : nullptr;
+}
+
+bool owns_frames(const region* region) {
+    return region->type == Type::ANONYMOUS || region->type == Type::FILE;
+}
+
+with_error<const std::byte*> find_free(const region_tree* tree,
+                                       const void* lower, const void* upper,
+                                       size_t bytes, size_t alignment) {
+    const size_t end = reinterpret_cast<size_t>(upper);
+    size_t candidate = ::memory::allocation::align_up(
+        reinterpret_cast<size_t>(lower), alignment);
+
+    // Regions are visited by address, and the candidate moves past each one
+    // it overlaps. The first gap the range fits in wins.
+    for (rbtree::node* node = rbtree::first(&tree->_regions);
+         node != nullptr && candidate <= end && bytes <= end - candidate;
+         node = rbtree::next(node)) {
+        const region* const current = from_node(node);
+        const size_t current_start = reinterpret_cast<size_t>(current->start);
+        const size_t current_end = reinterpret_cast<size_t>(get_end(current));
+
+        if (current_end <= candidate) {
+            continue;
+        }
+
+        if (current_start >= candidate && current_start - candidate >= bytes) {
+            break;
+        }
+
+        candidate = ::memory::allocation::align_up(current_end, alignment);
+    }
+
+    if (candidate > end || bytes > end - candidate) {
+        return {nullptr,
+                errors::make(WITH_LOCATION("no free range in window"))};
+    }
+
+    return {reinterpret_cast<const std::byte*>(candidate), errors::nil()};
+}
+
+region* from_node(rbtree::node* node) {
+    return CONTAINER_OF(node, region, node);
+}
+
+const std::byte* get_end(const region* region) {
+    return region->start + region->bytes;
+}
+
+}  // namespace memory::paging::regions
@@ -0,0 +1,305 @@
+#include "memory/paging/swap.hpp"
+
+#include <cstring>
+
+#include "memory/physical/references.hpp"
+
+namespace memory::paging::swap {
+
+namespace ata = drivers::storage::ata;
+
+constexpr size_t SECTORS_PER_SLOT =
+    PAGE_SIZE_IN_BYTES / ata::SECTOR_SIZE_IN_BYTES;
+constexpr uint8_t MAX_SLOT_REFERENCES = 0xff;
+
+// Where the CLOCK hand stopped, and the region it is in.
+struct position {
+    const regions::region* region;
+    const std::byte* page;
+};
+
+[[nodiscard]] static position advance_hand(paging* paging);
+[[nodiscard]] static const regions::region* find_next_region(
+    const paging* paging, const std::byte* address);
+[[nodiscard]] static const regions::region* find_next_in_tree(
+    const regions::region_tree* tree, const std::byte* address,
+    const regions::region** first);
+[[nodiscard]] static size_t count_resident(const regions::region_tree* tree);
+[[nodiscard]] static bool evict(paging* paging, const regions::region* region,
+                                const std::byte* page, table::Entry* pte);
+[[nodiscard]] static with_error<size_t> allocate_slot();
+static void release_slot(size_t slot);
+[[nodiscard]] static size_t get_slot_sector(size_t slot);
+
+static ata::disk swap_disk{};
+static size_t swap_first_sector = 0;
+// The amount of entries that refer to each slot. Free slots have none.
+static uint8_t* slot_references = nullptr;
+static size_t slot_count = 0;
+// Slots are searched for from where the last one was found.
+static size_t next_slot = 0;
+static const std::byte* hand = nullptr;
+static statistics counts{};
+
+error init(const ata::disk& disk, size_t first_sector, size_t slots,
+           allocator* allocator) {
+    auto [allocation, allocation_error] = try_malloc(allocator, slots);
+    if (errors::set(allocation_error)) {
+        errors::enrich(&allocation_error, "allocate slot table");
+        return allocation_error;
+    }
+
+    slot_references = static_cast<uint8_t*>(allocation);
+    std::memset(slot_references, 0, slots);
+    slot_count = slots;
+    swap_disk = disk;
+    swap_first_sector = first_sector;
+
+    return errors::nil();
+}
+
+size_t reclaim(paging* paging, size_t pages) {
+    const size_t resident = count_resident(paging->regions) +
+                            count_resident(paging->kernel_regions);
+
+    // The first sweep may only clear accessed bits, so the hand may have to
+    // go around twice.
+    size_t reclaimed = 0;
+    for (size_t step = 0; step < 2 * resident && reclaimed < pages; step++) {
+        const position position = advance_hand(paging);
+        if (position.region == nullptr) {
+            break;
+        }
+
+        table::Entry* const pte = get_entry(paging, position.page);
+        if (pte == nullptr || !table::is_present(*pte)) {
+            continue;
+        }
+
+        if (table::was_accessed(*pte)) {
+            table::reset_accessed(pte);
+            invalidate(paging, position.page, 1);
+            continue;
+        }
+
+        if (evict(paging, position.region, position.page, pte)) {
+            reclaimed++;
+        }
+    }
+
+    return reclaimed;
+}
+
+error swap_in(paging* paging, const regions::region* region,
+              const std::byte* page, void* frame) {
+    const table::Entry* const pte = get_entry(paging, page);
+    if (pte == nullptr || !table::is_swapped(*pte)) {
+        return errors::make(WITH_LOCATION("page is not swapped"));
+    }
+
+    // The page stays swapped if its slot can't be read, so the access can
+    // be retried.
+    const size_t slot = table::get_swap_slot(*pte);
+    error read_error =
+        ata::read_sectors(&swap_disk, static_cast<ata::sector*>(frame),
+                          get_slot_sector(slot), SECTORS_PER_SLOT);
+    if (errors::set(read_error)) {
+        errors::enrich(&read_error, "read swap slot");
+        return read_error;
+    }
+
+    error map_error = map(paging, page, frame, region->page_flags);
+    if (errors::set(map_error)) {
+        errors::enrich(&map_error, "map swapped page");
+        return map_error;
+    }
+
+    // The slot is given up, so the page has to be written again if it is
+    // evicted, even if it isn't written to until then.
+    table::mark_dirty(get_entry(paging, page));
+    release_slot(slot);
+    counts.swapped_in++;
+
+    return errors::nil();
+}
+
+void discard(paging* paging, const std::byte* page) {
+    table::Entry* const pte = get_entry(paging, page);
+    if (pte == nullptr || !table::is_swapped(*pte)) {
+        return;
+    }
+
+    release_slot(table::get_swap_slot(*pte));
+    *pte = 0;
+}
+
+statistics get_statistics() {
+    return counts;
+}
+
+error share_slot(size_t slot) {
+    if (slot >= slot_count || slot_references[slot] == 0) {
+        return errors::make(WITH_LOCATION("slot is not in use"));
+    }
+
+    if (slot_references[slot] == MAX_SLOT_REFERENCES) {
+        return errors::make(WITH_LOCATION("slot has too many references"));
+    }
+
+    slot_references[slot]++;
+
+    return errors::nil();
+}
+
+position advance_hand(paging* paging) {
+    const regions::region* region =
+        hand != nullptr
+            ? regions::find(get_region_tree(paging, hand, 1), hand)
+            : nullptr;
+
+    // The hand moved past the end of its region, or its region was removed.
+    if (region == nullptr || !regions::owns_frames(region)) {
+        region = find_next_region(paging, hand);
+        if (region == nullptr) {
+            return {nullptr, nullptr};
+        }
+
+        hand = region->start;
+    }
+
+    const std::byte* const page = hand;
+    hand += PAGE_SIZE_IN_BYTES;
+
+    return {region, page};
+}
+
+const regions::region* find_next_region(const paging* paging,
+                                        const std::byte* address) {
+    // The regions of the heaps are in a tree of their own, so the next
+    // region is the lower of the next ones in both trees.
+    const regions::region* first = nullptr;
+    const regions::region* kernel_first = nullptr;
+    const regions::region* const next =
+        find_next_in_tree(paging->regions, address, &first);
+    const regions::region* const kernel_next =
+        find_next_in_tree(paging->kernel_regions, address, &kernel_first);
+
+    if (next != nullptr || kernel_next != nullptr) {
+        return next == nullptr || (kernel_next != nullptr &&
+                                   kernel_next->start < next->start)
+                   ? kernel_next
+                   : next;
+    }
+
+    // Wrap around to the start of the address space.
+    return first == nullptr || (kernel_first != nullptr &&
+                                kernel_first->start < first->start)
+               ? kernel_first
+               : first;
+}
+
+const regions::region* find_next_in_tree(const regions::region_tree* tree,
+                                         const std::byte* address,
+                                         const regions::region** first) {
+    if (tree == nullptr) {
+        return nullptr;
+    }
+
+    for (const regions::region* region = regions::first(tree);
+         region != nullptr; region = regions::next(region)) {
+        if (!regions::owns_frames(region)) {
+            continue;
+        }
+
+        if (region->start >= address) {
+            return region;
+        }
+
+        if (*first == nullptr) {
+            *first = region;
+        }
+    }
+
+    return nullptr;
+}
+
+size_t count_resident(const regions::region_tree* tree) {
+    if (tree == nullptr) {
+        return 0;
+    }
+
+    size_t resident = 0;
+    for (const regions::region* region = regions::first(tree);
+         region != nullptr; region = regions::next(region)) {
+        if (regions::owns_frames(region)) {
+            resident += region->bytes / PAGE_SIZE_IN_BYTES;
+        }
+    }
+
+    return resident;
+}
+
+bool evict(paging* paging, const regions::region* region,
+           const std::byte* page, table::Entry* pte) {
+    const void* const frame = table::get_page_address(*pte);
+    if (physical::get_references(frame) > 1) {
+        return false;
+    }
+
+    // Clean pages fault back in with the same contents - zeros or the
+    // sectors of their file.
+    table::Entry evicted = 0;
+    if (table::is_dirty(*pte)) {
+        auto [slot, slot_error] = allocate_slot();
+        if (errors::set(slot_error)) {
+            return false;
+        }
+
+        // The page is kept if its contents couldn't be saved.
+        error write_error = ata::write_sectors(
+            &swap_disk, static_cast<const ata::sector*>(frame),
+            get_slot_sector(slot), SECTORS_PER_SLOT);
+        if (errors::set(write_error)) {
+            release_slot(slot);
+            errors::enrich(&write_error, "write swap slot");
+            errors::log(write_error);
+            return false;
+        }
+
+        evicted = table::make_swapped_entry(slot);
+        counts.swapped_out++;
+    }
+
+    *pte = evicted;
+    invalidate(paging, page, 1);
+    counts.evicted++;
+
+    const error free_error =
+        try_free(region->frames, frame, PAGE_SIZE_IN_BYTES);
+    return !errors::set(free_error);
+}
+
+with_error<size_t> allocate_slot() {
+    for (size_t i = 0; i < slot_count; i++) {
+        const size_t slot = (next_slot + i) % slot_count;
+        if (slot_references[slot] == 0) {
+            slot_references[slot] = 1;
+            next_slot = slot + 1;
+            return {slot, errors::nil()};
+        }
+    }
+
+    return {0, errors::make(WITH_LOCATION("swap is full"))};
+}
+
+void release_slot(size_t slot) {
+    if (slot < slot_count && slot_references[slot] > 0) {
+        slot_references[slot]--;
+    }
+}
+
+size_t get_slot_sector(size_t slot) {
+    return swap_first_sector + slot * SECTORS_PER_SLOT;
+}
+
+}  // namespace memory::paging::swap
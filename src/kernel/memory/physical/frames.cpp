@@ -0,0 +1,104 @@
+#include "memory/physical/frames.hpp"
+
+#include "memory/layout.hpp"
+
+namespace memory::physical {
+
+namespace bitmap_heap = allocation::bitmap_heap;
+
+constexpr size_t BITMAPS = 3;
+
+[[nodiscard]] static uint64_t get_end(const memory_map_entry &entry);
+[[nodiscard]] static size_t get_frame(uint64_t address);
+[[nodiscard]] static size_t get_frame_round_up(uint64_t address);
+
+with_error<bitmap_heap::bitmap_heap> make_frames(
+    const memory_map &map, bitmap_heap::bitmap_word *metadata,
+    size_t metadata_words) {
+    uint64_t top = 0;
+    for (size_t i = 0; i < map.count; i++) {
+        const memory_map_entry &entry = map.entries[i];
+        if (is_usable(entry) && entry.base < PHYSICAL_MEMORY_LIMIT &&
+            get_end(entry) > top) {
+            top = get_end(entry);
+        }
+    }
+
+    size_t frames = get_frame(top);
+    const size_t max_frames =
+        metadata_words / BITMAPS * bitmap_heap::BITS_PER_WORD;
+    if (frames > max_frames) {
+        frames = max_frames;
+    }
+
+    if (frames == 0) {
+        return {{}, errors::make(WITH_LOCATION("no usable memory found"))};
+    }
+
+    bitmap_heap::bitmap_heap heap =
+        bitmap_heap::make_bitmap_heap(nullptr, metadata, FRAME_SIZE, frames);
+
+    // Start with everything reserved, since the map may have holes. Usable
+    // memory is freed first and other regions reserved after it, so regions
+    // that overlap usable memory win.
+    bitmap_heap::reserve(&heap, 0, frames);
+
+    for (size_t i = 0; i < map.count; i++) {
+        const memory_map_entry &entry = map.entries[i];
+        if (!is_usable(entry)) {
+            continue;
+        }
+
+        // Only whole frames inside the entry are usable.
+        const size_t first = get_frame_round_up(entry.base);
+        const size_t last = get_frame(get_end(entry));
+        if (first < last) {
+            bitmap_heap::unreserve(&heap, first, last - first);
+        }
+    }
+
+    for (size_t i = 0; i < map.count; i++) {
+        const memory_map_entry &entry = map.entries[i];
+        if (is_usable(entry) ||
+            (entry.extended_attributes & EXTENDED_ATTRIBUTE_VALID) == 0) {
+            continue;
+        }
+
+        reserve_range(&heap, entry.base, entry.length);
+    }
+
+    // The BIOS data, the memory map, the frame table, the kernel and its
+    // stack.
+    reserve_range(&heap, 0, static_cast<uint64_t>(Layout::KERNEL_STACK));
+
+    return {heap, errors::nil()};
+}
+
+void reserve_range(bitmap_heap::bitmap_heap *frames, uint64_t start,
+                   uint64_t bytes) {
+    const size_t first = get_frame(start);
+    const size_t last = get_frame_round_up(start + bytes);
+
+    if (first < last) {
+        bitmap_heap::reserve(frames, first, last - first);
+    }
+}
+
+uint64_t get_end(const memory_map_entry &entry) {
+    const uint64_t end = entry.base + entry.length;
+    return end < PHYSICAL_MEMORY_LIMIT ? end : PHYSICAL_MEMORY_LIMIT;
+}
+
+size_t get_frame(uint64_t address) {
+    if (address > PHYSICAL_MEMORY_LIMIT) {
+        address = PHYSICAL_MEMORY_LIMIT;
+    }
+
+    return static_cast<size_t>(address >> paging::PAGE_SIZE_BITS);
+}
+
+size_t get_frame_round_up(uint64_t address) {
+    return get_frame(address + FRAME_SIZE - 1);
+}
+
+}  // namespace memory::physical
@@ -0,0 +1,42 @@
+#include "memory/physical/memory_map.hpp"
+
+#include "memory/layout.hpp"
+
+namespace memory::physical {
+
+constexpr size_t KILOBYTE_BITS = 10;
+
+// The layout the bootloader stores the memory map in.
+struct __attribute__((packed)) boot_memory_map {
+    uint32_t count;
+    memory_map_entry entries[];
+};
+
+memory_map get_memory_map() {
+    const boot_memory_map *const boot_map =
+        reinterpret_cast<const boot_memory_map *>(Layout::MEMORY_MAP);
+
+    return memory_map{
+        .count = boot_map->count,
+        .entries = boot_map->entries,
+    };
+}
+
+bool is_usable(const memory_map_entry &entry) {
+    return entry.type == RegionType::USABLE &&
+           (entry.extended_attributes & EXTENDED_ATTRIBUTE_VALID) != 0;
+}
+
+size_t get_usable_kilobytes(const memory_map &map) {
+    uint64_t total = 0;
+
+    for (size_t i = 0; i < map.count; i++) {
+        if (is_usable(map.entries[i])) {
+            total += map.entries[i].length;
+        }
+    }
+
+    return static_cast<size_t>(total >> KILOBYTE_BITS);
+}
+
+}  // namespace memory::physical
@@ -0,0 +1,83 @@
+#include "memory/physical/references.hpp"
+
+#include <cstring>
+
+#include "memory/physical/frames.hpp"
+
+namespace memory::physical {
+
+using count = uint16_t;
+
+constexpr count MAX_REFERENCES = 0xffff;
+
+[[nodiscard]] static count* get_count(const void* frame);
+
+// A count of 0 means the frame has a single owner, so frames that were never
+// shared don't need their count set when they are allocated.
+static count* counts = nullptr;
+static size_t counted_frames = 0;
+
+error init_references(allocator* allocator, size_t frames) {
+    auto [allocation, allocation_error] =
+        try_malloc(allocator, frames * sizeof(count));
+    if (errors::set(allocation_error)) {
+        errors::enrich(&allocation_error, "allocate frame references");
+        return allocation_error;
+    }
+
+    counts = static_cast<count*>(allocation);
+    counted_frames = frames;
+    std::memset(counts, 0, frames * sizeof(count));
+
+    return errors::nil();
+}
+
+bool has_references() {
+    return counts != nullptr;
+}
+
+error share_frame(const void* frame) {
+    count* const references = get_count(frame);
+    if (references == nullptr) {
+        return errors::make(WITH_LOCATION("frame has no reference count"));
+    }
+
+    if (*references == MAX_REFERENCES) {
+        return errors::make(WITH_LOCATION("frame has too many references"));
+    }
+
+    *references = *references == 0 ? 2 : *references + 1;
+
+    return errors::nil();
+}
+
+bool release_frame(const void* frame) {
+    count* const references = get_count(frame);
+    if (references == nullptr || *references == 0) {
+        return true;
+    }
+
+    *references = *references == 2 ? 0 : *references - 1;
+
+    return false;
+}
+
+size_t get_references(const void* frame) {
+    const count* const references = get_count(frame);
+    if (references == nullptr || *references == 0) {
+        return 1;
+    }
+
+    return *references;
+}
+
+count* get_count(const void* frame) {
+    const size_t index = reinterpret_cast<size_t>(frame) / FRAME_SIZE;
+    if (counts == nullptr || index >= counted_frames) {
+        return nullptr;
+    }
+
+    return &counts[index];
+}
+
+}  // namespace memory::physical
@@ -0,0 +1,28 @@
+#include "utilities/arithmetic.hpp"
+
+namespace utilities {
+
+constexpr unsigned BITS = 64;
+
+uint64_t divide(uint64_t dividend, uint64_t divisor) {
+    if (dividend <= UINT32_MAX && divisor <= UINT32_MAX) {
+        return static_cast<uint32_t>(dividend) /
+               static_cast<uint32_t>(divisor);
+    }
+
+    uint64_t quotient = 0;
+    uint64_t remainder = 0;
+
+    // Long division, one bit of the dividend at a time.
+    for (unsigned bit = BITS; bit-- > 0;) {
+        remainder = (remainder << 1) | ((dividend >> bit) & 1);
+        if (remainder >= divisor) {
+            remainder -= divisor;
+            quotient |= uint64_t{1} << bit;
+        }
+    }
+
+    return quotient;
+}
+
+}  // namespace utilities
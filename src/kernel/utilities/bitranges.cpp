@@ -14,6 +14,10 @@ uint32_t clear_flag(uint32_t value, size_t offset) {
     return value & ~(1 << offset);
 }
 
+uint32_t set_flag(uint32_t value, size_t offset, bool flag) {
+    return flag ? set_flag(value, offset) : clear_flag(value, offset);
+}
+
 uint32_t get_field(uint32_t value, size_t msb, size_t lsb) {
     return (value >> lsb) & ((1 << (msb - lsb + 1)) - 1);
 }
@@ -24,4 +28,14 @@ uint32_t set_field(uint32_t value, size_t msb, size_t lsb,
     return (value & ~mask) | ((field_value << lsb) & mask);
 }
 
+size_t count_trailing_zeros(uint32_t value) {
+    // Compiles to a single bsf instruction.
+    return __builtin_ctz(value);
+}
+
+size_t count_leading_zeros(uint32_t value) {
+    // Compiles to a single bsr instruction.
+    return __builtin_clz(value);
+}
+
 }  // namespace utilities
@@ -0,0 +1,71 @@
+#include "utilities/format.hpp"
+
+#include <cstring>
+
+#include "utilities/arithmetic.hpp"
+
+namespace utilities {
+
+// Enough for 4294967295 and a null terminator.
+constexpr size_t MAX_DECIMAL_LENGTH = 11;
+// Enough for 18446744073709551615 and a null terminator.
+constexpr size_t MAX_DECIMAL64_LENGTH = 21;
+constexpr size_t HEX_DIGITS = 8;
+
+void append(char *buffer, size_t size, const char *string) {
+    size_t length = std::strlen(buffer);
+
+    while (*string != '\0' && length + 1 < size) {
+        buffer[length] = *string;
+        length++;
+        string++;
+    }
+
+    buffer[length] = '\0';
+}
+
+void append_decimal(char *buffer, size_t size, uint32_t value) {
+    char digits[MAX_DECIMAL_LENGTH];
+    size_t index = MAX_DECIMAL_LENGTH - 1;
+    digits[index] = '\0';
+
+    // Fill the digits from the least significant one.
+    do {
+        index--;
+        digits[index] = '0' + value % 10;
+        value /= 10;
+    } while (value != 0);
+
+    append(buffer, size, digits + index);
+}
+
+void append_decimal64(char *buffer, size_t size, uint64_t value) {
+    char digits[MAX_DECIMAL64_LENGTH];
+    size_t index = MAX_DECIMAL64_LENGTH - 1;
+    digits[index] = '\0';
+
+    // Fill the digits from the least significant one.
+    do {
+        const uint64_t quotient = divide(value, 10);
+        index--;
+        digits[index] = '0' + static_cast<char>(value - quotient * 10);
+        value = quotient;
+    } while (value != 0);
+
+    append(buffer, size, digits + index);
+}
+
+void append_hex(char *buffer, size_t size, uint32_t value) {
+    char digits[HEX_DIGITS + 1];
+
+    for (size_t i = 0; i < HEX_DIGITS; i++) {
+        const uint32_t digit = (value >> (4 * (HEX_DIGITS - 1 - i))) & 0xf;
+        digits[i] = digit < 10 ? '0' + digit : 'a' + digit - 10;
+    }
+    digits[HEX_DIGITS] = '\0';
+
+    append(buffer, size, "0x");
+    append(buffer, size, digits);
+}
+
+}  // namespace utilities
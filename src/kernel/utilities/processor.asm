@@ -0,0 +1,15 @@
+[BITS 32]
+
+section .asm
+
+global read_feature_flags
+
+; Get the feature flags of the processor, which CPUID reports in edx for
+; leaf 1. CPUID also clobbers ebx, which the caller expects to be preserved.
+read_feature_flags:
+    push ebx
+    mov eax, 1
+    cpuid
+    mov eax, edx
+    pop ebx
+    ret
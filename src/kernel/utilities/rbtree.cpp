@@ -0,0 +1,282 @@
+#include "utilities/rbtree.hpp"
+
+namespace utilities::rbtree {
+
+static void rotate_left(tree* tree, node* pivot);
+static void rotate_right(tree* tree, node* pivot);
+static void replace_child(tree* tree, node* parent, node* old_child,
+                          node* new_child);
+static void transplant(tree* tree, node* old_node, node* new_node);
+static void insert_fixup(tree* tree, node* node);
+static void erase_fixup(tree* tree, node* child, node* parent);
+[[nodiscard]] static bool is_red(const node* node);
+[[nodiscard]] static node* leftmost(node* node);
+[[nodiscard]] static node* rightmost(node* node);
+
+tree make_tree() {
+    return tree{.root = nullptr};
+}
+
+void insert(tree* tree, node* inserted, node* parent, node** link) {
+    inserted->parent = parent;
+    inserted->left = nullptr;
+    inserted->right = nullptr;
+    inserted->red = true;
+    *link = inserted;
+
+    insert_fixup(tree, inserted);
+}
+
+void erase(tree* tree, node* removed) {
+    // See "Introduction to Algorithms", chapter 13.4. Null children take the
+    // place of the sentinel, so the parent of the node that replaces the
+    // removed one is tracked separately.
+    node* child = nullptr;
+    node* parent = nullptr;
+    bool removed_red = removed->red;
+
+    if (removed->left == nullptr || removed->right == nullptr) {
+        child = removed->left != nullptr ? removed->left : removed->right;
+        parent = removed->parent;
+        transplant(tree, removed, child);
+    } else {
+        node* const successor = leftmost(removed->right);
+        removed_red = successor->red;
+        child = successor->right;
+
+        if (successor->parent == removed) {
+            parent = successor;
+        } else {
+            parent = successor->parent;
+            transplant(tree, successor, successor->right);
+            successor->right = removed->right;
+            successor->right->parent = successor;
+        }
+
+        transplant(tree, removed, successor);
+        successor->left = removed->left;
+        successor->left->parent = successor;
+        successor->red = removed->red;
+    }
+
+    if (!removed_red) {
+        erase_fixup(tree, child, parent);
+    }
+}
+
+node* first(const tree* tree) {
+    return tree->root == nullptr ? nullptr : leftmost(tree->root);
+}
+
+node* last(const tree* tree) {
+    return tree->root == nullptr ? nullptr : rightmost(tree->root);
+}
+
+node* next(const node* node) {
+    if (node->right != nullptr) {
+        return leftmost(node->right);
+    }
+
+    while (node->parent != nullptr && node == node->parent->right) {
+        node = node->parent;
+    }
+
+    return node->parent;
+}
+
+node* previous(const node* node) {
+    if (node->left != nullptr) {
+        return rightmost(node->left);
+    }
+
+    while (node->parent != nullptr && node == node->parent->left) {
+        node = node->parent;
+    }
+
+    return node->parent;
+}
+
+void rotate_left(tree* tree, node* pivot) {
+    node* const child = pivot->right;
+
+    pivot->right = child->left;
+    if (child->left != nullptr) {
+        child->left->parent = pivot;
+    }
+
+    child->parent = pivot->parent;
+    replace_child(tree, pivot->parent, pivot, child);
+
+    child->left = pivot;
+    pivot->parent = child;
+}
+
+void rotate_right(tree* tree, node* pivot) {
+    node* const child = pivot->left;
+
+    pivot->left = child->right;
+    if (child->right != nullptr) {
+        child->right->parent = pivot;
+    }
+
+    child->parent = pivot->parent;
+    replace_child(tree, pivot->parent, pivot, child);
+
+    child->right = pivot;
+    pivot->parent = child;
+}
+
+void replace_child(tree* tree, node* parent, node* old_child,
+                   node* new_child) {
+    if (parent == nullptr) {
+        tree->root = new_child;
+    } else if (parent->left == old_child) {
+        parent->left = new_child;
+    } else {
+        parent->right = new_child;
+    }
+}
+
+void transplant(tree* tree, node* old_node, node* new_node) {
+    replace_child(tree, old_node->parent, old_node, new_node);
+    if (new_node != nullptr) {
+        new_node->parent = old_node->parent;
+    }
+}
+
+void insert_fixup(tree* tree, node* node) {
+    struct node* parent = nullptr;
+
+    while ((parent = node->parent) != nullptr && parent->red) {
+        // The root is always black, so a red parent has a parent of its own.
+        struct node* const grandparent = parent->parent;
+
+        if (parent == grandparent->left) {
+            struct node* const uncle = grandparent->right;
+            if (is_red(uncle)) {
+                parent->red = false;
+                uncle->red = false;
+                grandparent->red = true;
+                node = grandparent;
+                continue;
+            }
+
+            if (node == parent->right) {
+                rotate_left(tree, parent);
+                node = parent;
+                parent = node->parent;
+            }
+
+            parent->red = false;
+            grandparent->red = true;
+            rotate_right(tree, grandparent);
+        } else {
+            struct node* const uncle = grandparent->left;
+            if (is_red(uncle)) {
+                parent->red = false;
+                uncle->red = false;
+                grandparent->red = true;
+                node = grandparent;
+                continue;
+            }
+
+            if (node == parent->left) {
+                rotate_right(tree, parent);
+                node = parent;
+                parent = node->parent;
+            }
+
+            parent->red = false;
+            grandparent->red = true;
+            rotate_left(tree, grandparent);
+        }
+    }
+
+    tree->root->red = false;
+}
+
+void erase_fixup(tree* tree, node* child, node* parent) {
+    while (child != tree->root && !is_red(child)) {
+        if (child == parent->left) {
+            node* sibling = parent->right;
+            if (is_red(sibling)) {
+                sibling->red = false;
+                parent->red = true;
+                rotate_left(tree, parent);
+                sibling = parent->right;
+            }
+
+            if (!is_red(sibling->left) && !is_red(sibling->right)) {
+                sibling->red = true;
+                child = parent;
+                parent = child->parent;
+                continue;
+            }
+
+            if (!is_red(sibling->right)) {
+                sibling->left->red = false;
+                sibling->red = true;
+                rotate_right(tree, sibling);
+                sibling = parent->right;
+            }
+
+            sibling->red = parent->red;
+            parent->red = false;
+            sibling->right->red = false;
+            rotate_left(tree, parent);
+        } else {
+            node* sibling = parent->left;
+            if (is_red(sibling)) {
+                sibling->red = false;
+                parent->red = true;
+                rotate_right(tree, parent);
+                sibling = parent->left;
+            }
+
+            if (!is_red(sibling->left) && !is_red(sibling->right)) {
+                sibling->red = true;
+                child = parent;
+                parent = child->parent;
+                continue;
+            }
+
+            if (!is_red(sibling->left)) {
+                sibling->right->red = false;
+                sibling->red = true;
+                rotate_left(tree, sibling);
+                sibling = parent->left;
+            }
+
+            sibling->red = parent->red;
+            parent->red = false;
+            sibling->left->red = false;
+            rotate_right(tree, parent);
+        }
+
+        child = tree->root;
+    }
+
+    if (child != nullptr) {
+        child->red = false;
+    }
+}
+
+bool is_red(const node* node) {
+    return node != nullptr && node->red;
+}
+
+node* leftmost(node* node) {
+    while (node->left != nullptr) {
+        node = node->left;
+    }
+    return node;
+}
+
+node* rightmost(node* node) {
+    while (node->right != nullptr) {
+        node = node->right;
+    }
+    return node;
+}
+
+}  // namespace utilities::rbtree
@@ -0,0 +1,11 @@
+[BITS 32]
+
+section .asm
+
+global read_timestamp_counter
+
+; Read the processor's time stamp counter, which counts clock cycles since
+; reset. The 64 bit result is returned in edx:eax.
+read_timestamp_counter:
+    rdtsc
+    ret
@@ -20,6 +20,25 @@ echo "section .asm
 " > ${TARGET_PATH}
 
 for interrupt in "${interrupts[@]}"; do
+    # Exceptions with an error code push it below the return address. The C
+    # function gets it as an argument, and it's popped before returning.
+    if [[ "${interrupt}" == *_error_code ]]; then
+        routine="${interrupt%_error_code}"
+        echo "global ${interrupt}_wrapper
+extern ${routine}
+${interrupt}_wrapper:
+    pushad
+    cld
+    push dword [esp + 32]
+    call ${routine}
+    add esp, 4
+    popad
+    add esp, 4
+    iret
+" >> ${TARGET_PATH}
+        continue
+    fi
+
     echo "global ${interrupt}_wrapper
 extern ${interrupt}
 ${interrupt}_wrapper: